@@ -28,10 +28,19 @@ static void glEnableDisableClientState(GLenum array, GLboolean enable)
             vad->point_size_array_enabled = enable;
             vad->point_size_array_dirty = GL_TRUE;
             break;
+#ifdef GL_OES_matrix_palette
+        case GL_MATRIX_INDEX_ARRAY_OES:
+            vad->matrix_index_array_enabled = enable;
+            break;
+        case GL_WEIGHT_ARRAY_OES:
+            vad->weight_array_enabled = enable;
+            break;
+#endif
         default:
             gliSetError(GL_INVALID_ENUM);
-            break;
+            return;
     }
+    vad->attrib_serial++;
 }
 
 GL_API void GL_APIENTRY glEnableClientState(GLenum array)
@@ -49,32 +58,32 @@ GL_API void GL_APIENTRY glVertexPointer(GLint size, GLenum type, GLsizei stride,
     gli_context_t *context = gliGetContext();
     vertex_array_data_t *vad = &context->vertex_array_data;
 
-    if (stride < 0) {
+    if (GLI_INVALID(stride < 0)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    if (type != GL_BYTE && type != GL_SHORT && type != GL_FIXED && type != GL_FLOAT) {
+    if (GLI_INVALID(type != GL_BYTE && type != GL_SHORT && type != GL_FIXED && type != GL_FLOAT)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
-    if (size < 2 || size > 4) {
+    if (GLI_INVALID(size < 2 || size > 4)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
 
-    if (vad->array_buffer_binding != 0) {
-        buffer_object_t *buffer = gliFindBufferObject(vad->array_buffer_binding, NULL);
-        assert(buffer != NULL);
-        vad->vertex_array_buffer_binding = vad->array_buffer_binding;
-    } else {
-        vad->vertex_array_buffer_binding = 0;
-    }
+    GLI_LINT_IF(vad->vertex_array_buffer_binding == vad->array_buffer_binding && vad->vertex_array_size == size &&
+                    vad->vertex_array_type == type && vad->vertex_array_stride == stride &&
+                    vad->vertex_array_ptr == ptr,
+                GLI_LINT_REDUNDANT_POINTER);
+    vad->vertex_array_buffer_binding = vad->array_buffer_binding;
+    vad->vertex_array_buffer = vad->array_buffer;
 
     vad->vertex_array_size = size;
     vad->vertex_array_type = type;
     vad->vertex_array_stride = stride;
     vad->vertex_array_ptr = ptr;
     vad->vertex_array_dirty = GL_TRUE;
+    vad->attrib_serial++;
 }
 
 GL_API void GL_APIENTRY glNormalPointer(GLenum type, GLsizei stride, const void *ptr)
@@ -82,29 +91,28 @@ GL_API void GL_APIENTRY glNormalPointer(GLenum type, GLsizei stride, const void
     gli_context_t *context = gliGetContext();
     vertex_array_data_t *vad = &context->vertex_array_data;
 
-    if (stride < 0) {
+    if (GLI_INVALID(stride < 0)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    if (type != GL_BYTE && type != GL_SHORT && type != GL_FIXED && type != GL_FLOAT) {
+    if (GLI_INVALID(type != GL_BYTE && type != GL_SHORT && type != GL_FIXED && type != GL_FLOAT)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
 
+    GLI_LINT_IF(vad->normal_array_buffer_binding == vad->array_buffer_binding && vad->normal_array_type == type &&
+                    vad->normal_array_stride == stride && vad->normal_array_ptr == ptr,
+                GLI_LINT_REDUNDANT_POINTER);
     // If a buffer is bound with glBindBuffer, ptr is treated as an offset and the bound buffer's data pointer is used
     // instead
-    if (vad->array_buffer_binding != 0) {
-        buffer_object_t *buffer = gliFindBufferObject(vad->array_buffer_binding, NULL);
-        assert(buffer != NULL);
-        vad->normal_array_buffer_binding = vad->array_buffer_binding;
-    } else {
-        vad->normal_array_buffer_binding = 0;
-    }
+    vad->normal_array_buffer_binding = vad->array_buffer_binding;
+    vad->normal_array_buffer = vad->array_buffer;
 
     vad->normal_array_ptr = ptr;
     vad->normal_array_type = type;
     vad->normal_array_stride = (GLuint)stride;
     vad->normal_array_dirty = GL_TRUE;
+    vad->attrib_serial++;
 }
 
 GL_API void GL_APIENTRY glColorPointer(GLint size, GLenum type, GLsizei stride, const void *ptr)
@@ -112,34 +120,33 @@ GL_API void GL_APIENTRY glColorPointer(GLint size, GLenum type, GLsizei stride,
     gli_context_t *context = gliGetContext();
     vertex_array_data_t *vad = &context->vertex_array_data;
 
-    if (stride < 0) {
+    if (GLI_INVALID(stride < 0)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    if (type != GL_UNSIGNED_BYTE && type != GL_FIXED && type != GL_FLOAT) {
+    if (GLI_INVALID(type != GL_UNSIGNED_BYTE && type != GL_FIXED && type != GL_FLOAT)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
-    if (size != 4) {
+    if (GLI_INVALID(size != 4)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
 
+    GLI_LINT_IF(vad->color_array_buffer_binding == vad->array_buffer_binding && vad->color_array_size == size &&
+                    vad->color_array_type == type && vad->color_array_stride == stride && vad->color_array_ptr == ptr,
+                GLI_LINT_REDUNDANT_POINTER);
     // If a buffer is bound with glBindBuffer, ptr is treated as an offset and the bound buffer's data pointer is used
     // instead
-    if (vad->array_buffer_binding != 0) {
-        buffer_object_t *buffer = gliFindBufferObject(vad->array_buffer_binding, NULL);
-        assert(buffer != NULL);
-        vad->color_array_buffer_binding = vad->array_buffer_binding;
-    } else {
-        vad->color_array_buffer_binding = 0;
-    }
+    vad->color_array_buffer_binding = vad->array_buffer_binding;
+    vad->color_array_buffer = vad->array_buffer;
 
     vad->color_array_size = size;
     vad->color_array_type = type;
     vad->color_array_stride = stride;
     vad->color_array_ptr = ptr;
     vad->color_array_dirty = GL_TRUE;
+    vad->attrib_serial++;
 }
 
 GL_API void GL_APIENTRY glTexCoordPointer(GLint size, GLenum type, GLsizei stride, const void *ptr)
@@ -148,37 +155,34 @@ GL_API void GL_APIENTRY glTexCoordPointer(GLint size, GLenum type, GLsizei strid
     vertex_array_data_t *vad = &context->vertex_array_data;
     const GLenum texture = vad->client_active_texture - GL_TEXTURE0;
 
-    if (size < 2 || size > 4) {
+    if (GLI_INVALID(size < 2 || size > 4)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    if (type != GL_BYTE && type != GL_SHORT && type != GL_FIXED && type != GL_FLOAT) {
+    if (GLI_INVALID(type != GL_BYTE && type != GL_SHORT && type != GL_FIXED && type != GL_FLOAT)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
-    if (stride < 0) {
+    if (GLI_INVALID(stride < 0)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
 
+    GLI_LINT_IF(vad->texcoord_array_buffer_binding[texture] == vad->array_buffer_binding &&
+                    vad->texcoord_array_size[texture] == size && vad->texcoord_array_type[texture] == type &&
+                    vad->texcoord_array_stride[texture] == stride && vad->texcoord_array_ptr[texture] == ptr,
+                GLI_LINT_REDUNDANT_POINTER);
     // If a buffer is bound with glBindBuffer, ptr is treated as an offset and the bound buffer's data pointer is used
     // instead
-    if (vad->array_buffer_binding != 0) {
-        buffer_object_t *buffer = gliFindBufferObject(vad->array_buffer_binding, NULL);
-        if (buffer == NULL) {
-            gliSetError(GL_INVALID_OPERATION);
-            return;
-        }
-        vad->texcoord_array_buffer_binding[texture] = vad->array_buffer_binding;
-    } else {
-        vad->texcoord_array_buffer_binding[texture] = 0;
-    }
+    vad->texcoord_array_buffer_binding[texture] = vad->array_buffer_binding;
+    vad->texcoord_array_buffer[texture] = vad->array_buffer;
 
     vad->texcoord_array_size[texture] = size;
     vad->texcoord_array_type[texture] = type;
     vad->texcoord_array_stride[texture] = stride;
     vad->texcoord_array_ptr[texture] = ptr;
     vad->texcoord_array_dirty[texture] = GL_TRUE;
+    vad->attrib_serial++;
 }
 
 GL_API void GL_APIENTRY glPointSizePointerOES(GLenum type, GLsizei stride, const void *pointer)
@@ -186,40 +190,201 @@ GL_API void GL_APIENTRY glPointSizePointerOES(GLenum type, GLsizei stride, const
     gli_context_t *context = gliGetContext();
     vertex_array_data_t *vad = &context->vertex_array_data;
 
-    if (type != GL_FIXED && type != GL_FLOAT) {
+    if (GLI_INVALID(type != GL_FIXED && type != GL_FLOAT)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
-    if (stride < 0) {
+    if (GLI_INVALID(stride < 0)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
 
+    GLI_LINT_IF(vad->point_size_array_buffer_binding == vad->array_buffer_binding &&
+                    vad->point_size_array_type == type && vad->point_size_array_stride == stride &&
+                    vad->point_size_array_ptr == pointer,
+                GLI_LINT_REDUNDANT_POINTER);
     // If a buffer is bound with glBindBuffer, ptr is treated as an offset and the bound buffer's data pointer is used
     // instead
-    if (vad->array_buffer_binding != 0) {
-        buffer_object_t *buffer = gliFindBufferObject(vad->array_buffer_binding, NULL);
-        if (buffer == NULL) {
-            gliSetError(GL_INVALID_OPERATION);
-            return;
-        }
-        vad->point_size_array_buffer_binding = vad->array_buffer_binding;
-    } else {
-        vad->point_size_array_buffer_binding = 0;
-    }
+    vad->point_size_array_buffer_binding = vad->array_buffer_binding;
+    vad->point_size_array_buffer = vad->array_buffer;
 
     vad->point_size_array_type = type;
     vad->point_size_array_stride = stride;
     vad->point_size_array_ptr = pointer;
 
     vad->point_size_array_dirty = GL_TRUE;
+    vad->attrib_serial++;
+}
+
+// xgux keeps each pb_begin/pb_end window to about 128 words, so do the same when packing several draws together
+#define DRAW_WINDOW_WORDS 128
+
+// Make room for words more words in the current push buffer window, starting a new window if it would overflow
+static uint32_t *reserve_words(uint32_t *p, uint32_t **window, GLuint words)
+{
+    if ((GLuint)(p - *window) + words > DRAW_WINDOW_WORDS) {
+        pb_end(p);
+        p = pb_begin();
+        *window = p;
+    }
+    return p;
+}
+
+// Push one draw worth of indices. 8 and 16-bit indices are sent as packed pairs with a trailing single index
+// if the count is odd, same as xgux_draw_elements16
+static uint32_t *push_elements(uint32_t *p, uint32_t **window, GLenum type, const void *indices, GLuint count)
+{
+    if (type == GL_UNSIGNED_INT) {
+        const uint32_t *elements = (const uint32_t *)indices;
+        while (count > 0) {
+            const GLuint batch_count = GLI_MIN(count, MAX_BATCH_ELEMENTS);
+            p = reserve_words(p, window, batch_count + 1);
+            p = xgu_element32(p, elements, batch_count);
+            elements += batch_count;
+            count -= batch_count;
+        }
+        return p;
+    }
+
+    const GLuint pair_count = count / 2;
+    for (GLuint i = 0; i < pair_count;) {
+        const GLuint batch_pair_count = GLI_MIN(pair_count - i, MAX_BATCH_ELEMENTS);
+        p = reserve_words(p, window, batch_pair_count + 1);
+        if (type == GL_UNSIGNED_SHORT) {
+            p = xgu_element16(p, &((const uint16_t *)indices)[i * 2], batch_pair_count * 2);
+        } else {
+            // Widen byte indices straight into the push buffer
+            const uint8_t *elements = &((const uint8_t *)indices)[i * 2];
+            p = push_command(p, 0x40000000 | NV097_ARRAY_ELEMENT16, batch_pair_count);
+            for (GLuint j = 0; j < batch_pair_count; j++) {
+                *p++ = elements[j * 2] | (elements[j * 2 + 1] << 16);
+            }
+        }
+        i += batch_pair_count;
+    }
+
+    if (count % 2) {
+        uint32_t index = (type == GL_UNSIGNED_SHORT) ? ((const uint16_t *)indices)[count - 1]
+                                                     : ((const uint8_t *)indices)[count - 1];
+        p = reserve_words(p, window, 2);
+        p = xgu_element32(p, &index, 1);
+    }
+    return p;
+}
+
+#if GLI_DRAW_MERGING
+// Upper bound on the vertices sharing one begin/end block, including the degenerate indices joining strips
+#define DRAW_MERGE_MAX_VERTICES 0xFFFF
+
+void gliDrawClose(void)
+{
+    gli_context_t *context = gliGetContext();
+    if (!context->draw_open) {
+        return;
+    }
+    context->draw_open = GL_FALSE;
+
+    uint32_t *p = pb_begin();
+    p = xgu_end(p);
+    pb_end(p);
+
+    // See glDrawArrays. This is held back until the block is closed, as pushing it would close the block anyway
+    glColor4f(context->current_values.current_color[0],
+              context->current_values.current_color[1],
+              context->current_values.current_color[2],
+              context->current_values.current_color[3]);
+}
+
+static inline GLuint element_at(GLenum type, const void *indices, GLuint i)
+{
+    if (type == GL_UNSIGNED_INT) {
+        return ((const uint32_t *)indices)[i];
+    } else if (type == GL_UNSIGNED_SHORT) {
+        return ((const uint16_t *)indices)[i];
+    }
+    return ((const uint8_t *)indices)[i];
+}
+
+// Start the push buffer writes for a draw. If the block left open by the previous draw has the same primitive and
+// the same kind of draw, this one joins it, with triangle strips stitched together by degenerate triangles.
+// Otherwise that block is closed and a new one begun.
+static uint32_t *draw_begin(uint32_t **window, DWORD primitive, GLboolean elements, GLuint count, GLuint first_index)
+{
+    gli_context_t *context = gliGetContext();
+    uint32_t *p;
+
+    const GLboolean join = context->draw_open && context->draw_open_primitive == primitive &&
+                           context->draw_open_elements == elements &&
+                           context->draw_open_draw_count < GLI_DRAW_MERGE_MAX_DRAWS &&
+                           context->draw_open_vertex_count + count + 3 <= DRAW_MERGE_MAX_VERTICES;
+    if (!join) {
+        gliDrawClose();
+        context->draw_open_vertex_count = 0;
+        context->draw_open_draw_count = 0;
+        p = pb_begin();
+        *window = p;
+        return xgu_begin(p, primitive);
+    }
+
+    // Clear the flag first so pb_begin doesn't close the block being joined
+    context->draw_open = GL_FALSE;
+    p = pb_begin();
+    *window = p;
+    if (primitive == NV097_SET_BEGIN_END_OP_TRIANGLE_STRIP) {
+        // Repeat the last index then the new first index. The first index is doubled if needed so the new strip
+        // starts on an even vertex and keeps its winding
+        const uint32_t degenerate[3] = {context->draw_open_last_index, first_index, first_index};
+        const GLuint degenerate_count = 2 + (context->draw_open_vertex_count & 1);
+        p = xgu_element32(p, degenerate, degenerate_count);
+        context->draw_open_vertex_count += degenerate_count;
+    }
+    return p;
 }
 
+// Finish the push buffer writes for a draw. Point, line and triangle lists that end on a whole primitive, and indexed
+// triangle strips, are left open for the next draw to join. Anything else is closed straight away.
+static void draw_end(uint32_t *p, DWORD primitive, GLboolean elements, GLuint count, GLuint last_index)
+{
+    gli_context_t *context = gliGetContext();
+    pb_end(p);
+
+    context->draw_open = GL_TRUE;
+    context->draw_open_elements = elements;
+    context->draw_open_primitive = primitive;
+    context->draw_open_last_index = last_index;
+    context->draw_open_vertex_count += count;
+    context->draw_open_draw_count++;
+
+    GLboolean joinable;
+    switch (primitive) {
+        case NV097_SET_BEGIN_END_OP_POINTS:
+            joinable = GL_TRUE;
+            break;
+        case NV097_SET_BEGIN_END_OP_LINES:
+            joinable = (count % 2) == 0;
+            break;
+        case NV097_SET_BEGIN_END_OP_TRIANGLES:
+            joinable = (count % 3) == 0;
+            break;
+        case NV097_SET_BEGIN_END_OP_TRIANGLE_STRIP:
+            joinable = elements;
+            break;
+        default:
+            joinable = GL_FALSE;
+            break;
+    }
+
+    if (!joinable) {
+        gliDrawClose();
+    }
+}
+#endif
+
 GL_API void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
 {
     gli_context_t *context = gliGetContext();
 
-    if (count < 0) {
+    if (GLI_INVALID(count < 0)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
@@ -230,7 +395,7 @@ GL_API void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
     }
 
     DWORD primitive = gliEnumToNvPrimitive(mode);
-    if (primitive == -1) {
+    if (GLI_INVALID(primitive == -1)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -240,6 +405,31 @@ GL_API void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
     }
 
     gliFlushStateChange();
+    gliCount(GLI_COUNTER_DRAW_CALLS, 1);
+    gliCount(GLI_COUNTER_VERTICES, count);
+#ifdef GL_OES_matrix_palette
+    if (gliPaletteDrawActive()) {
+        gliPaletteDraw(mode, first, count, 0, NULL);
+        return;
+    }
+#endif
+#if GLI_DRAW_MERGING
+    if (count == 0) {
+        return;
+    }
+    uint32_t *window;
+    uint32_t *p = draw_begin(&window, primitive, GL_FALSE, count, first);
+    GLuint start = first;
+    GLuint remaining = count;
+    while (remaining > 0) {
+        const GLuint batch_count = GLI_MIN(remaining, MAX_BATCH_ARRAYS);
+        p = reserve_words(p, &window, 4);
+        p = xgu_draw_arrays(p, start, batch_count);
+        start += batch_count;
+        remaining -= batch_count;
+    }
+    draw_end(p, primitive, GL_FALSE, count, first + count - 1);
+#else
     xgux_draw_arrays(primitive, first, count);
 
     // The current color, normal, point size, and texture coordinates each become indeterminate after the execution of
@@ -248,33 +438,88 @@ GL_API void GL_APIENTRY glDrawArrays(GLenum mode, GLint first, GLsizei count)
               context->current_values.current_color[1],
               context->current_values.current_color[2],
               context->current_values.current_color[3]);
+#endif
+}
+
+// Push the indices of a glDrawElements, either into the block left open for merging or as a draw of its own
+static void
+submit_elements(gli_context_t *context, DWORD primitive, GLenum type, const void *indices_ptr, GLsizei count)
+{
+#if GLI_DRAW_MERGING
+    if (count == 0) {
+        return;
+    }
+    uint32_t *window;
+    uint32_t *p = draw_begin(&window, primitive, GL_TRUE, count, element_at(type, indices_ptr, 0));
+    p = push_elements(p, &window, type, indices_ptr, (GLuint)count);
+    draw_end(p, primitive, GL_TRUE, count, element_at(type, indices_ptr, count - 1));
+#else
+    if (type == GL_UNSIGNED_SHORT) {
+        xgux_draw_elements16(primitive, (const uint16_t *)indices_ptr, (unsigned int)count);
+    } else if (type == GL_UNSIGNED_BYTE) {
+        uint16_t stack_alloc[512];
+        uint16_t *element16;
+        if (count <= 512) {
+            element16 = stack_alloc;
+        } else {
+            element16 = GLI_MALLOC(sizeof(uint16_t) * count);
+        }
+        if (!element16) {
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+        for (GLsizei i = 0; i < count; ++i) {
+            element16[i] = ((const uint8_t *)indices_ptr)[i];
+        }
+        xgux_draw_elements16(primitive, element16, (unsigned int)count);
+        if (element16 != stack_alloc) {
+            GLI_FREE(element16);
+        }
+    } else {
+        xgux_draw_elements32(primitive, (const uint32_t *)indices_ptr, (unsigned int)count);
+    }
+
+    // The current color, normal, point size, and texture coordinates each become indeterminate after the execution of
+    // DrawElements, however based on testing on my PC, atleast color seems to be restored. FIXME. Check others
+    glColor4f(context->current_values.current_color[0],
+              context->current_values.current_color[1],
+              context->current_values.current_color[2],
+              context->current_values.current_color[3]);
+#endif
+}
+
+static inline GLboolean valid_index_type(GLenum type)
+{
+#ifdef GL_OES_element_index_uint
+    if (type == GL_UNSIGNED_INT) {
+        return GL_TRUE;
+    }
+#endif
+    return type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_SHORT;
 }
 
 GL_API void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
 {
     gli_context_t *context = gliGetContext();
 
-    if (count < 0) {
+    if (GLI_INVALID(count < 0)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
 
-    if (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT
-#ifdef GL_OES_element_index_uint
-        && type != GL_UNSIGNED_INT
-#endif
-    ) {
+    if (GLI_INVALID(!valid_index_type(type))) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
 
     DWORD primitive = gliEnumToNvPrimitive(mode);
-    if (primitive == -1) {
+    if (GLI_INVALID(primitive == -1)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
+    GLI_LINT_IF(context->vertex_array_data.element_array_buffer_binding == 0, GLI_LINT_CLIENT_INDICES);
 
-    const void *indices_ptr = gliGetBufferPointer(context->vertex_array_data.element_array_buffer_binding, indices);
+    const void *indices_ptr = gliGetBufferPointer(context->vertex_array_data.element_array_buffer, indices);
 
     // Scan indices to find vertex range, then stage client arrays
     if (gliNeedsStaging()) {
@@ -285,39 +530,187 @@ GL_API void GL_APIENTRY glDrawElements(GLenum mode, GLsizei count, GLenum type,
     }
 
     gliFlushStateChange();
+    gliCount(GLI_COUNTER_DRAW_CALLS, 1);
+    gliCount(GLI_COUNTER_INDICES, count);
+#ifdef GL_OES_matrix_palette
+    if (gliPaletteDrawActive()) {
+        gliPaletteDraw(mode, 0, count, type, indices_ptr);
+        return;
+    }
+#endif
 
-    if (type == GL_UNSIGNED_SHORT) {
-        xgux_draw_elements16(primitive, (const uint16_t *)indices_ptr, (unsigned int)count);
-    } else if (type == GL_UNSIGNED_BYTE) {
-        uint16_t stack_alloc[512];
-        uint16_t *element16;
-        if (count <= 512) {
-            element16 = stack_alloc;
-        } else {
-            element16 = GLI_MALLOC(sizeof(uint16_t) * count);
+    GLI_PROFILE_CALL(GLI_SCOPE_INDICES, submit_elements(context, primitive, type, indices_ptr, count));
+}
+
+#ifdef GL_EXT_multi_draw_arrays
+GL_API void GL_APIENTRY glMultiDrawArraysEXT(GLenum mode, const GLint *first, const GLsizei *count, GLsizei primcount)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (GLI_INVALID(primcount < 0)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLsizei vertex_count = 0;
+    for (GLsizei i = 0; i < primcount; i++) {
+        if (GLI_INVALID(count[i] < 0)) {
+            gliSetError(GL_INVALID_VALUE);
+            return;
         }
-        if (!element16) {
-            gliSetError(GL_OUT_OF_MEMORY);
+        if (count[i] > 0) {
+            vertex_count = GLI_MAX(vertex_count, first[i] + count[i]);
+        }
+    }
+
+    // Check if vertex array is enabled. Doesnt throw an error, just returns.
+    if (context->vertex_array_data.vertex_array_enabled == GL_FALSE) {
+        return;
+    }
+
+    DWORD primitive = gliEnumToNvPrimitive(mode);
+    if (GLI_INVALID(primitive == -1)) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (vertex_count == 0) {
+        return;
+    }
+
+#ifdef GL_OES_matrix_palette
+    // Skinned draws are split up on the CPU anyway, so there is nothing to gain from batching the sub-draws
+    if (gliPaletteDrawActive()) {
+        for (GLsizei i = 0; i < primcount; i++) {
+            glDrawArrays(mode, first[i], count[i]);
+        }
+        return;
+    }
+#endif
+
+    // Stage once for the union of every sub-draw, then flush once for all of them
+    if (!gliStageClientArrays(vertex_count)) {
+        return;
+    }
+
+    gliFlushStateChange();
+    gliCount(GLI_COUNTER_DRAW_CALLS, 1);
+
+    uint32_t *p = pb_begin();
+    uint32_t *window = p;
+    for (GLsizei i = 0; i < primcount; i++) {
+        GLuint start = first[i];
+        GLuint remaining = count[i];
+        if (remaining == 0) {
+            continue;
+        }
+        gliCount(GLI_COUNTER_VERTICES, remaining);
+
+        p = reserve_words(p, &window, 4);
+        p = xgu_begin(p, primitive);
+        while (remaining > 0) {
+            const GLuint batch_count = GLI_MIN(remaining, MAX_BATCH_ARRAYS);
+            p = reserve_words(p, &window, 4);
+            p = xgu_draw_arrays(p, start, batch_count);
+            start += batch_count;
+            remaining -= batch_count;
+        }
+        p = xgu_end(p);
+    }
+    pb_end(p);
+
+    // See glDrawArrays
+    glColor4f(context->current_values.current_color[0],
+              context->current_values.current_color[1],
+              context->current_values.current_color[2],
+              context->current_values.current_color[3]);
+}
+
+GL_API void GL_APIENTRY
+glMultiDrawElementsEXT(GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (GLI_INVALID(primcount < 0)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    for (GLsizei i = 0; i < primcount; i++) {
+        if (GLI_INVALID(count[i] < 0)) {
+            gliSetError(GL_INVALID_VALUE);
             return;
         }
-        for (GLsizei i = 0; i < count; ++i) {
-            element16[i] = ((const uint8_t *)indices_ptr)[i];
+    }
+
+    if (GLI_INVALID(!valid_index_type(type))) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    DWORD primitive = gliEnumToNvPrimitive(mode);
+    if (GLI_INVALID(primitive == -1)) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+    GLI_LINT_IF(context->vertex_array_data.element_array_buffer_binding == 0, GLI_LINT_CLIENT_INDICES);
+
+#ifdef GL_OES_matrix_palette
+    // See glMultiDrawArraysEXT
+    if (gliPaletteDrawActive()) {
+        for (GLsizei i = 0; i < primcount; i++) {
+            glDrawElements(mode, count[i], type, indices[i]);
         }
-        xgux_draw_elements16(primitive, element16, (unsigned int)count);
-        if (element16 != stack_alloc) {
-            GLI_FREE(element16);
+        return;
+    }
+#endif
+
+    // Scan every sub-draw for the highest index so client arrays are staged once for all of them
+    buffer_object_t *element_array_buffer = context->vertex_array_data.element_array_buffer;
+    if (gliNeedsStaging()) {
+        GLsizei max_index = -1;
+        for (GLsizei i = 0; i < primcount; i++) {
+            if (count[i] > 0) {
+                const void *indices_ptr = gliGetBufferPointer(element_array_buffer, indices[i]);
+                max_index = GLI_MAX(max_index, gliScanMaxIndex(type, indices_ptr, count[i]));
+            }
+        }
+        if (max_index < 0) {
+            return;
+        }
+        if (!gliStageClientArrays(max_index + 1)) {
+            return;
         }
-    } else {
-        xgux_draw_elements32(primitive, (const uint32_t *)indices_ptr, (unsigned int)count);
     }
 
-    // The current color, normal, point size, and texture coordinates each become indeterminate after the execution of
-    // DrawElements, however based on testing on my PC, atleast color seems to be restored. FIXME. Check others
+    gliFlushStateChange();
+    gliCount(GLI_COUNTER_DRAW_CALLS, 1);
+
+    GLI_PROFILE_BEGIN(GLI_SCOPE_INDICES);
+    uint32_t *p = pb_begin();
+    uint32_t *window = p;
+    for (GLsizei i = 0; i < primcount; i++) {
+        if (count[i] == 0) {
+            continue;
+        }
+        const void *indices_ptr = gliGetBufferPointer(element_array_buffer, indices[i]);
+        gliCount(GLI_COUNTER_INDICES, count[i]);
+
+        p = reserve_words(p, &window, 2);
+        p = xgu_begin(p, primitive);
+        p = push_elements(p, &window, type, indices_ptr, (GLuint)count[i]);
+        p = reserve_words(p, &window, 2);
+        p = xgu_end(p);
+    }
+    pb_end(p);
+    GLI_PROFILE_END(GLI_SCOPE_INDICES);
+
+    // See glDrawElements
     glColor4f(context->current_values.current_color[0],
               context->current_values.current_color[1],
               context->current_values.current_color[2],
               context->current_values.current_color[3]);
 }
+#endif
 
 GL_API void GL_APIENTRY glMultiTexCoord4f(GLenum tex, GLfloat s, GLfloat t, GLfloat r, GLfloat q)
 {
@@ -325,7 +718,7 @@ GL_API void GL_APIENTRY glMultiTexCoord4f(GLenum tex, GLfloat s, GLfloat t, GLfl
     current_values_t *cv = &context->current_values;
     vertex_array_data_t *vad = &context->vertex_array_data;
 
-    if (tex < GL_TEXTURE0 || tex >= GL_TEXTURE0 + GLI_MAX_TEXTURE_UNITS) {
+    if (GLI_INVALID(tex < GL_TEXTURE0 || tex >= GL_TEXTURE0 + GLI_MAX_TEXTURE_UNITS)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -425,6 +818,18 @@ void gliArrayFlush(void)
     current_values_t *cv = &context->current_values;
     const void *array_ptr = NULL;
 
+    // A buffer was reallocated since the last flush. Re-send every attribute sourced from a buffer
+    if (vad->flushed_buffer_generation != vad->buffer_generation) {
+        vad->vertex_array_dirty |= (vad->vertex_array_buffer != NULL);
+        vad->normal_array_dirty |= (vad->normal_array_buffer != NULL);
+        vad->color_array_dirty |= (vad->color_array_buffer != NULL);
+        vad->point_size_array_dirty |= (vad->point_size_array_buffer != NULL);
+        for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+            vad->texcoord_array_dirty[i] |= (vad->texcoord_array_buffer[i] != NULL);
+        }
+        vad->flushed_buffer_generation = vad->buffer_generation;
+    }
+
     // Vertex
     if (vad->vertex_array_dirty) {
         XguVertexArrayType format = gliEnumToNvType(vad->vertex_array_type);
@@ -433,7 +838,7 @@ void gliArrayFlush(void)
             stride = vad->vertex_array_size * gliEnumtoByteSize(vad->vertex_array_type);
         }
 
-        const void *array_ptr = gliGetBufferPointer(vad->vertex_array_buffer_binding, vad->vertex_array_ptr);
+        const void *array_ptr = gliGetBufferPointer(vad->vertex_array_buffer, vad->vertex_array_ptr);
         xgux_set_attrib_pointer(XGU_VERTEX_ARRAY, format, vad->vertex_array_size, stride, array_ptr);
         vad->vertex_array_dirty = GL_FALSE;
     }
@@ -447,7 +852,7 @@ void gliArrayFlush(void)
                 stride = vad->color_array_size * gliEnumtoByteSize(vad->color_array_type);
             }
 
-            const void *array_ptr = gliGetBufferPointer(vad->color_array_buffer_binding, vad->color_array_ptr);
+            const void *array_ptr = gliGetBufferPointer(vad->color_array_buffer, vad->color_array_ptr);
             xgux_set_attrib_pointer(XGU_COLOR_ARRAY, format, vad->color_array_size, stride, array_ptr);
         } else {
             xgux_set_attrib_pointer(XGU_COLOR_ARRAY, XGU_FLOAT, 0, 0, 0);
@@ -464,7 +869,7 @@ void gliArrayFlush(void)
                 stride = 3 * gliEnumtoByteSize(vad->normal_array_type);
             }
 
-            const void *array_ptr = gliGetBufferPointer(vad->normal_array_buffer_binding, vad->normal_array_ptr);
+            const void *array_ptr = gliGetBufferPointer(vad->normal_array_buffer, vad->normal_array_ptr);
             xgux_set_attrib_pointer(XGU_NORMAL_ARRAY, format, 3, stride, array_ptr);
         } else {
             xgux_set_attrib_pointer(XGU_NORMAL_ARRAY, XGU_FLOAT, 0, 0, 0);
@@ -483,7 +888,7 @@ void gliArrayFlush(void)
                     stride = vad->texcoord_array_size[i] * gliEnumtoByteSize(vad->texcoord_array_type[i]);
                 }
                 const void *array_ptr =
-                    gliGetBufferPointer(vad->texcoord_array_buffer_binding[i], vad->texcoord_array_ptr[i]);
+                    gliGetBufferPointer(vad->texcoord_array_buffer[i], vad->texcoord_array_ptr[i]);
                 xgux_set_attrib_pointer(xgu_slot, format, vad->texcoord_array_size[i], stride, array_ptr);
             } else {
                 xgux_set_attrib_pointer(xgu_slot, XGU_FLOAT, 0, 0, 0);
@@ -502,7 +907,7 @@ void gliArrayFlush(void)
             }
 
             const void *array_ptr =
-                gliGetBufferPointer(vad->point_size_array_buffer_binding, vad->point_size_array_ptr);
+                gliGetBufferPointer(vad->point_size_array_buffer, vad->point_size_array_ptr);
             xgux_set_attrib_pointer(XGU_POINT_SIZE_ARRAY, format, 1, stride, array_ptr);
         } else {
             xgux_set_attrib_pointer(XGU_POINT_SIZE_ARRAY, XGU_FLOAT, 0, 0, 0);
@@ -1,26 +1,9 @@
 #include "gles_private.h"
 
-buffer_object_t *gliFindBufferObject(GLuint name, buffer_object_t **prev)
+buffer_object_t *gliFindBufferObject(GLuint name)
 {
     gli_context_t *context = gliGetContext();
-    buffer_object_t *g_buffers_head = context->buffer_objects;
-    if (prev) {
-        *prev = NULL;
-    }
-
-    if (name == 0) {
-        return NULL;
-    }
-
-    for (buffer_object_t *it = g_buffers_head; it != NULL; it = it->next) {
-        if (it->buffer_name == name) {
-            return it;
-        }
-        if (prev) {
-            *prev = it;
-        }
-    }
-    return NULL;
+    return (buffer_object_t *)gliNameLookup(&context->buffer_names, name);
 }
 
 static GLuint *get_binding_ptr(GLenum target)
@@ -36,23 +19,51 @@ static GLuint *get_binding_ptr(GLenum target)
     }
 }
 
-GLvoid *gliGetBufferPointer(GLuint buffer_binding, const GLvoid *ptr)
+static buffer_object_t **get_buffer_ptr(GLenum target)
 {
     gli_context_t *context = gliGetContext();
-    vertex_array_data_t *vad = &context->vertex_array_data;
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            return &context->vertex_array_data.array_buffer;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return &context->vertex_array_data.element_array_buffer;
+        default:
+            return NULL;
+    }
+}
 
+GLvoid *gliGetBufferPointer(const buffer_object_t *buffer, const GLvoid *ptr)
+{
     // If a buffer is bound with glBindBuffer, ptr is treated as an offset and the bound buffer's data pointer is used
     // instead
-    if (buffer_binding != 0) {
-        buffer_object_t *buffer = gliFindBufferObject(buffer_binding, NULL);
+    if (buffer != NULL) {
         return (GLvoid *)((uintptr_t)buffer->buffer_data + (uintptr_t)ptr);
     } else {
         return (GLvoid *)ptr;
     }
 }
 
+// As gliGetBufferPointer, for data the CPU reads rather than the GPU. Reads from write-combined memory are uncached
+// and very slow, so the first one takes a cached copy of the buffer that glBufferSubData then keeps up to date
+const GLvoid *gliGetBufferCpuPointer(buffer_object_t *buffer, const GLvoid *ptr)
+{
+    if (buffer == NULL || buffer->buffer_data == NULL || !(buffer->buffer_protect & PAGE_WRITECOMBINE)) {
+        return gliGetBufferPointer(buffer, ptr);
+    }
+
+    if (buffer->cpu_shadow == NULL) {
+        buffer->cpu_shadow = GLI_MALLOC(buffer->buffer_size);
+        if (buffer->cpu_shadow == NULL) {
+            return gliGetBufferPointer(buffer, ptr); // Slow, but still correct
+        }
+        gli_memcpy(buffer->cpu_shadow, buffer->buffer_data, buffer->buffer_size);
+    }
+    return (const GLvoid *)((uintptr_t)buffer->cpu_shadow + (uintptr_t)ptr);
+}
+
 GL_API void GL_APIENTRY glGenBuffers(GLsizei n, GLuint *buffers)
 {
+    gli_context_t *context = gliGetContext();
     if (buffers == NULL) {
         gliSetError(GL_INVALID_VALUE);
         return;
@@ -61,18 +72,8 @@ GL_API void GL_APIENTRY glGenBuffers(GLsizei n, GLuint *buffers)
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    static GLuint next = 1;
     for (GLsizei i = 0; i < n; i++) {
-        while (1) {
-            if (next == 0) {
-                next++;
-            }
-            if (gliFindBufferObject(next, NULL) == NULL) {
-                break;
-            }
-            next++;
-        }
-        buffers[i] = next++;
+        buffers[i] = gliNameGen(&context->buffer_names);
     }
 }
 
@@ -81,7 +82,7 @@ GL_API void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer)
     gli_context_t *context = gliGetContext();
 
     GLuint *binding = get_binding_ptr(target);
-    if (binding == NULL) {
+    if (GLI_INVALID(binding == NULL)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -89,15 +90,17 @@ GL_API void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer)
     // A buffer value of zero unbinds any buffer currently bound to the target
     if (buffer == 0) {
         *binding = 0;
+        *get_buffer_ptr(target) = NULL;
         return;
     }
 
     // FIXME, check for valid buffer name somehow?
 
     // First check if the buffer object already exists, if so just bind it
-    buffer_object_t *buffer_object = gliFindBufferObject(buffer, NULL);
+    buffer_object_t *buffer_object = gliFindBufferObject(buffer);
     if (buffer_object != NULL) {
         *binding = buffer;
+        *get_buffer_ptr(target) = buffer_object;
         return;
     }
 
@@ -109,13 +112,22 @@ GL_API void GL_APIENTRY glBindBuffer(GLenum target, GLuint buffer)
     }
 
     gli_memset(buffer_object, 0, sizeof(buffer_object_t));
+    if (!gliNameInsert(&context->buffer_names, buffer, buffer_object)) {
+        GLI_FREE(buffer_object);
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
     buffer_object->buffer_name = buffer;
     buffer_object->buffer_size = 0;
     buffer_object->buffer_usage = GL_STATIC_DRAW;
 
     // Bind and add to the context's list
     *binding = buffer;
+    *get_buffer_ptr(target) = buffer_object;
     buffer_object->next = context->buffer_objects;
+    if (buffer_object->next) {
+        buffer_object->next->prev = buffer_object;
+    }
     context->buffer_objects = buffer_object;
 }
 
@@ -129,61 +141,90 @@ GL_API void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers)
 
     for (GLsizei i = 0; i < n; i++) {
         GLuint name = buffers[i];
-        buffer_object_t *prev = NULL; // Track previous for linked list removal
-        buffer_object_t *buf = gliFindBufferObject(name, &prev);
+        buffer_object_t *buf = gliFindBufferObject(name);
+        gliNameRemove(&context->buffer_names, name);
         if (buf) {
             // Remove from the context's list
-            if (prev) {
-                prev->next = buf->next;
+            if (buf->prev) {
+                buf->prev->next = buf->next;
             } else {
                 context->buffer_objects = buf->next;
             }
+            if (buf->next) {
+                buf->next->prev = buf->prev;
+            }
 
             // If a buffer object is deleted while it is bound, all bindings to that object in the current context are
             // reset to zero
             if (context->vertex_array_data.array_buffer_binding == name) {
                 context->vertex_array_data.array_buffer_binding = 0;
+                context->vertex_array_data.array_buffer = NULL;
             }
 
             if (context->vertex_array_data.element_array_buffer_binding == name) {
                 context->vertex_array_data.element_array_buffer_binding = 0;
+                context->vertex_array_data.element_array_buffer = NULL;
             }
 
             // Also unbind from any vertex attributes using this buffer
             if (context->vertex_array_data.vertex_array_buffer_binding == name) {
                 context->vertex_array_data.vertex_array_buffer_binding = 0;
+                context->vertex_array_data.vertex_array_buffer = NULL;
                 context->vertex_array_data.vertex_array_ptr = NULL;
                 context->vertex_array_data.vertex_array_dirty = GL_TRUE;
             }
 
             if (context->vertex_array_data.normal_array_buffer_binding == name) {
                 context->vertex_array_data.normal_array_buffer_binding = 0;
+                context->vertex_array_data.normal_array_buffer = NULL;
                 context->vertex_array_data.normal_array_ptr = NULL;
                 context->vertex_array_data.normal_array_dirty = GL_TRUE;
             }
 
             if (context->vertex_array_data.color_array_buffer_binding == name) {
                 context->vertex_array_data.color_array_buffer_binding = 0;
+                context->vertex_array_data.color_array_buffer = NULL;
                 context->vertex_array_data.color_array_ptr = NULL;
                 context->vertex_array_data.color_array_dirty = GL_TRUE;
             }
 
             if (context->vertex_array_data.point_size_array_buffer_binding == name) {
                 context->vertex_array_data.point_size_array_buffer_binding = 0;
+                context->vertex_array_data.point_size_array_buffer = NULL;
                 context->vertex_array_data.point_size_array_ptr = NULL;
                 context->vertex_array_data.point_size_array_dirty = GL_TRUE;
             }
 
+            if (context->vertex_array_data.matrix_index_array_buffer_binding == name) {
+                context->vertex_array_data.matrix_index_array_buffer_binding = 0;
+                context->vertex_array_data.matrix_index_array_buffer = NULL;
+                context->vertex_array_data.matrix_index_array_ptr = NULL;
+            }
+
+            if (context->vertex_array_data.weight_array_buffer_binding == name) {
+                context->vertex_array_data.weight_array_buffer_binding = 0;
+                context->vertex_array_data.weight_array_buffer = NULL;
+                context->vertex_array_data.weight_array_ptr = NULL;
+            }
+
             for (int u = 0; u < GLI_MAX_TEXTURE_UNITS; ++u) {
                 if (context->vertex_array_data.texcoord_array_buffer_binding[u] == name) {
                     context->vertex_array_data.texcoord_array_buffer_binding[u] = 0;
+                    context->vertex_array_data.texcoord_array_buffer[u] = NULL;
                     context->vertex_array_data.texcoord_array_ptr[u] = NULL;
                     context->vertex_array_data.texcoord_array_dirty[u] = GL_TRUE;
                 }
             }
 
+            context->vertex_array_data.attrib_serial++;
+            gliVertexArraysDetachBuffer(buf);
+
             if (buf->buffer_data) {
-                MmFreeContiguousMemory(buf->buffer_data);
+                gliDeferredFree(buf->buffer_data, buf->buffer_size, buf->buffer_protect);
+                context->buffer_resident_bytes -= buf->buffer_size;
+            }
+            if (buf->cpu_shadow) {
+                GLI_FREE(buf->cpu_shadow);
             }
             GLI_FREE(buf);
         }
@@ -200,7 +241,7 @@ GL_API void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void
         return;
     }
 
-    buffer_object_t *buffer_object = gliFindBufferObject(*binding, NULL);
+    buffer_object_t *buffer_object = *get_buffer_ptr(target);
     if (buffer_object == NULL) {
         gliSetError(GL_INVALID_OPERATION);
         return;
@@ -216,11 +257,17 @@ GL_API void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void
         return;
     }
 
-    // Any pre-existing data store is deleted
+    // Any pre-existing data store is deleted. Attributes sourcing from this buffer need the new store's address
     if (buffer_object->buffer_data) {
-        MmFreeContiguousMemory(buffer_object->buffer_data);
+        gliDeferredFree(buffer_object->buffer_data, buffer_object->buffer_size, buffer_object->buffer_protect);
+        context->buffer_resident_bytes -= buffer_object->buffer_size;
         buffer_object->buffer_data = NULL;
     }
+    if (buffer_object->cpu_shadow) {
+        GLI_FREE(buffer_object->cpu_shadow);
+        buffer_object->cpu_shadow = NULL;
+    }
+    context->vertex_array_data.buffer_generation++;
 
     // Data size of zero is valid, but we dont need to allocate memory. We are done.
     if (size == 0) {
@@ -232,7 +279,7 @@ GL_API void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void
     // We have shared VRAM, don't really need to care about usage hints (GL_STATIC_DRAW / GL_DYNAMIC_DRAW) for now
     // However, since nxdk-gles11 reads index buffers on the CPU during glDrawElements, they MUST be cached.
     ULONG protect = (target == GL_ELEMENT_ARRAY_BUFFER) ? PAGE_READWRITE : (PAGE_READWRITE | PAGE_WRITECOMBINE);
-    void *gpu_data = MmAllocateContiguousMemoryEx(size, 0, 0xFFFFFFFF, 0x1000, protect);
+    void *gpu_data = gliContiguousAlloc(size, protect);
     if (gpu_data == NULL) {
         gliSetError(GL_OUT_OF_MEMORY);
         return;
@@ -241,6 +288,8 @@ GL_API void GL_APIENTRY glBufferData(GLenum target, GLsizeiptr size, const void
     buffer_object->buffer_size = (GLuint)size;
     buffer_object->buffer_usage = usage;
     buffer_object->buffer_data = gpu_data;
+    buffer_object->buffer_protect = protect;
+    context->buffer_resident_bytes += (GLuint)size;
 
     // If data is NULL, a data store of the specified size is still created, but its contents remain uninitialized and
     // thus undefined.
@@ -263,7 +312,7 @@ GL_API void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeip
         return;
     }
 
-    buffer_object_t *buffer_object = gliFindBufferObject(*binding, NULL);
+    buffer_object_t *buffer_object = *get_buffer_ptr(target);
     if (buffer_object == NULL || buffer_object->buffer_data == NULL) {
         gliSetError(GL_INVALID_OPERATION);
         return;
@@ -276,6 +325,9 @@ GL_API void GL_APIENTRY glBufferSubData(GLenum target, GLintptr offset, GLsizeip
     }
 
     gli_memcpy((uint8_t *)buffer_object->buffer_data + offset, data, size);
+    if (buffer_object->cpu_shadow) {
+        gli_memcpy((uint8_t *)buffer_object->cpu_shadow + offset, data, size);
+    }
 }
 
 GL_API void GL_APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname, GLint *params)
@@ -293,7 +345,7 @@ GL_API void GL_APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname, GLin
         return;
     }
 
-    buffer_object_t *buffer_object = gliFindBufferObject(*binding, NULL);
+    buffer_object_t *buffer_object = *get_buffer_ptr(target);
     if (buffer_object == NULL) {
         gliSetError(GL_INVALID_OPERATION);
         return;
@@ -315,7 +367,7 @@ GL_API void GL_APIENTRY glGetBufferParameteriv(GLenum target, GLenum pname, GLin
 GL_API GLboolean GL_APIENTRY glIsBuffer(GLuint buffer)
 {
     gli_context_t *context = gliGetContext();
-    buffer_object_t *buffer_object = gliFindBufferObject(buffer, NULL);
+    buffer_object_t *buffer_object = gliFindBufferObject(buffer);
     if (buffer == 0 || buffer_object == NULL) {
         return GL_FALSE;
     }
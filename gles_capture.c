@@ -0,0 +1,337 @@
+#include "gles_capture.h"
+#include "gles_private.h"
+#include <stdio.h>
+
+// GL call capture for offline replay. In a NXDK_GLES11_WITH_CAPTURE build every entry point is wrapped by the
+// gl_capture.c generated by tools/generate_gl_capture.py, which records the call here before running it. Calls the
+// library makes to its own entry points go straight to the implementation, so only the application's calls are kept.
+// Objects are replayed by the names the application was given, so a capture should start before it creates any.
+// Without GLI_CAPTURE glCaptureNV2A does nothing and returns GL_FALSE.
+
+#if GLI_CAPTURE
+#include "gl_capture_ids.h"
+
+GLboolean gliCaptureBegin(uint32_t id)
+{
+    gli_context_t *context = gliGetContext();
+    if (context->capture_stream == NULL) {
+        return GL_FALSE;
+    }
+    gliCaptureWrite(&id, sizeof(id));
+    return GL_TRUE;
+}
+
+void gliCaptureWrite(const void *data, uint32_t size)
+{
+    fwrite(data, 1, size, gliGetContext()->capture_stream);
+}
+
+void gliCapturePayload(const void *data, GLsizei size)
+{
+    const int32_t payload_size = (data != NULL && size >= 0) ? size : GLI_CAPTURE_NO_PAYLOAD;
+    gliCaptureWrite(&payload_size, sizeof(payload_size));
+    if (payload_size > 0) {
+        gliCaptureWrite(data, payload_size);
+    }
+}
+
+// glMultiDrawElementsEXT takes a pointer per draw. Written after the other arguments, as the count comes last
+void gliCaptureMultiIndices(const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount)
+{
+    const int32_t n = (count != NULL && indices != NULL && primcount > 0) ? primcount : 0;
+    gliCaptureWrite(&n, sizeof(n));
+    for (int32_t i = 0; i < n; i++) {
+        gliCaptureWrite(&indices[i], sizeof(indices[i]));
+        gliCapturePayload(indices[i], gliCaptureIndicesSize(count[i], type));
+    }
+}
+
+// Size of a glTexImage2D or glTexSubImage2D source image, following the unpack alignment
+GLsizei gliCaptureImageSize(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+    gli_context_t *context = gliGetContext();
+
+    GLsizei components;
+    switch (format) {
+        case GL_ALPHA:
+        case GL_LUMINANCE:
+            components = 1;
+            break;
+        case GL_LUMINANCE_ALPHA:
+            components = 2;
+            break;
+        case GL_RGB:
+            components = 3;
+            break;
+#ifdef GL_BGRA_EXT
+        case GL_BGRA_EXT:
+#endif
+        case GL_RGBA:
+            components = 4;
+            break;
+        default:
+            return GLI_CAPTURE_NO_PAYLOAD;
+    }
+
+    const GLsizei bytes_per_pixel = (type == GL_UNSIGNED_BYTE) ? components : 2;
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+    const GLint alignment = context->pixel_store.unpack_alignment;
+    const GLsizei row = width * bytes_per_pixel;
+    const GLsizei pitch = (row + (alignment - 1)) & ~(alignment - 1);
+    return pitch * (height - 1) + row;
+}
+
+// Client side indices are written out, indices in a buffer object are only an offset
+GLsizei gliCaptureIndicesSize(GLsizei count, GLenum type)
+{
+    gli_context_t *context = gliGetContext();
+    if (context->vertex_array_data.element_array_buffer_binding != 0 || count < 0) {
+        return GLI_CAPTURE_NO_PAYLOAD;
+    }
+    return count * (GLsizei)gliEnumtoByteSize(type);
+}
+
+// Values read by the vector forms of glLight, glMaterial, glFog, glTexEnv, glTexParameter and friends
+GLsizei gliCaptureParamCount(GLenum pname)
+{
+    switch (pname) {
+        case GL_AMBIENT:
+        case GL_DIFFUSE:
+        case GL_SPECULAR:
+        case GL_EMISSION:
+        case GL_AMBIENT_AND_DIFFUSE:
+        case GL_POSITION:
+        case GL_LIGHT_MODEL_AMBIENT:
+        case GL_FOG_COLOR:
+        case GL_TEXTURE_ENV_COLOR:
+#ifdef GL_TEXTURE_CROP_RECT_OES
+        case GL_TEXTURE_CROP_RECT_OES:
+#endif
+            return 4;
+        case GL_SPOT_DIRECTION:
+        case GL_POINT_DISTANCE_ATTENUATION:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+static void capture_array(gli_context_t *context,
+                          gli_capture_array_slot_t slot,
+                          GLboolean enabled,
+                          GLuint buffer_binding,
+                          GLint size,
+                          GLenum type,
+                          GLsizei stride,
+                          const void *ptr,
+                          GLsizei vertex_count)
+{
+    if (!enabled || buffer_binding != 0 || ptr == NULL) {
+        return;
+    }
+
+    // The same range gliStageClientArrays copies
+    const GLsizei element_stride = (stride != 0) ? stride : size * (GLsizei)gliEnumtoByteSize(type);
+    const gli_capture_array_t array = {
+        .slot = slot,
+        .size = size,
+        .type = type,
+        .stride = stride,
+        .bytes = (uint32_t)(vertex_count * element_stride),
+        .client_active_texture = context->vertex_array_data.client_active_texture,
+        .array_buffer_binding = context->vertex_array_data.array_buffer_binding,
+    };
+    const uint32_t id = GLI_CAPTURE_ID_CLIENT_ARRAY;
+    gliCaptureWrite(&id, sizeof(id));
+    gliCaptureWrite(&array, sizeof(array));
+    gliCaptureWrite(ptr, array.bytes);
+}
+
+static GLboolean has_client_arrays(const vertex_array_data_t *vad)
+{
+    if (vad->matrix_index_array_enabled && vad->matrix_index_array_buffer_binding == 0 &&
+        vad->matrix_index_array_ptr != NULL) {
+        return GL_TRUE;
+    }
+    if (vad->weight_array_enabled && vad->weight_array_buffer_binding == 0 && vad->weight_array_ptr != NULL) {
+        return GL_TRUE;
+    }
+    return gliNeedsStaging();
+}
+
+// Record the first vertex_count vertices of every enabled client side array, ahead of the draw reading them
+static void capture_client_arrays(GLsizei vertex_count)
+{
+    gli_context_t *context = gliGetContext();
+    const vertex_array_data_t *vad = &context->vertex_array_data;
+
+    if (vertex_count <= 0) {
+        return;
+    }
+
+    capture_array(context,
+                  GLI_CAPTURE_ARRAY_VERTEX,
+                  vad->vertex_array_enabled,
+                  vad->vertex_array_buffer_binding,
+                  vad->vertex_array_size,
+                  vad->vertex_array_type,
+                  vad->vertex_array_stride,
+                  vad->vertex_array_ptr,
+                  vertex_count);
+    capture_array(context,
+                  GLI_CAPTURE_ARRAY_NORMAL,
+                  vad->normal_array_enabled,
+                  vad->normal_array_buffer_binding,
+                  3,
+                  vad->normal_array_type,
+                  vad->normal_array_stride,
+                  vad->normal_array_ptr,
+                  vertex_count);
+    capture_array(context,
+                  GLI_CAPTURE_ARRAY_COLOR,
+                  vad->color_array_enabled,
+                  vad->color_array_buffer_binding,
+                  vad->color_array_size,
+                  vad->color_array_type,
+                  vad->color_array_stride,
+                  vad->color_array_ptr,
+                  vertex_count);
+    capture_array(context,
+                  GLI_CAPTURE_ARRAY_POINT_SIZE,
+                  vad->point_size_array_enabled,
+                  vad->point_size_array_buffer_binding,
+                  1,
+                  vad->point_size_array_type,
+                  vad->point_size_array_stride,
+                  vad->point_size_array_ptr,
+                  vertex_count);
+    capture_array(context,
+                  GLI_CAPTURE_ARRAY_MATRIX_INDEX,
+                  vad->matrix_index_array_enabled,
+                  vad->matrix_index_array_buffer_binding,
+                  vad->matrix_index_array_size,
+                  vad->matrix_index_array_type,
+                  vad->matrix_index_array_stride,
+                  vad->matrix_index_array_ptr,
+                  vertex_count);
+    capture_array(context,
+                  GLI_CAPTURE_ARRAY_WEIGHT,
+                  vad->weight_array_enabled,
+                  vad->weight_array_buffer_binding,
+                  vad->weight_array_size,
+                  vad->weight_array_type,
+                  vad->weight_array_stride,
+                  vad->weight_array_ptr,
+                  vertex_count);
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        capture_array(context,
+                      GLI_CAPTURE_ARRAY_TEXCOORD0 + i,
+                      vad->texcoord_array_enabled[i],
+                      vad->texcoord_array_buffer_binding[i],
+                      vad->texcoord_array_size[i],
+                      vad->texcoord_array_type[i],
+                      vad->texcoord_array_stride[i],
+                      vad->texcoord_array_ptr[i],
+                      vertex_count);
+    }
+}
+
+static GLboolean needs_client_arrays(gli_context_t *context)
+{
+    return context->capture_stream != NULL && has_client_arrays(&context->vertex_array_data);
+}
+
+void gliCaptureDrawArrays(GLint first, GLsizei count)
+{
+    if (!needs_client_arrays(gliGetContext()) || first < 0 || count <= 0) {
+        return;
+    }
+    capture_client_arrays(first + count);
+}
+
+void gliCaptureDrawElements(GLsizei count, GLenum type, const void *indices)
+{
+    gli_context_t *context = gliGetContext();
+    if (!needs_client_arrays(context) || count <= 0) {
+        return;
+    }
+    const void *indices_ptr = gliGetBufferPointer(context->vertex_array_data.element_array_buffer, indices);
+    capture_client_arrays(gliScanMaxIndex(type, indices_ptr, count) + 1);
+}
+
+void gliCaptureMultiDrawArrays(const GLint *first, const GLsizei *count, GLsizei primcount)
+{
+    if (!needs_client_arrays(gliGetContext()) || first == NULL || count == NULL) {
+        return;
+    }
+    GLsizei vertex_count = 0;
+    for (GLsizei i = 0; i < primcount; i++) {
+        if (first[i] >= 0 && count[i] > 0) {
+            vertex_count = GLI_MAX(vertex_count, first[i] + count[i]);
+        }
+    }
+    capture_client_arrays(vertex_count);
+}
+
+void gliCaptureMultiDrawElements(const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount)
+{
+    gli_context_t *context = gliGetContext();
+    if (!needs_client_arrays(context) || count == NULL || indices == NULL) {
+        return;
+    }
+    GLsizei vertex_count = 0;
+    for (GLsizei i = 0; i < primcount; i++) {
+        if (count[i] > 0) {
+            const void *indices_ptr = gliGetBufferPointer(context->vertex_array_data.element_array_buffer, indices[i]);
+            vertex_count = GLI_MAX(vertex_count, gliScanMaxIndex(type, indices_ptr, count[i]) + 1);
+        }
+    }
+    capture_client_arrays(vertex_count);
+}
+
+// Called after each glFlipNV2A, so a capture cut short by switching the console off still holds every full frame
+void gliCaptureFlush(void)
+{
+    gli_context_t *context = gliGetContext();
+    if (context->capture_stream != NULL) {
+        fflush(context->capture_stream);
+    }
+}
+#endif
+
+// Start writing every GL call to the file at path, ending any capture already running. A NULL path just ends it
+GLboolean glCaptureNV2A(const char *path)
+{
+#if GLI_CAPTURE
+    gli_context_t *context = gliGetContext();
+
+    if (context->capture_stream != NULL) {
+        fclose(context->capture_stream);
+        context->capture_stream = NULL;
+    }
+    if (path == NULL) {
+        return GL_TRUE;
+    }
+
+    FILE *stream = fopen(path, "wb");
+    if (stream == NULL) {
+        gliDebugF("[gles] could not open capture file %s\n", path);
+        return GL_FALSE;
+    }
+
+    const gli_capture_header_t header = {
+        .magic = GLI_CAPTURE_MAGIC,
+        .signature = GLI_CAPTURE_SIGNATURE,
+        .width = pb_back_buffer_width(),
+        .height = pb_back_buffer_height(),
+    };
+    fwrite(&header, sizeof(header), 1, stream);
+    context->capture_stream = stream;
+    return GL_TRUE;
+#else
+    (void)path;
+    return GL_FALSE;
+#endif
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <GLES/gl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// GL call capture stream, shared by the capture layer (gles_capture.c and the generated gl_capture.c) and the replay
+// tool (the generated gl_replay_dispatch.c and samples/gl_replay.c). See tools/generate_gl_capture.py.
+//
+// A capture is a gli_capture_header_t followed by records. Each record starts with a uint32_t id. Entry points are
+// numbered in the generated gl_capture_ids.h, and their arguments follow in declaration order as raw values. Pointer
+// arguments are written as their value, then for those with known contents an int32_t size and that many bytes, or a
+// size of -1 when the pointer is an offset into a buffer object or NULL. Client arrays aren't read until a draw, so
+// draws are preceded by a GLI_CAPTURE_ID_CLIENT_ARRAY record for every enabled client side array.
+
+#define GLI_CAPTURE_MAGIC             0x43494C47 // "GLIC"
+#define GLI_CAPTURE_ID_CLIENT_ARRAY   0xFFFF0001
+#define GLI_CAPTURE_NO_PAYLOAD        (-1)
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t signature; // GLI_CAPTURE_SIGNATURE of the entry point list the capture was made with
+    uint32_t width;
+    uint32_t height;
+} gli_capture_header_t;
+
+typedef enum
+{
+    GLI_CAPTURE_ARRAY_VERTEX,
+    GLI_CAPTURE_ARRAY_NORMAL,
+    GLI_CAPTURE_ARRAY_COLOR,
+    GLI_CAPTURE_ARRAY_POINT_SIZE,
+    GLI_CAPTURE_ARRAY_MATRIX_INDEX,
+    GLI_CAPTURE_ARRAY_WEIGHT,
+    GLI_CAPTURE_ARRAY_TEXCOORD0,
+    // GLI_CAPTURE_ARRAY_TEXCOORD0 + unit for the other texture units
+} gli_capture_array_slot_t;
+
+// Followed by bytes of array data, starting at the array's pointer
+typedef struct
+{
+    uint32_t slot;
+    int32_t size;
+    uint32_t type;
+    int32_t stride;
+    uint32_t bytes;
+    uint32_t client_active_texture; // Restored after re-pointing a texture coordinate array
+    uint32_t array_buffer_binding;  // Restored after re-pointing with no buffer bound
+} gli_capture_array_t;
+
+// Hooks called by the generated wrappers. gliCaptureBegin returns GL_FALSE, and the draw hooks do nothing, when no
+// capture is running
+GLboolean gliCaptureBegin(uint32_t id);
+void gliCaptureWrite(const void *data, uint32_t size);
+void gliCapturePayload(const void *data, GLsizei size);
+void gliCaptureMultiIndices(const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount);
+GLsizei gliCaptureImageSize(GLsizei width, GLsizei height, GLenum format, GLenum type);
+GLsizei gliCaptureIndicesSize(GLsizei count, GLenum type);
+GLsizei gliCaptureParamCount(GLenum pname);
+void gliCaptureDrawArrays(GLint first, GLsizei count);
+void gliCaptureDrawElements(GLsizei count, GLenum type, const void *indices);
+void gliCaptureMultiDrawArrays(const GLint *first, const GLsizei *count, GLsizei primcount);
+void gliCaptureMultiDrawElements(const GLsizei *count, GLenum type, const void *const *indices, GLsizei primcount);
+void gliCaptureFlush(void);
+
+// Replay side, implemented by samples/gl_replay.c. gliReplayCall is generated into gl_replay_dispatch.c, and reads the
+// arguments of one recorded call and makes it. Returns GL_FALSE for an id it doesn't know
+typedef struct gli_replay gli_replay_t;
+GLboolean gliReplayCall(gli_replay_t *replay, uint32_t call_id);
+void gliReplayRead(gli_replay_t *replay, void *data, uint32_t size);
+const void *gliReplayPayload(gli_replay_t *replay, GLuint slot, const void *pointer);
+const void *const *gliReplayMultiIndices(gli_replay_t *replay, GLuint slot);
+void *gliReplayScratch(gli_replay_t *replay, GLuint slot, size_t size);
+void gliReplayTimerStart(gli_replay_t *replay);
+void gliReplayTimerStop(gli_replay_t *replay);
@@ -0,0 +1,408 @@
+#include "gles_private.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// ETC1 modifier tables, indexed by the 3-bit table codeword then the 2-bit pixel index
+static const int16_t etc1_modifiers[8][4] = {
+    {2, 8, -2, -8},
+    {5, 17, -5, -17},
+    {9, 29, -9, -29},
+    {13, 42, -13, -42},
+    {18, 60, -18, -60},
+    {24, 80, -24, -80},
+    {33, 106, -33, -106},
+    {47, 183, -47, -183},
+};
+
+static inline GLubyte etc1_clamp(int x)
+{
+    return (GLubyte)((x < 0) ? 0 : ((x > 255) ? 255 : x));
+}
+
+// Decode one 8 byte ETC1 block into 16 RGB texels, stored in row major order
+static void etc1_decode_block(const GLubyte *block, GLubyte rgb[16][3])
+{
+    GLubyte base[2][3];
+    const GLboolean diff = (block[3] & 0x02) != 0;
+    const GLboolean flip = (block[3] & 0x01) != 0;
+    const int16_t *table[2] = {etc1_modifiers[(block[3] >> 5) & 0x7], etc1_modifiers[(block[3] >> 2) & 0x7]};
+
+    for (int c = 0; c < 3; c++) {
+        if (diff) {
+            int c1 = block[c] >> 3;
+            int dc = block[c] & 0x7;
+            int c2 = c1 + ((dc & 0x4) ? (dc - 8) : dc);
+            base[0][c] = (GLubyte)((c1 << 3) | (c1 >> 2));
+            base[1][c] = (GLubyte)(((c2 & 0x1F) << 3) | ((c2 & 0x1F) >> 2));
+        } else {
+            int c1 = block[c] >> 4;
+            int c2 = block[c] & 0xF;
+            base[0][c] = (GLubyte)((c1 << 4) | c1);
+            base[1][c] = (GLubyte)((c2 << 4) | c2);
+        }
+    }
+
+    // Pixel indices are stored column major, msb plane first
+    const GLuint msb = (block[4] << 8) | block[5];
+    const GLuint lsb = (block[6] << 8) | block[7];
+    for (int x = 0; x < 4; x++) {
+        for (int y = 0; y < 4; y++) {
+            const int bit = x * 4 + y;
+            const int index = (((msb >> bit) & 1) << 1) | ((lsb >> bit) & 1);
+            const int sub_block = (flip) ? (y >= 2) : (x >= 2);
+            const int modifier = table[sub_block][index];
+            GLubyte *texel = rgb[y * 4 + x];
+            texel[0] = etc1_clamp(base[sub_block][0] + modifier);
+            texel[1] = etc1_clamp(base[sub_block][1] + modifier);
+            texel[2] = etc1_clamp(base[sub_block][2] + modifier);
+        }
+    }
+}
+
+static inline uint16_t rgb888_to_565(const GLubyte *rgb)
+{
+    return (uint16_t)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+// Encode 16 opaque RGB texels as a 4 colour DXT1 block. The endpoints are the two texels furthest apart along the
+// principal axis of the block, found with a few rounds of power iteration, as in stb_dxt.
+static void dxt1_encode_block(GLubyte rgb[16][3], GLubyte *block)
+{
+    int mean[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        mean[0] += rgb[i][0];
+        mean[1] += rgb[i][1];
+        mean[2] += rgb[i][2];
+    }
+    mean[0] = (mean[0] + 8) >> 4;
+    mean[1] = (mean[1] + 8) >> 4;
+    mean[2] = (mean[2] + 8) >> 4;
+
+    int cov[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        const int r = rgb[i][0] - mean[0];
+        const int g = rgb[i][1] - mean[1];
+        const int b = rgb[i][2] - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+
+    // Start from the grey axis, which ETC1 sub-blocks lie along
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iter = 0; iter < 4; iter++) {
+        const float r = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+        const float g = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+        const float b = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+        const float m = GLI_MAX(GLI_MAX(fabsf(r), fabsf(g)), fabsf(b));
+        if (m < 1.0f) {
+            break;
+        }
+        axis[0] = r / m;
+        axis[1] = g / m;
+        axis[2] = b / m;
+    }
+
+    int min_i = 0, max_i = 0;
+    float min_d = FLT_MAX, max_d = -FLT_MAX;
+    for (int i = 0; i < 16; i++) {
+        const float d = rgb[i][0] * axis[0] + rgb[i][1] * axis[1] + rgb[i][2] * axis[2];
+        if (d < min_d) {
+            min_d = d;
+            min_i = i;
+        }
+        if (d > max_d) {
+            max_d = d;
+            max_i = i;
+        }
+    }
+
+    uint16_t c0 = rgb888_to_565(rgb[max_i]);
+    uint16_t c1 = rgb888_to_565(rgb[min_i]);
+    uint32_t indices = 0;
+
+    if (c0 < c1) {
+        uint16_t t = c0;
+        c0 = c1;
+        c1 = t;
+        int ti = max_i;
+        max_i = min_i;
+        min_i = ti;
+    }
+
+    if (c0 != c1) {
+        // Project each texel onto the endpoint axis and snap to the nearest of the 4 palette entries
+        const int axis[3] = {rgb[max_i][0] - rgb[min_i][0], rgb[max_i][1] - rgb[min_i][1],
+                             rgb[max_i][2] - rgb[min_i][2]};
+        const int len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        // Palette order is c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1. Map from t = 0 (c1) .. 3 (c0)
+        static const uint8_t remap[4] = {1, 3, 2, 0};
+        for (int i = 0; i < 16; i++) {
+            const int d = (rgb[i][0] - rgb[min_i][0]) * axis[0] + (rgb[i][1] - rgb[min_i][1]) * axis[1] +
+                          (rgb[i][2] - rgb[min_i][2]) * axis[2];
+            int t = (len2 > 0) ? (d * 3 + len2 / 2) / len2 : 0;
+            t = GLI_CLAMP(t, 0, 3);
+            indices |= (uint32_t)remap[t] << (i * 2);
+        }
+    }
+
+    block[0] = c0 & 0xFF;
+    block[1] = c0 >> 8;
+    block[2] = c1 & 0xFF;
+    block[3] = c1 >> 8;
+    block[4] = indices & 0xFF;
+    block[5] = (indices >> 8) & 0xFF;
+    block[6] = (indices >> 16) & 0xFF;
+    block[7] = indices >> 24;
+}
+
+void gliTranscodeETC1ToDXT1(const GLubyte *src, GLubyte *dst, GLuint block_count)
+{
+    GLubyte rgb[16][3];
+    GLubyte block[8];
+    for (GLuint i = 0; i < block_count; i++) {
+        etc1_decode_block(src, rgb);
+        dxt1_encode_block(rgb, block);
+        // dst is usually write-combined, so write each block out in one go. GCC makes this a single 8 byte store
+        memcpy(dst, block, 8);
+        src += 8;
+        dst += 8;
+    }
+}
+
+// Bits of a swizzled texel offset that come from x and from y. NV2A interleaves them starting with x, and the larger
+// side's remaining bits go on top. Adding 1 to a coordinate within its mask is (offset - mask) & mask
+static void swizzle_masks(GLuint width, GLuint height, GLuint *mask_x, GLuint *mask_y)
+{
+    GLuint x = 0, y = 0, mask_bit = 1;
+    for (GLuint bit = 1; bit < width || bit < height; bit <<= 1) {
+        if (bit < width) {
+            x |= mask_bit;
+            mask_bit <<= 1;
+        }
+        if (bit < height) {
+            y |= mask_bit;
+            mask_bit <<= 1;
+        }
+    }
+    *mask_x = x;
+    *mask_y = y;
+}
+
+void gliCompressedPalettedTexImage2D(
+    GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLsizei imageSize, const void *data)
+{
+    gli_context_t *context = gliGetContext();
+
+    GLenum format, type;
+    GLuint entry_size;
+    switch (internalformat) {
+        case GL_PALETTE4_RGB8_OES:
+        case GL_PALETTE8_RGB8_OES:
+            format = GL_RGB;
+            type = GL_UNSIGNED_BYTE;
+            entry_size = 3;
+            break;
+        case GL_PALETTE4_RGBA8_OES:
+        case GL_PALETTE8_RGBA8_OES:
+            format = GL_RGBA;
+            type = GL_UNSIGNED_BYTE;
+            entry_size = 4;
+            break;
+        case GL_PALETTE4_R5_G6_B5_OES:
+        case GL_PALETTE8_R5_G6_B5_OES:
+            format = GL_RGB;
+            type = GL_UNSIGNED_SHORT_5_6_5;
+            entry_size = 2;
+            break;
+        case GL_PALETTE4_RGBA4_OES:
+        case GL_PALETTE8_RGBA4_OES:
+            format = GL_RGBA;
+            type = GL_UNSIGNED_SHORT_4_4_4_4;
+            entry_size = 2;
+            break;
+        case GL_PALETTE4_RGB5_A1_OES:
+        case GL_PALETTE8_RGB5_A1_OES:
+            format = GL_RGBA;
+            type = GL_UNSIGNED_SHORT_5_5_5_1;
+            entry_size = 2;
+            break;
+        default:
+            gliSetError(GL_INVALID_ENUM);
+            return;
+    }
+
+    // Level is zero or negative. The absolute value is the number of extra mip levels packed after the base level
+    if (level > 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    // Checked before anything is sized from them, so the level count and the size sums can't overflow. There can be
+    // no more extra levels than it takes to halve the larger side down to 1
+    if (width < 0 || height < 0 || width > GLI_MAX_TEXTURE_SIZE || height > GLI_MAX_TEXTURE_SIZE) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    GLint max_extra_levels = 0;
+    for (GLsizei size = GLI_MAX(width, height); size > 1; size /= 2) {
+        max_extra_levels++;
+    }
+    if (level < -max_extra_levels) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    const GLuint index_bits = (internalformat <= GL_PALETTE4_RGB5_A1_OES) ? 4 : 8;
+    const GLuint palette_size = (1 << index_bits) * entry_size;
+    const GLint level_count = 1 - level;
+
+    GLuint expected_size = palette_size;
+    GLuint w = width, h = height;
+    for (GLint i = 0; i < level_count; i++) {
+        expected_size += (w * h * index_bits + 7) / 8;
+        w = GLI_MAX(1, w / 2);
+        h = GLI_MAX(1, h / 2);
+    }
+
+    if (imageSize < 0 || (GLuint)imageSize != expected_size) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    // Mip levels need swizzled storage, which is only possible for power of two sizes
+    const GLboolean swizzled =
+        (width > 0 && height > 0 && width == npot2pot(width) && height == npot2pot(height)) ? GL_TRUE : GL_FALSE;
+    if (level_count > 1 && !swizzled) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
+    texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
+    texture_object_t *texture_object = texture_unit->bound_texture_object;
+
+    xgu_texture_t *xgu_texture = GLI_MALLOC(sizeof(xgu_texture_t));
+    if (xgu_texture == NULL) {
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
+    gli_memset(xgu_texture, 0, sizeof(xgu_texture_t));
+
+    GLuint bytes_per_pixel = 0;
+    xgu_texture->swizzled = swizzled;
+    xgu_texture->format = gliEnumToNvTexFormat(format, type, &bytes_per_pixel, swizzled);
+    xgu_texture->bytes_per_pixel = bytes_per_pixel;
+    xgu_texture->tex_width = width;
+    xgu_texture->tex_height = height;
+
+    // Swizzled levels are stored at their real size, back to back, so every level of the chain can be written.
+    // Linear storage keeps the same minimum width and pitch alignment as glTexImage2D
+    GLuint alloc_size;
+    if (swizzled) {
+        xgu_texture->data_width = width;
+        xgu_texture->data_height = height;
+        xgu_texture->pitch = width * bytes_per_pixel;
+        xgu_texture->u_scale = 1.0f;
+        xgu_texture->v_scale = 1.0f;
+
+        // GL_GENERATE_MIPMAP fills in the whole chain from the base level once it is written
+        uint8_t chain_levels;
+        gliCalcMipmapChain(width, height, bytes_per_pixel, &alloc_size, &chain_levels);
+        xgu_texture->mipmap_levels = (texture_object->generate_mipmap) ? chain_levels : level_count;
+        if (xgu_texture->mipmap_levels == 1) {
+            alloc_size = width * height * bytes_per_pixel;
+        }
+    } else {
+        xgu_texture->data_width = GLI_MAX(8, width);
+        xgu_texture->data_height = GLI_MAX(8, height);
+        xgu_texture->pitch = (xgu_texture->data_width * bytes_per_pixel + 63) & ~63;
+        xgu_texture->u_scale = (GLfloat)width;
+        xgu_texture->v_scale = (GLfloat)height;
+        xgu_texture->mipmap_levels = 1;
+        alloc_size = xgu_texture->pitch * xgu_texture->data_height;
+    }
+
+    xgu_texture->data_size = alloc_size;
+    xgu_texture->data = gliTextureAlloc(alloc_size);
+    if (xgu_texture->data == NULL) {
+        GLI_FREE(xgu_texture);
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
+    xgu_texture->data_physical_address = (GLubyte *)MmGetPhysicalAddress(xgu_texture->data);
+
+    if (data != NULL) {
+        // Convert the palette to the storage format once, so each texel is a straight copy of its entry
+        GLubyte palette[256 * 4];
+        const GLubyte *src_palette = (const GLubyte *)data;
+        for (GLuint e = 0; e < (1u << index_bits); e++) {
+            const GLubyte *src = src_palette + e * entry_size;
+            GLubyte *dst = palette + e * bytes_per_pixel;
+            if (entry_size >= 3) {
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+                dst[3] = (entry_size == 4) ? src[3] : 0xFF;
+            } else {
+                dst[0] = src[0];
+                dst[1] = src[1];
+            }
+        }
+
+        // Expand each level straight into its place in the texture
+        const GLubyte *indices = src_palette + palette_size;
+        GLubyte *level_data = xgu_texture->data;
+        w = width;
+        h = height;
+        for (GLint i = 0; i < level_count; i++) {
+            GLuint mask_x, mask_y;
+            swizzle_masks(w, h, &mask_x, &mask_y);
+            GLuint p = 0;
+            for (GLuint y = 0, offset_y = 0; y < h; y++) {
+                GLubyte *row = (swizzled) ? level_data : level_data + y * xgu_texture->pitch;
+                for (GLuint x = 0, offset_x = 0; x < w; x++, p++) {
+                    GLuint index;
+                    if (index_bits == 4) {
+                        index = (p & 1) ? (indices[p >> 1] & 0xF) : (indices[p >> 1] >> 4);
+                    } else {
+                        index = indices[p];
+                    }
+                    const GLuint texel = (swizzled) ? (offset_x | offset_y) : x;
+                    const GLubyte *entry = palette + index * bytes_per_pixel;
+                    for (GLuint b = 0; b < bytes_per_pixel; b++) {
+                        row[texel * bytes_per_pixel + b] = entry[b];
+                    }
+                    offset_x = (offset_x - mask_x) & mask_x;
+                }
+                offset_y = (offset_y - mask_y) & mask_y;
+            }
+            gliCount(GLI_COUNTER_TEXTURE_UPLOADS, 1);
+            gliCount(GLI_COUNTER_TEXTURE_UPLOAD_BYTES, w * h * bytes_per_pixel);
+
+            indices += (w * h * index_bits + 7) / 8;
+            level_data += w * h * bytes_per_pixel;
+            w = GLI_MAX(1, w / 2);
+            h = GLI_MAX(1, h / 2);
+        }
+    } else {
+        gli_memset(xgu_texture->data, 0, alloc_size);
+    }
+
+    if (texture_object->texture_2d != NULL) {
+        xgu_texture_t *old_tex = (xgu_texture_t *)texture_object->texture_2d;
+        gliTextureRelease(old_tex);
+        GLI_FREE(old_tex);
+    }
+    texture_object->texture_2d = xgu_texture;
+    texture_object->internalformat = format;
+
+    if (swizzled && texture_object->generate_mipmap) {
+        gliGenSwizzledMipmaps(xgu_texture);
+    }
+    texture_object->texture_object_dirty = GL_TRUE;
+}
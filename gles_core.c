@@ -10,26 +10,45 @@ static gli_context_t g_context;
 
 GL_API void GL_APIENTRY glFinish(void)
 {
+    // Wait on a fence rather than spinning on pb_busy, so the CPU yields and timer markers are picked up on the way
+    gli_context_t *context = gliGetContext();
+    GLI_LINT_IF(GL_TRUE, GLI_LINT_FINISH);
+    const uint64_t start = gliReadTsc();
     glFlush();
-    while (pb_busy())
-        ;
+    gliFenceWait(gliFenceInsert());
+    context->frame_finish_wait_tsc += gliReadTsc() - start;
 }
 
 GL_API void GL_APIENTRY glFlush(void)
 {
-    // pbkit always flushes the push buffer on pb_end() calls.
-    return;
+    // pbkit always flushes the push buffer on pb_end() calls. Only a draw held open for merging is left to submit
+    gliDrawClose();
 }
 
 void gliFlushStateChange(void)
 {
-    gliFBOFlush();
-    gliTransformFlush();
-    gliFogFlush();
-    gliTextureFlush();
-    gliPointParamsFlush();
-    gliLightingFlush();
-    gliArrayFlush();
+    gli_context_t *context = gliGetContext();
+    const GLuint pushbuffer_words = context->frame_counters[GLI_COUNTER_PUSHBUFFER_WORDS];
+
+    GLI_PROFILE_CALL(GLI_SCOPE_FBO, gliFBOFlush());
+    GLI_PROFILE_CALL(GLI_SCOPE_TRANSFORM, gliTransformFlush());
+    GLI_PROFILE_CALL(GLI_SCOPE_FOG, gliFogFlush());
+    GLI_PROFILE_CALL(GLI_SCOPE_TEXTURE, gliTextureFlush());
+    GLI_PROFILE_CALL(GLI_SCOPE_POINT_PARAMS, gliPointParamsFlush());
+    GLI_PROFILE_CALL(GLI_SCOPE_LIGHTING, gliLightingFlush());
+    GLI_PROFILE_CALL(GLI_SCOPE_ARRAYS, gliArrayFlush());
+    GLI_PROFILE_CALL(GLI_SCOPE_VERTEX_PROGRAM, gliVertexProgramFlush());
+
+    // A flush that pushed nothing found no dirty state
+    if (context->frame_counters[GLI_COUNTER_PUSHBUFFER_WORDS] != pushbuffer_words) {
+        gliCount(GLI_COUNTER_STATE_FLUSHES, 1);
+    } else {
+        gliCount(GLI_COUNTER_EMPTY_STATE_FLUSHES, 1);
+    }
+
+    if (context->timer_marker_count > 0) {
+        gliTimerPoll();
+    }
 }
 
 GL_API GLenum GL_APIENTRY glGetError(void)
@@ -82,6 +101,9 @@ GL_API void GL_APIENTRY glHint(GLenum target, GLenum mode)
         case GL_POINT_SMOOTH_HINT:
             context->hints_state.point_smooth_hint = mode;
             break;
+        case GL_TEXTURE_COMPRESSION_HINT:
+            context->hints_state.texture_compression_hint = mode;
+            break;
         default:
             gliSetError(GL_INVALID_ENUM);
             return;
@@ -201,6 +223,14 @@ static void glEnableDisable(GLenum cap, GLboolean enable)
             pb = combiner_specular_fog_config(
                 pb, context->coloring_state.fog_enabled, context->lighting_state.lighting_enabled);
             break;
+#ifdef GL_OES_matrix_palette
+        case GL_MATRIX_PALETTE_OES:
+            // If enabled, vertices are blended from the palette matrices selected by the matrix index array. See
+            // glMatrixIndexPointerOES and glWeightPointerOES. The projection flush loads the matrix skinning needs
+            context->transformation_state.matrix_palette_enabled = enable;
+            context->transformation_state.projection_matrix_dirty = GL_TRUE;
+            break;
+#endif
         case GL_LINE_SMOOTH:
             // If enabled, draw lines with correct filtering. Otherwise, draw aliased lines. See glLineWidth.
             context->rasterization_state.line_smooth_enabled = enable;
@@ -315,6 +345,26 @@ static void glEnableDisable(GLenum cap, GLboolean enable)
             context->texture_environment.texture_units[texture].texture_2d_enabled = enable;
             context->texture_environment.texture_units[texture].texture_unit_dirty = GL_TRUE;
             break;
+#ifdef GL_OES_texture_cube_map
+        case GL_TEXTURE_CUBE_MAP_OES: {
+            // If enabled, cube map texturing is performed for the active texture unit and takes precedence over
+            // GL_TEXTURE_2D
+            const GLuint unit = context->texture_environment.server_active_texture - GL_TEXTURE0;
+            context->texture_environment.texture_units[unit].texture_cube_map_enabled = enable;
+            context->texture_environment.texture_units[unit].texture_unit_dirty = GL_TRUE;
+            context->transformation_state.texture_matrix_dirty[unit] = GL_TRUE;
+            break;
+        }
+        case GL_TEXTURE_GEN_STR_OES: {
+            // If enabled, the s, t and r texture coordinates of the active texture unit are generated in hardware. See
+            // glTexGenOES. The generated coordinates need the inverse modelview matrix
+            const GLuint unit = context->texture_environment.server_active_texture - GL_TEXTURE0;
+            context->texture_environment.texture_units[unit].texgen_enabled = enable;
+            context->texture_environment.texture_units[unit].texture_unit_dirty = GL_TRUE;
+            context->transformation_state.modelview_matrix_dirty = GL_TRUE;
+            break;
+        }
+#endif
         default:
             gliSetError(GL_INVALID_ENUM);
             break;
@@ -324,11 +374,13 @@ static void glEnableDisable(GLenum cap, GLboolean enable)
 
 GL_API void GL_APIENTRY glEnable(GLenum cap)
 {
+    GLI_LINT_IF(glIsEnabled(cap), GLI_LINT_REDUNDANT_ENABLE);
     glEnableDisable(cap, GL_TRUE);
 }
 
 GL_API void GL_APIENTRY glDisable(GLenum cap)
 {
+    GLI_LINT_IF(!glIsEnabled(cap), GLI_LINT_REDUNDANT_ENABLE);
     glEnableDisable(cap, GL_FALSE);
 }
 
@@ -362,6 +414,10 @@ GL_API GLboolean GL_APIENTRY glIsEnabled(GLenum cap)
             return context->lighting_state.lighting_enabled;
         case GL_LINE_SMOOTH:
             return context->rasterization_state.line_smooth_enabled;
+#ifdef GL_OES_matrix_palette
+        case GL_MATRIX_PALETTE_OES:
+            return context->transformation_state.matrix_palette_enabled;
+#endif
         case GL_MULTISAMPLE:
             return context->multisampling_state.multisample_enabled;
         case GL_NORMALIZE:
@@ -387,6 +443,16 @@ GL_API GLboolean GL_APIENTRY glIsEnabled(GLenum cap)
         case GL_TEXTURE_2D:
             const GLuint texture = context->texture_environment.server_active_texture - GL_TEXTURE0;
             return context->texture_environment.texture_units[texture].texture_2d_enabled;
+#ifdef GL_OES_texture_cube_map
+        case GL_TEXTURE_CUBE_MAP_OES: {
+            const GLuint unit = context->texture_environment.server_active_texture - GL_TEXTURE0;
+            return context->texture_environment.texture_units[unit].texture_cube_map_enabled;
+        }
+        case GL_TEXTURE_GEN_STR_OES: {
+            const GLuint unit = context->texture_environment.server_active_texture - GL_TEXTURE0;
+            return context->texture_environment.texture_units[unit].texgen_enabled;
+        }
+#endif
         default:
             gliSetError(GL_INVALID_ENUM);
             break;
@@ -616,6 +682,7 @@ void glContextInit(GLint window_width, GLint window_height)
     glHint(GL_LINE_SMOOTH_HINT, GL_DONT_CARE);
     glHint(GL_FOG_HINT, GL_DONT_CARE);
     glHint(GL_GENERATE_MIPMAP_HINT, GL_DONT_CARE);
+    glHint(GL_TEXTURE_COMPRESSION_HINT, GLI_TEXTURE_COMPRESSION_HINT);
 
     /* --- Table 6.20: Implementation limits --- */
     context->implementation_limits.max_lights = GLI_MAX_LIGHTS;
@@ -625,6 +692,7 @@ void glContextInit(GLint window_width, GLint window_height)
     context->implementation_limits.max_texture_stack_depth = GLI_MAX_TEXTURE_STACK;
     context->implementation_limits.subpixel_bits = GLI_SUBPIXEL_BITS;
     context->implementation_limits.max_texture_size = GLI_MAX_TEXTURE_SIZE;
+    context->implementation_limits.max_cube_map_texture_size = GLI_MAX_TEXTURE_SIZE;
     context->implementation_limits.max_viewport_dims[0] = GLI_MAX_VIEWPORT_WIDTH;
     context->implementation_limits.max_viewport_dims[1] = GLI_MAX_VIEWPORT_HEIGHT;
     context->implementation_limits.aliased_point_size_range[0] = GLI_MIN_ALIASED_POINT_SIZE;
@@ -636,9 +704,16 @@ void glContextInit(GLint window_width, GLint window_height)
     context->implementation_limits.antialiased_line_width_range[0] = GLI_MIN_SMOOTH_LINE_WIDTH;
     context->implementation_limits.antialiased_line_width_range[1] = GLI_MAX_SMOOTH_LINE_WIDTH;
     context->implementation_limits.max_texture_units = GLI_MAX_TEXTURE_UNITS;
+    context->implementation_limits.max_vertex_units = GLI_MAX_VERTEX_UNITS;
+    context->implementation_limits.max_palette_matrices = GLI_MAX_PALETTE_MATRICES;
     context->implementation_limits.sample_buffers = 0;
     context->implementation_limits.samples = 0;
+#ifdef GLI_COMPRESSED_TEXTURE_FORMATS
+    static GLenum compressed_texture_formats[GLI_NUM_COMPRESSED_TEXTURE_FORMATS] = {GLI_COMPRESSED_TEXTURE_FORMATS};
+    context->implementation_limits.compressed_texture_formats = compressed_texture_formats;
+#else
     context->implementation_limits.compressed_texture_formats = NULL;
+#endif
     context->implementation_limits.num_compressed_texture_formats = GLI_NUM_COMPRESSED_TEXTURE_FORMATS;
     context->current_surface_width = window_width;
     context->current_surface_height = window_height;
@@ -655,6 +730,7 @@ void glContextInit(GLint window_width, GLint window_height)
     glNormal3f(0.0f, 0.0f, 1.0f);
 
     /* --- Table 6.4 Vertex Array Data --- */
+    context->bound_vertex_array = &context->default_vertex_array;
     glClientActiveTexture(GL_TEXTURE0);
     glDisableClientState(GL_VERTEX_ARRAY);
     glVertexPointer(4, GL_FLOAT, 0, NULL);
@@ -675,6 +751,13 @@ void glContextInit(GLint window_width, GLint window_height)
     glDisableClientState(GL_POINT_SIZE_ARRAY_OES);
     glPointSizePointerOES(GL_FLOAT, 0, NULL);
 
+    /* OES_matrix_palette */
+    context->vertex_array_data.matrix_index_array_type = GL_UNSIGNED_BYTE;
+    context->vertex_array_data.weight_array_type = GL_FIXED;
+    for (int i = 0; i < GLI_MAX_PALETTE_MATRICES; ++i) {
+        glm_mat4_identity(context->transformation_state.palette_matrix[i]);
+    }
+
     /* Buffer bindings (global) + any per-attribute names you track */
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -804,6 +887,18 @@ void glContextInit(GLint window_width, GLint window_height)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
 
+#ifdef GL_OES_texture_cube_map
+        glDisable(GL_TEXTURE_CUBE_MAP_OES);
+        glBindTexture(GL_TEXTURE_CUBE_MAP_OES, 0);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_OES, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_OES, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_OES, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_OES, GL_GENERATE_MIPMAP, GL_FALSE);
+        glDisable(GL_TEXTURE_GEN_STR_OES);
+        glTexGeniOES(GL_TEXTURE_GEN_STR_OES, GL_TEXTURE_GEN_MODE_OES, GL_REFLECTION_MAP_OES);
+#endif
+
         glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
         glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, GLM_VEC4_ZERO);
         glTexEnvi(GL_POINT_SPRITE_OES, GL_COORD_REPLACE_OES, GL_FALSE);
@@ -855,6 +950,11 @@ void glContextInit(GLint window_width, GLint window_height)
     glClearDepthf(1.0f);
     glClearStencil(0);
 
+#ifdef GLI_CAPTURE_FILE
+    // Capture from the first call, including those gl4es makes while initializing
+    glCaptureNV2A(GLI_CAPTURE_FILE);
+#endif
+
 #ifdef NXDK_GLES11_WITH_GL4ES
     extern void set_getprocaddress(void*(*__stdcall)(const char*));
     extern void initialize_gl4es(void);
@@ -863,8 +963,21 @@ void glContextInit(GLint window_width, GLint window_height)
     initialize_gl4es();
 #endif
 
+    // Vertex program constants are uploaded the first time a program is used
+    context->vertex_program_state.transform_dirty = GL_TRUE;
+    context->vertex_program_state.lighting_dirty = GL_TRUE;
+
+    context->max_frames_in_flight = GLI_FRAMES_IN_FLIGHT;
+    context->frame_begin_tsc = gliReadTsc();
+    context->frame_end_vbl = (GLuint)pb_get_vbl_counter();
+
+    gliFenceInit();
+    gliQueryInit();
     gliStagingInit();
 
+    // The defaults set above aren't the application's calls
+    gliLintReset();
+
     gliFlushStateChange();
     while (pb_busy()) {
     }
@@ -921,79 +1034,85 @@ GLuint gliFormatToBpp(GLenum format)
     }
 }
 
+// Copy fewer than 16 bytes, 4 at a time. x86 doesn't mind unaligned 32-bit accesses
+static inline void copy_small(uint8_t *d, const uint8_t *s, size_t n)
+{
+    for (; n >= 4; n -= 4, d += 4, s += 4) {
+        uint32_t v;
+        memcpy(&v, s, sizeof(v));
+        memcpy(d, &v, sizeof(v));
+    }
+    while (n--) {
+        *d++ = *s++;
+    }
+}
+
 void *gli_memcpy(void *dst, const void *src, size_t n)
 {
     uint8_t *d = (uint8_t *)dst;
     const uint8_t *s = (const uint8_t *)src;
-    int streamed = 0;
 
-    // Fast path 1: Both Source and Destination are 16-byte aligned
-    if (n >= 16 && ((uintptr_t)d & 15) == 0 && ((uintptr_t)s & 15) == 0) {
-        streamed = 1;
+    if (n >= GLI_MEMCPY_STREAM_THRESHOLD) {
+        // Copy up to 15 bytes to bring the destination to 16 byte alignment, so the bulk always streams
+        const size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+        copy_small(d, s, head);
+        d += head;
+        s += head;
+        n -= head;
+
+        // Coppermine has 32 byte cache lines, so each 64 byte step prefetches two. Prefetches past the end of the
+        // source are harmless. Each step fills exactly two 32-byte write combining buffers for a clean bus burst
         size_t n64 = n >> 6;
-        while (n64--) {
-            _mm_prefetch((const char *)(s + 128), _MM_HINT_NTA);
-
-            __m128 x0 = _mm_load_ps((const float *)s);
-            __m128 x1 = _mm_load_ps((const float *)(s + 16));
-            __m128 x2 = _mm_load_ps((const float *)(s + 32));
-            __m128 x3 = _mm_load_ps((const float *)(s + 48));
-
-            // Fills exactly two 32-byte Coppermine WCBs for a clean bus burst
-            _mm_stream_ps((float *)d, x0);
-            _mm_stream_ps((float *)(d + 16), x1);
-            _mm_stream_ps((float *)(d + 32), x2);
-            _mm_stream_ps((float *)(d + 48), x3);
-
-            d += 64;
-            s += 64;
+        if (((uintptr_t)s & 15) == 0) {
+            while (n64--) {
+                _mm_prefetch((const char *)(s + GLI_MEMCPY_PREFETCH_DISTANCE), _MM_HINT_NTA);
+                _mm_prefetch((const char *)(s + GLI_MEMCPY_PREFETCH_DISTANCE + 32), _MM_HINT_NTA);
+                __m128 x0 = _mm_load_ps((const float *)s);
+                __m128 x1 = _mm_load_ps((const float *)(s + 16));
+                __m128 x2 = _mm_load_ps((const float *)(s + 32));
+                __m128 x3 = _mm_load_ps((const float *)(s + 48));
+                _mm_stream_ps((float *)d, x0);
+                _mm_stream_ps((float *)(d + 16), x1);
+                _mm_stream_ps((float *)(d + 32), x2);
+                _mm_stream_ps((float *)(d + 48), x3);
+                d += 64;
+                s += 64;
+            }
+        } else {
+            while (n64--) {
+                _mm_prefetch((const char *)(s + GLI_MEMCPY_PREFETCH_DISTANCE), _MM_HINT_NTA);
+                _mm_prefetch((const char *)(s + GLI_MEMCPY_PREFETCH_DISTANCE + 32), _MM_HINT_NTA);
+                __m128 x0 = _mm_loadu_ps((const float *)s);
+                __m128 x1 = _mm_loadu_ps((const float *)(s + 16));
+                __m128 x2 = _mm_loadu_ps((const float *)(s + 32));
+                __m128 x3 = _mm_loadu_ps((const float *)(s + 48));
+                _mm_stream_ps((float *)d, x0);
+                _mm_stream_ps((float *)(d + 16), x1);
+                _mm_stream_ps((float *)(d + 32), x2);
+                _mm_stream_ps((float *)(d + 48), x3);
+                d += 64;
+                s += 64;
+            }
         }
         n &= 63;
 
         size_t n16 = n >> 4;
         while (n16--) {
-            __m128 x = _mm_load_ps((const float *)s);
-            _mm_stream_ps((float *)d, x);
-            d += 16;
-            s += 16;
-        }
-        n &= 15;
-    }
-    // Fast path 2: Destination is 16-byte aligned
-    else if (n >= 16 && ((uintptr_t)d & 15) == 0) {
-        streamed = 1;
-        size_t n16 = n >> 4;
-        while (n16--) {
-            __m128 x = _mm_loadu_ps((const float *)s);
-            _mm_stream_ps((float *)d, x);
+            _mm_stream_ps((float *)d, _mm_loadu_ps((const float *)s));
             d += 16;
             s += 16;
         }
         n &= 15;
-    }
 
-    if (streamed) {
         _mm_sfence();
-    }
-
-    // Fallback path: 4-byte aligned
-    if (n >= 4 && ((uintptr_t)d & 3) == 0 && ((uintptr_t)s & 3) == 0) {
-        uint32_t *d32 = (uint32_t *)d;
-        const uint32_t *s32 = (const uint32_t *)s;
-        size_t n4 = n >> 2;
-        while (n4--) {
-            *d32++ = *s32++;
+    } else {
+        // Too short to stream; cover all but the last 15 bytes 16 at a time
+        for (; n >= 16; n -= 16, d += 16, s += 16) {
+            _mm_storeu_ps((float *)d, _mm_loadu_ps((const float *)s));
         }
-        d = (uint8_t *)d32;
-        s = (const uint8_t *)s32;
-        n &= 3;
     }
 
-    // Byte-by-byte tail cleanup
-    while (n > 0) {
-        *d++ = *s++;
-        n--;
-    }
+    copy_small(d, s, n);
     return dst;
 }
 
@@ -0,0 +1,181 @@
+#include "gles_private.h"
+
+// OES_draw_texture.
+// The quad is given in window coordinates, so it is pushed straight to the hardware as screen space vertices with an
+// identity composite matrix. The texture coordinates come from each enabled unit's crop rectangle and are pushed
+// already scaled for the texture, with the texture matrices disabled. Neither the modelview/projection flush nor client
+// array staging is involved. The first call after a normal draw switches the hardware over and marks the transform
+// state dirty, so the next normal draw switches it back.
+
+#ifdef GL_OES_draw_texture
+static void enter_screen_space(gli_context_t *context)
+{
+    transformation_state_t *ts = &context->transformation_state;
+    if (ts->draw_texture_active) {
+        return;
+    }
+
+    // The quad is already in screen space, so it always goes through the fixed function pipeline
+    gliVertexProgramSuspend();
+
+    mat4 identity;
+    glm_mat4_identity(identity);
+    uint32_t *pb = pb_begin();
+    pb = pb_push_transposed_matrix(pb, NV097_SET_COMPOSITE_MATRIX, (const float *)identity);
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        pb = xgu_set_texture_matrix_enable(pb, i, false);
+        ts->texture_matrix_dirty[i] = GL_TRUE;
+
+        // Texgen would replace the crop rectangle coordinates. gliTextureFlush keeps it off while draw_texture_active
+        // is set and pushes it again for the next normal draw
+        pb = xgu_set_texgen_s(pb, i, XGU_TEXGEN_DISABLE);
+        pb = xgu_set_texgen_t(pb, i, XGU_TEXGEN_DISABLE);
+        pb = xgu_set_texgen_r(pb, i, XGU_TEXGEN_DISABLE);
+        context->texture_environment.texture_units[i].texture_unit_dirty = GL_TRUE;
+    }
+    pb_end(pb);
+
+    // gliTransformFlush pushes the composite matrix again and clears draw_texture_active. Clip planes also use texgen
+    ts->projection_matrix_dirty = GL_TRUE;
+    ts->clip_plane_dirty = GL_TRUE;
+    ts->draw_texture_active = GL_TRUE;
+}
+
+static void draw_texture(GLfloat x, GLfloat y, GLfloat z, GLfloat width, GLfloat height)
+{
+    gli_context_t *context = gliGetContext();
+    transformation_state_t *ts = &context->transformation_state;
+    current_values_t *cv = &context->current_values;
+
+    if (GLI_INVALID(width <= 0.0f || height <= 0.0f)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    // Everything except the transform and vertex arrays still applies to the quad
+    gliFBOFlush();
+    gliFogFlush();
+    gliTextureFlush();
+    if (ts->depth_range_dirty) {
+        xgux_set_depth_range(ts->depth_range[0] * (GLfloat)GLI_DEPTH_BUFFER_MAX,
+                             ts->depth_range[1] * (GLfloat)GLI_DEPTH_BUFFER_MAX);
+        ts->depth_range_dirty = GL_FALSE;
+    }
+    enter_screen_space(context);
+    gliCount(GLI_COUNTER_DRAW_CALLS, 1);
+    gliCount(GLI_COUNTER_VERTICES, 4);
+
+    // Texture coordinates at the left/bottom and right/top edges of the quad for each enabled unit
+    GLfloat s[GLI_MAX_TEXTURE_UNITS][2];
+    GLfloat t[GLI_MAX_TEXTURE_UNITS][2];
+    GLboolean unit_enabled[GLI_MAX_TEXTURE_UNITS];
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        texture_unit_t *texture_unit = &context->texture_environment.texture_units[i];
+        texture_object_t *texture_object = texture_unit->bound_texture_object;
+        const xgu_texture_t *xgu_texture = (texture_object) ? (const xgu_texture_t *)texture_object->texture_2d : NULL;
+
+        unit_enabled[i] = texture_unit->texture_2d_enabled && xgu_texture != NULL && xgu_texture->tex_width > 0 &&
+                          xgu_texture->tex_height > 0;
+        if (!unit_enabled[i]) {
+            continue;
+        }
+
+        const GLint *crop = texture_object->crop_rect;
+        const GLfloat u_scale = xgu_texture->u_scale / (GLfloat)xgu_texture->tex_width;
+        const GLfloat v_scale = xgu_texture->v_scale / (GLfloat)xgu_texture->tex_height;
+        s[i][0] = (GLfloat)crop[0] * u_scale;
+        s[i][1] = (GLfloat)(crop[0] + crop[2]) * u_scale;
+        t[i][0] = (GLfloat)crop[1] * v_scale;
+        t[i][1] = (GLfloat)(crop[1] + crop[3]) * v_scale;
+    }
+
+    // z is clamped to [0, 1] then mapped through the depth range
+    const GLfloat n = ts->depth_range[0];
+    const GLfloat f = ts->depth_range[1];
+    const GLfloat zw = ((z <= 0.0f) ? n : (z >= 1.0f) ? f : n + z * (f - n)) * (GLfloat)GLI_DEPTH_BUFFER_MAX;
+
+    // Screen space has y pointing down, see the viewport matrix in gliTransformFlush
+    const GLfloat sx[2] = {x, x + width};
+    const GLfloat sy[2] = {(GLfloat)context->current_surface_height - y,
+                           (GLfloat)context->current_surface_height - (y + height)};
+    static const GLubyte corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+    uint32_t *pb = pb_begin();
+
+    // The quad takes the current color, unlit
+    if (context->lighting_state.lighting_enabled) {
+        pb = xgu_set_lighting_enable(pb, false);
+    }
+
+    pb = xgu_begin(pb, XGU_QUADS);
+    for (GLuint c = 0; c < 4; c++) {
+        const GLubyte cx = corners[c][0];
+        const GLubyte cy = corners[c][1];
+        for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+            if (unit_enabled[i]) {
+                pb = xgu_set_vertex_data2f(pb, XGU_TEXCOORD0_ARRAY + i, s[i][cx], t[i][cy]);
+            }
+        }
+        pb = xgu_vertex4f(pb, sx[cx], sy[cy], zw, 1.0f);
+    }
+    pb = xgu_end(pb);
+
+    if (context->lighting_state.lighting_enabled) {
+        pb = xgu_set_lighting_enable(pb, true);
+    }
+
+    // The current texture coordinates are unaffected by DrawTex
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        if (unit_enabled[i]) {
+            pb = xgu_set_vertex_data4f(pb,
+                                       XGU_TEXCOORD0_ARRAY + i,
+                                       cv->current_texcoord[i][0],
+                                       cv->current_texcoord[i][1],
+                                       cv->current_texcoord[i][2],
+                                       cv->current_texcoord[i][3]);
+        }
+    }
+    pb_end(pb);
+}
+
+GL_API void GL_APIENTRY glDrawTexsOES(GLshort x, GLshort y, GLshort z, GLshort width, GLshort height)
+{
+    draw_texture((GLfloat)x, (GLfloat)y, (GLfloat)z, (GLfloat)width, (GLfloat)height);
+}
+
+GL_API void GL_APIENTRY glDrawTexiOES(GLint x, GLint y, GLint z, GLint width, GLint height)
+{
+    draw_texture((GLfloat)x, (GLfloat)y, (GLfloat)z, (GLfloat)width, (GLfloat)height);
+}
+
+GL_API void GL_APIENTRY glDrawTexxOES(GLfixed x, GLfixed y, GLfixed z, GLfixed width, GLfixed height)
+{
+    draw_texture(
+        gliFixedtoFloat(x), gliFixedtoFloat(y), gliFixedtoFloat(z), gliFixedtoFloat(width), gliFixedtoFloat(height));
+}
+
+GL_API void GL_APIENTRY glDrawTexfOES(GLfloat x, GLfloat y, GLfloat z, GLfloat width, GLfloat height)
+{
+    draw_texture(x, y, z, width, height);
+}
+
+GL_API void GL_APIENTRY glDrawTexsvOES(const GLshort *coords)
+{
+    glDrawTexsOES(coords[0], coords[1], coords[2], coords[3], coords[4]);
+}
+
+GL_API void GL_APIENTRY glDrawTexivOES(const GLint *coords)
+{
+    glDrawTexiOES(coords[0], coords[1], coords[2], coords[3], coords[4]);
+}
+
+GL_API void GL_APIENTRY glDrawTexxvOES(const GLfixed *coords)
+{
+    glDrawTexxOES(coords[0], coords[1], coords[2], coords[3], coords[4]);
+}
+
+GL_API void GL_APIENTRY glDrawTexfvOES(const GLfloat *coords)
+{
+    glDrawTexfOES(coords[0], coords[1], coords[2], coords[3], coords[4]);
+}
+#endif
@@ -24,48 +24,21 @@ static XguTexFormatColor unswizzle_texture_format(XguTexFormatColor format)
     }
 }
 
-framebuffer_object_t *gliFindFramebufferObject(GLuint name, framebuffer_object_t **prev)
+framebuffer_object_t *gliFindFramebufferObject(GLuint name)
 {
     gli_context_t *context = gliGetContext();
-    if (prev) {
-        *prev = NULL;
-    }
-    if (name == 0) {
-        return NULL;
-    }
-    for (framebuffer_object_t *it = context->framebuffer_objects; it != NULL; it = it->next) {
-        if (it->name == name) {
-            return it;
-        }
-        if (prev) {
-            *prev = it;
-        }
-    }
-    return NULL;
+    return (framebuffer_object_t *)gliNameLookup(&context->framebuffer_names, name);
 }
 
-renderbuffer_object_t *gliFindRenderbufferObject(GLuint name, renderbuffer_object_t **prev)
+renderbuffer_object_t *gliFindRenderbufferObject(GLuint name)
 {
     gli_context_t *context = gliGetContext();
-    if (prev) {
-        *prev = NULL;
-    }
-    if (name == 0) {
-        return NULL;
-    }
-    for (renderbuffer_object_t *it = context->renderbuffer_objects; it != NULL; it = it->next) {
-        if (it->name == name) {
-            return it;
-        }
-        if (prev) {
-            *prev = it;
-        }
-    }
-    return NULL;
+    return (renderbuffer_object_t *)gliNameLookup(&context->renderbuffer_names, name);
 }
 
 GL_API void GL_APIENTRY glGenFramebuffersOES(GLsizei n, GLuint *framebuffers)
 {
+    gli_context_t *context = gliGetContext();
     if (framebuffers == NULL) {
         gliSetError(GL_INVALID_VALUE);
         return;
@@ -74,18 +47,8 @@ GL_API void GL_APIENTRY glGenFramebuffersOES(GLsizei n, GLuint *framebuffers)
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    static GLuint next = 1;
     for (GLsizei i = 0; i < n; i++) {
-        while (1) {
-            if (next == 0) {
-                next++;
-            }
-            if (gliFindFramebufferObject(next, NULL) == NULL) {
-                break;
-            }
-            next++;
-        }
-        framebuffers[i] = next++;
+        framebuffers[i] = gliNameGen(&context->framebuffer_names);
     }
 }
 
@@ -96,7 +59,7 @@ GL_API void GL_APIENTRY glBindFramebufferOES(GLenum target, GLuint framebuffer)
         return;
     }
 
-    if (target != GL_FRAMEBUFFER_OES) {
+    if (GLI_INVALID(target != GL_FRAMEBUFFER_OES)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -113,7 +76,7 @@ GL_API void GL_APIENTRY glBindFramebufferOES(GLenum target, GLuint framebuffer)
     }
 
     // First check if the object already exists, if so just bind it to the texture_unit and we are done
-    framebuffer_object_t *fbo = gliFindFramebufferObject(framebuffer, NULL);
+    framebuffer_object_t *fbo = gliFindFramebufferObject(framebuffer);
     if (fbo != NULL) {
         if (context->fbo_binding != framebuffer) {
             context->fbo_binding = framebuffer;
@@ -134,6 +97,11 @@ GL_API void GL_APIENTRY glBindFramebufferOES(GLenum target, GLuint framebuffer)
     // The state of a framebuffer object immediately after it is first bound is three attachment points
     // (GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT, and GL_STENCIL_ATTACHMENT) each with GL_NONE as the object type.
     gli_memset(fbo, 0, sizeof(framebuffer_object_t));
+    if (!gliNameInsert(&context->framebuffer_names, framebuffer, fbo)) {
+        GLI_FREE(fbo);
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
     fbo->color.type = GL_NONE_OES;
     fbo->depth.type = GL_NONE_OES;
     fbo->stencil.type = GL_NONE_OES;
@@ -145,6 +113,9 @@ GL_API void GL_APIENTRY glBindFramebufferOES(GLenum target, GLuint framebuffer)
 
     // Add it to the context list
     fbo->next = context->framebuffer_objects;
+    if (fbo->next) {
+        fbo->next->prev = fbo;
+    }
     context->framebuffer_objects = fbo;
     context->transformation_state.viewport_dirty = GL_TRUE;
 
@@ -166,15 +137,18 @@ GL_API void GL_APIENTRY glDeleteFramebuffersOES(GLsizei n, const GLuint *framebu
 
     for (GLint i = 0; i < n; i++) {
         GLuint name = framebuffers[i];
-        framebuffer_object_t *prev = NULL;
-        framebuffer_object_t *fbo = gliFindFramebufferObject(name, &prev);
+        framebuffer_object_t *fbo = gliFindFramebufferObject(name);
+        gliNameRemove(&context->framebuffer_names, name);
         if (fbo) {
             // Remove from the context's list
-            if (prev) {
-                prev->next = fbo->next;
+            if (fbo->prev) {
+                fbo->prev->next = fbo->next;
             } else {
                 context->framebuffer_objects = fbo->next;
             }
+            if (fbo->next) {
+                fbo->next->prev = fbo->prev;
+            }
 
             // If a fbo that is currently bound is deleted, the binding reverts to 0
             if (context->fbo_binding == name) {
@@ -189,7 +163,7 @@ GL_API void GL_APIENTRY glDeleteFramebuffersOES(GLsizei n, const GLuint *framebu
 GL_API GLboolean GL_APIENTRY glIsFramebufferOES(GLuint framebuffer)
 {
     gli_context_t *context = gliGetContext();
-    framebuffer_object_t *fbo = gliFindFramebufferObject(framebuffer, NULL);
+    framebuffer_object_t *fbo = gliFindFramebufferObject(framebuffer);
     if (framebuffer == 0 || fbo == NULL) {
         return GL_FALSE;
     }
@@ -198,6 +172,7 @@ GL_API GLboolean GL_APIENTRY glIsFramebufferOES(GLuint framebuffer)
 
 GL_API void GL_APIENTRY glGenRenderbuffersOES(GLsizei n, GLuint *renderbuffers)
 {
+    gli_context_t *context = gliGetContext();
     if (renderbuffers == NULL) {
         gliSetError(GL_INVALID_VALUE);
         return;
@@ -206,18 +181,8 @@ GL_API void GL_APIENTRY glGenRenderbuffersOES(GLsizei n, GLuint *renderbuffers)
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    static GLuint next = 1;
     for (GLsizei i = 0; i < n; i++) {
-        while (1) {
-            if (next == 0) {
-                next++;
-            }
-            if (gliFindRenderbufferObject(next, NULL) == NULL) {
-                break;
-            }
-            next++;
-        }
-        renderbuffers[i] = next++;
+        renderbuffers[i] = gliNameGen(&context->renderbuffer_names);
     }
 }
 
@@ -228,7 +193,7 @@ GL_API void GL_APIENTRY glBindRenderbufferOES(GLenum target, GLuint renderbuffer
         return;
     }
 
-    if (target != GL_RENDERBUFFER_OES) {
+    if (GLI_INVALID(target != GL_RENDERBUFFER_OES)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -236,10 +201,11 @@ GL_API void GL_APIENTRY glBindRenderbufferOES(GLenum target, GLuint renderbuffer
     // If the renderbuffer name is zero just unbind from the context
     if (renderbuffer == 0) {
         context->rbo_binding = 0;
+        return;
     }
 
     // First check if the object already exists, if so just bind it to the texture_unit and we are done
-    renderbuffer_object_t *rbo = gliFindRenderbufferObject(renderbuffer, NULL);
+    renderbuffer_object_t *rbo = gliFindRenderbufferObject(renderbuffer);
     if (rbo != NULL) {
         if (context->rbo_binding != renderbuffer) {
             context->rbo_binding = renderbuffer;
@@ -257,6 +223,11 @@ GL_API void GL_APIENTRY glBindRenderbufferOES(GLenum target, GLuint renderbuffer
     // The state of a framebuffer object immediately after it is first bound is three attachment points
     // (GL_COLOR_ATTACHMENT0, GL_DEPTH_ATTACHMENT, and GL_STENCIL_ATTACHMENT) each with GL_NONE as the object type.
     gli_memset(rbo, 0, sizeof(renderbuffer_object_t));
+    if (!gliNameInsert(&context->renderbuffer_names, renderbuffer, rbo)) {
+        GLI_FREE(rbo);
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
     rbo->name = renderbuffer;
 
     // Bind the fbo to the context
@@ -264,6 +235,9 @@ GL_API void GL_APIENTRY glBindRenderbufferOES(GLenum target, GLuint renderbuffer
 
     // Add it to the context list
     rbo->next = context->renderbuffer_objects;
+    if (rbo->next) {
+        rbo->next->prev = rbo;
+    }
     context->renderbuffer_objects = rbo;
 }
 
@@ -282,15 +256,18 @@ GL_API void GL_APIENTRY glDeleteRenderbuffersOES(GLsizei n, const GLuint *render
 
     for (GLint i = 0; i < n; i++) {
         GLuint name = renderbuffers[i];
-        renderbuffer_object_t *prev = NULL;
-        renderbuffer_object_t *rbo = gliFindRenderbufferObject(name, &prev);
+        renderbuffer_object_t *rbo = gliFindRenderbufferObject(name);
+        gliNameRemove(&context->renderbuffer_names, name);
         if (rbo) {
             // Remove from the context's list
-            if (prev) {
-                prev->next = rbo->next;
+            if (rbo->prev) {
+                rbo->prev->next = rbo->next;
             } else {
                 context->renderbuffer_objects = rbo->next;
             }
+            if (rbo->next) {
+                rbo->next->prev = rbo->prev;
+            }
 
             // If a fbo that is currently bound is deleted, the binding reverts to 0
             if (context->rbo_binding == name) {
@@ -298,7 +275,8 @@ GL_API void GL_APIENTRY glDeleteRenderbuffersOES(GLsizei n, const GLuint *render
             }
 
             if (rbo->data) {
-                MmFreeContiguousMemory(rbo->data);
+                gliDeferredFree(rbo->data, rbo->data_size, PAGE_READWRITE | PAGE_WRITECOMBINE);
+                context->renderbuffer_resident_bytes -= rbo->data_size;
             }
 
             // When deleting an RBO, iterate through all FBOs in context->framebuffer_objects.
@@ -323,7 +301,7 @@ GL_API void GL_APIENTRY glDeleteRenderbuffersOES(GLsizei n, const GLuint *render
 GL_API GLboolean GL_APIENTRY glIsRenderbufferOES(GLuint renderbuffer)
 {
     gli_context_t *context = gliGetContext();
-    renderbuffer_object_t *rbo = gliFindRenderbufferObject(renderbuffer, NULL);
+    renderbuffer_object_t *rbo = gliFindRenderbufferObject(renderbuffer);
     if (renderbuffer == 0 || rbo == NULL) {
         return GL_FALSE;
     }
@@ -341,7 +319,7 @@ GL_API void GL_APIENTRY glRenderbufferStorageOES(GLenum target, GLenum internalf
         gliSetError(GL_INVALID_OPERATION);
         return;
     }
-    renderbuffer_object_t *rbo = gliFindRenderbufferObject(context->rbo_binding, NULL);
+    renderbuffer_object_t *rbo = gliFindRenderbufferObject(context->rbo_binding);
     if (!rbo) {
         gliSetError(GL_INVALID_OPERATION);
         return;
@@ -367,7 +345,8 @@ GL_API void GL_APIENTRY glRenderbufferStorageOES(GLenum target, GLenum internalf
     uint32_t bpp = gliFormatToBpp(internalformat);
 
     if (rbo->data) {
-        MmFreeContiguousMemory(rbo->data);
+        gliDeferredFree(rbo->data, rbo->data_size, PAGE_READWRITE | PAGE_WRITECOMBINE);
+        context->renderbuffer_resident_bytes -= rbo->data_size;
         rbo->data = NULL;
         rbo->data_physical_address = NULL;
     }
@@ -377,11 +356,13 @@ GL_API void GL_APIENTRY glRenderbufferStorageOES(GLenum target, GLenum internalf
     const uint32_t pitch = (width * bpp + 63) & ~63;
 
     uint32_t size = pitch * height;
-    rbo->data = MmAllocateContiguousMemoryEx(size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE | PAGE_WRITECOMBINE);
+    rbo->data = gliContiguousAlloc(size, PAGE_READWRITE | PAGE_WRITECOMBINE);
     if (!rbo->data) {
         gliSetError(GL_OUT_OF_MEMORY);
         return;
     }
+    rbo->data_size = size;
+    context->renderbuffer_resident_bytes += size;
     rbo->data_physical_address = (void *)MmGetPhysicalAddress(rbo->data);
     gli_memset(rbo->data, 0, size);
     rbo->data_physical_address = (GLubyte *)MmGetPhysicalAddress(rbo->data);
@@ -405,7 +386,7 @@ GL_API void GL_APIENTRY glFramebufferRenderbufferOES(GLenum target,
         gliSetError(GL_INVALID_OPERATION);
         return;
     }
-    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding, NULL);
+    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding);
     if (!fbo) {
         return;
     }
@@ -427,7 +408,7 @@ GL_API void GL_APIENTRY glFramebufferRenderbufferOES(GLenum target,
         att->name = 0;
         att->renderbuffer = NULL;
     } else {
-        renderbuffer_object_t *rbo = gliFindRenderbufferObject(renderbuffer, NULL);
+        renderbuffer_object_t *rbo = gliFindRenderbufferObject(renderbuffer);
         if (!rbo) {
             gliSetError(GL_INVALID_OPERATION);
             return;
@@ -456,7 +437,7 @@ glFramebufferTexture2DOES(GLenum target, GLenum attachment, GLenum textarget, GL
         gliSetError(GL_INVALID_OPERATION);
         return;
     }
-    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding, NULL);
+    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding);
     if (!fbo) {
         return;
     }
@@ -478,7 +459,7 @@ glFramebufferTexture2DOES(GLenum target, GLenum attachment, GLenum textarget, GL
         att->name = 0;
         att->texture = NULL;
     } else {
-        texture_object_t *texture_object = gliFindTextureObject(texture, NULL);
+        texture_object_t *texture_object = gliFindTextureObject(texture);
         if (!texture_object || texture_object->texture_2d == NULL) {
             gliSetError(GL_INVALID_OPERATION);
             return;
@@ -486,14 +467,25 @@ glFramebufferTexture2DOES(GLenum target, GLenum attachment, GLenum textarget, GL
 
         xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
 
+        // NV2A cannot render into block compressed formats
+        if (xgu_texture != NULL && xgu_texture->compressed) {
+            gliSetError(GL_INVALID_OPERATION);
+            return;
+        }
+
+        // Render targets are never evicted, so bring it back in if it was
+        if (!gliTextureMakeResident(texture_object)) {
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+
         // Convert swizzled textures to linear when attached to an FBO.
         // This texture will stay linear forever now. FIXME?
         if (xgu_texture && xgu_texture->swizzled) {
             uint32_t new_pitch = (xgu_texture->data_width * xgu_texture->bytes_per_pixel + 63) & ~63;
             uint32_t size = new_pitch * xgu_texture->data_height;
 
-            void *new_data =
-                MmAllocateContiguousMemoryEx(size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE | PAGE_WRITECOMBINE);
+            GLubyte *new_data = gliTextureAlloc(size);
             if (new_data) {
                 unswizzle_rect(xgu_texture->data,
                                xgu_texture->data_width,
@@ -501,9 +493,10 @@ glFramebufferTexture2DOES(GLenum target, GLenum attachment, GLenum textarget, GL
                                new_data,
                                new_pitch,
                                xgu_texture->bytes_per_pixel);
-                MmFreeContiguousMemory(xgu_texture->data);
+                gliTextureFree(xgu_texture->data, xgu_texture->data_size);
 
                 xgu_texture->data = new_data;
+                xgu_texture->data_size = size;
                 xgu_texture->data_physical_address = (void *)MmGetPhysicalAddress(new_data);
                 xgu_texture->pitch = new_pitch;
                 xgu_texture->swizzled = 0;
@@ -550,7 +543,7 @@ GL_API GLenum GL_APIENTRY glCheckFramebufferStatusOES(GLenum target)
         return GL_FRAMEBUFFER_COMPLETE_OES;
     }
 
-    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding, NULL);
+    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding);
     if (!fbo) {
         return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT_OES;
     }
@@ -602,7 +595,7 @@ GL_API void GL_APIENTRY glGetFramebufferAttachmentParameterivOES(GLenum target,
         return;
     }
 
-    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding, NULL);
+    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding);
     if (!fbo) {
         return;
     }
@@ -641,7 +634,7 @@ GL_API void GL_APIENTRY glGetRenderbufferParameterivOES(GLenum target, GLenum pn
         gliSetError(GL_INVALID_OPERATION);
         return;
     }
-    renderbuffer_object_t *rbo = gliFindRenderbufferObject(context->rbo_binding, NULL);
+    renderbuffer_object_t *rbo = gliFindRenderbufferObject(context->rbo_binding);
     if (!rbo) {
         return;
     }
@@ -765,7 +758,7 @@ void gliFBOFlush(void)
         return;
     }
 
-    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding, NULL);
+    framebuffer_object_t *fbo = gliFindFramebufferObject(context->fbo_binding);
     if (!fbo || glCheckFramebufferStatusOES(GL_FRAMEBUFFER_OES) != GL_FRAMEBUFFER_COMPLETE_OES) {
         return;
     }
@@ -0,0 +1,250 @@
+#include "gles_private.h"
+
+// GPU fences and deferred destruction of contiguous memory.
+// A fence is a 32-bit value written by the NV2A back end to a semaphore in memory once everything pushed before it has
+// finished rendering. Memory the GPU may still read (textures, buffers, renderbuffers) is not freed straight away when
+// deleted. It is queued with a fence instead, and only returned to the kernel once the GPU has passed that fence.
+
+// Channel 20 and 21 are used by gliFBOFlush
+#define FENCE_DMA_CHANNEL 22
+
+void gliFenceInit(void)
+{
+    gli_context_t *context = gliGetContext();
+
+    context->fence_semaphore =
+        MmAllocateContiguousMemoryEx(0x1000, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE | PAGE_WRITECOMBINE);
+    assert(context->fence_semaphore != NULL);
+    *context->fence_semaphore = 0;
+    context->fence_semaphore_physical_address = (GLuint)MmGetPhysicalAddress((void *)context->fence_semaphore);
+    context->fence_value = 0;
+
+    pb_create_dma_ctx(FENCE_DMA_CHANNEL, DMA_CLASS_3D, 0, MAXRAM, &context->fence_dma);
+    pb_bind_channel(&context->fence_dma);
+}
+
+GLuint gliFenceInsert(void)
+{
+    gli_context_t *context = gliGetContext();
+    const GLuint value = ++context->fence_value;
+
+    // The semaphore context is re-sent each time as pbkit may point it elsewhere
+    uint32_t *pb = pb_begin();
+    pb = pb_push1(pb, NV097_SET_CONTEXT_DMA_SEMAPHORE, context->fence_dma.ChannelID);
+    pb = pb_push1(pb, NV097_SET_SEMAPHORE_OFFSET, context->fence_semaphore_physical_address);
+    pb = pb_push1(pb, NV097_BACK_END_WRITE_SEMAPHORE_RELEASE, value);
+    pb_end(pb);
+    return value;
+}
+
+GLboolean gliFenceReached(GLuint value)
+{
+    gli_context_t *context = gliGetContext();
+    // Signed difference so the comparison survives the counter wrapping
+    return ((int32_t)(*context->fence_semaphore - value) >= 0) ? GL_TRUE : GL_FALSE;
+}
+
+void gliFenceWait(GLuint value)
+{
+    while (!gliFenceReached(value)) {
+        gliTimerPoll();
+        NtYieldExecution();
+    }
+    gliTimerPoll();
+}
+
+// Free every queued block the GPU has finished with. If wait is set, block until the GPU has finished with all of them
+void gliDeferredDrain(GLboolean wait)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (context->deferred_free_count == 0) {
+        return;
+    }
+
+    // Fences are queued in increasing order, so the newest one covers everything
+    if (wait) {
+        gliFenceWait(context->deferred_frees[context->deferred_free_count - 1].fence);
+    }
+
+    GLuint kept = 0;
+    for (GLuint i = 0; i < context->deferred_free_count; i++) {
+        deferred_free_t *entry = &context->deferred_frees[i];
+        if (gliFenceReached(entry->fence)) {
+            MmFreeContiguousMemory(entry->data);
+            context->deferred_free_bytes -= entry->size;
+        } else {
+            context->deferred_frees[kept++] = *entry;
+        }
+    }
+    context->deferred_free_count = kept;
+}
+
+void gliDeferredFree(void *data, GLuint size, ULONG protect)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (data == NULL) {
+        return;
+    }
+
+    if (context->deferred_free_count == GLI_MAX_DEFERRED_FREES) {
+        gliDeferredDrain(GL_TRUE);
+    }
+
+    deferred_free_t *entry = &context->deferred_frees[context->deferred_free_count++];
+    entry->data = data;
+    entry->size = size;
+    entry->protect = protect;
+    entry->fence = gliFenceInsert();
+    context->deferred_free_bytes += size;
+}
+
+// Allocate contiguous memory for the GPU. A retired block of the same size and type is reused directly if the GPU is
+// done with it, which saves a trip through the kernel allocator for the common delete then recreate pattern.
+// If the kernel is out of memory, wait for the queued blocks to retire and try again.
+void *gliContiguousAlloc(GLuint size, ULONG protect)
+{
+    gli_context_t *context = gliGetContext();
+
+    for (GLuint i = 0; i < context->deferred_free_count; i++) {
+        deferred_free_t *entry = &context->deferred_frees[i];
+        if (entry->size == size && entry->protect == protect && gliFenceReached(entry->fence)) {
+            void *data = entry->data;
+            context->deferred_free_bytes -= size;
+            // Keep the queue in fence order
+            context->deferred_free_count--;
+            for (GLuint j = i; j < context->deferred_free_count; j++) {
+                context->deferred_frees[j] = context->deferred_frees[j + 1];
+            }
+            return data;
+        }
+    }
+
+    void *data = MmAllocateContiguousMemoryEx(size, 0, 0xFFFFFFFF, 0x1000, protect);
+    if (data == NULL && context->deferred_free_count > 0) {
+        gliDeferredDrain(GL_TRUE);
+        data = MmAllocateContiguousMemoryEx(size, 0, 0xFFFFFFFF, 0x1000, protect);
+    }
+    return data;
+}
+
+// NV_fence. Each fence object just remembers the fence value from its last glSetFenceNV
+static fence_object_t *find_fence_object(GLuint name)
+{
+    gli_context_t *context = gliGetContext();
+    return (fence_object_t *)gliNameLookup(&context->fence_names, name);
+}
+
+GL_API void GL_APIENTRY glGenFencesNV(GLsizei n, GLuint *fences)
+{
+    gli_context_t *context = gliGetContext();
+    if (fences == NULL || n < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    // The fence object itself is created by the first glSetFenceNV
+    for (GLsizei i = 0; i < n; i++) {
+        fences[i] = gliNameGen(&context->fence_names);
+    }
+}
+
+GL_API void GL_APIENTRY glDeleteFencesNV(GLsizei n, const GLuint *fences)
+{
+    gli_context_t *context = gliGetContext();
+    if (fences == NULL || n < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    for (GLsizei i = 0; i < n; i++) {
+        fence_object_t *fence = find_fence_object(fences[i]);
+        gliNameRemove(&context->fence_names, fences[i]);
+        if (fence) {
+            GLI_FREE(fence);
+        }
+    }
+}
+
+GL_API GLboolean GL_APIENTRY glIsFenceNV(GLuint fence)
+{
+    return (fence != 0 && find_fence_object(fence) != NULL) ? GL_TRUE : GL_FALSE;
+}
+
+GL_API void GL_APIENTRY glSetFenceNV(GLuint fence, GLenum condition)
+{
+    gli_context_t *context = gliGetContext();
+    if (condition != GL_ALL_COMPLETED_NV) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (fence == 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    fence_object_t *fence_object = find_fence_object(fence);
+    if (fence_object == NULL) {
+        fence_object = GLI_MALLOC(sizeof(fence_object_t));
+        if (fence_object == NULL) {
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+        if (!gliNameInsert(&context->fence_names, fence, fence_object)) {
+            GLI_FREE(fence_object);
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+
+    fence_object->condition = condition;
+    fence_object->fence = gliFenceInsert();
+}
+
+GL_API GLboolean GL_APIENTRY glTestFenceNV(GLuint fence)
+{
+    fence_object_t *fence_object = find_fence_object(fence);
+    if (fence_object == NULL) {
+        gliSetError(GL_INVALID_OPERATION);
+        return GL_TRUE;
+    }
+    return gliFenceReached(fence_object->fence);
+}
+
+GL_API void GL_APIENTRY glFinishFenceNV(GLuint fence)
+{
+    fence_object_t *fence_object = find_fence_object(fence);
+    if (fence_object == NULL) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+    gliFenceWait(fence_object->fence);
+}
+
+GL_API void GL_APIENTRY glGetFenceivNV(GLuint fence, GLenum pname, GLint *params)
+{
+    fence_object_t *fence_object = find_fence_object(fence);
+    if (fence_object == NULL) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    if (params == NULL) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    switch (pname) {
+        case GL_FENCE_STATUS_NV:
+            params[0] = gliFenceReached(fence_object->fence);
+            break;
+        case GL_FENCE_CONDITION_NV:
+            params[0] = (GLint)fence_object->condition;
+            break;
+        default:
+            gliSetError(GL_INVALID_ENUM);
+            break;
+    }
+}
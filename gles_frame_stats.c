@@ -0,0 +1,107 @@
+#include "gles_private.h"
+
+// Per frame present statistics for glGetFrameStatsNV2A.
+// glFlipNV2A ends each frame with a timer marker (see gles_query.c), so the time the GPU finished the frame comes from
+// the timestamp of the frame's report, however long after that the CPU notices. The GPU is taken to start a frame when
+// the CPU starts building it, or when the GPU finished the previous frame if that was later. A frame is only reported
+// once its marker has passed. Without report timestamps the completion time is when the CPU saw the fence pass. A
+// flip that doesn't wait for the frame leaves that until the next frame's first draw or wait, so the busy time is then
+// only an upper bound and the idle time a lower bound.
+
+static frame_stats_t *frame_stats_entry(gli_context_t *context, GLuint frame)
+{
+    return &context->frame_stats[frame % GLI_FRAME_STATS_HISTORY];
+}
+
+// Record the frame being ended by glFlipNV2A and queue its marker. Returns the marker's fence
+GLuint gliFrameStatsSubmit(uint64_t flip_tsc)
+{
+    gli_context_t *context = gliGetContext();
+    frame_stats_t *stats = frame_stats_entry(context, context->frame_count);
+
+    // The entry is reused GLI_FRAME_STATS_HISTORY frames later. Its marker points here, so it has to retire first
+    if (stats->complete_tsc == 0) {
+        gliFenceWait(stats->fence);
+    }
+
+    stats->frame = context->frame_count;
+    stats->begin_tsc = context->frame_begin_tsc;
+    stats->flip_tsc = flip_tsc;
+    stats->finish_wait_tsc = context->frame_finish_wait_tsc;
+    stats->fence = gliTimerMarkerInsert(&stats->complete_tsc, GLI_REPORT_FRAME(context->frame_count));
+    return stats->fence;
+}
+
+// Called once glFlipNV2A has queued the flip and advanced frame_count. Starts the next frame's statistics and counters
+void gliFrameStatsFlipDone(GLint swap_interval)
+{
+    gli_context_t *context = gliGetContext();
+    frame_stats_t *stats = frame_stats_entry(context, context->frame_count - 1);
+    const uint64_t now = gliReadTsc();
+    const GLuint vbl = (GLuint)pb_get_vbl_counter();
+
+    // A swap interval of 0 still can't flip more than once per vblank
+    const GLuint expected = (swap_interval > 0) ? (GLuint)swap_interval : 1;
+    const GLuint elapsed = vbl - context->frame_end_vbl;
+    stats->missed_vblanks = (stats->frame > 0 && elapsed > expected) ? elapsed - expected : 0;
+    stats->pushbuffer_words = context->frame_counters[GLI_COUNTER_PUSHBUFFER_WORDS];
+    stats->flip_end_tsc = now;
+
+    context->frame_end_vbl = vbl;
+    context->frame_begin_tsc = now;
+    context->frame_finish_wait_tsc = 0;
+
+    // The GL_NV2A_frame_counters enums read the frame just finished
+    for (GLuint i = 0; i < GLI_COUNTER_COUNT; i++) {
+        context->last_frame_counters[i] = context->frame_counters[i];
+        context->frame_counters[i] = 0;
+    }
+}
+
+GLint glGetFrameStatsNV2A(GLint count, GLframeStatsNV2A *stats)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (count < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return 0;
+    }
+
+    gliTimerPoll();
+
+    const GLuint history = (context->frame_count < GLI_FRAME_STATS_HISTORY) ? context->frame_count
+                                                                             : GLI_FRAME_STATS_HISTORY;
+    GLint filled = 0;
+    for (GLuint i = 0; i < history && filled < count; i++) {
+        const GLuint frame = context->frame_count - 1 - i;
+        const frame_stats_t *entry = frame_stats_entry(context, frame);
+        if (entry->complete_tsc == 0) {
+            continue; // Still on the GPU
+        }
+
+        // The previous frame has always passed its marker before this one, unless it fell out of the history
+        uint64_t gpu_start_tsc = entry->begin_tsc;
+        uint64_t gpu_idle_tsc = 0;
+        if (i + 1 < history) {
+            const uint64_t previous_complete_tsc = frame_stats_entry(context, frame - 1)->complete_tsc;
+            if (previous_complete_tsc > gpu_start_tsc) {
+                gpu_start_tsc = previous_complete_tsc;
+            } else {
+                gpu_idle_tsc = gpu_start_tsc - previous_complete_tsc;
+            }
+        }
+
+        GLframeStatsNV2A *out = &stats[filled++];
+        out->frame = entry->frame;
+        out->cpu_time_ns = gliTscToNanoseconds(entry->flip_tsc - entry->begin_tsc);
+        out->flip_wait_ns = gliTscToNanoseconds(entry->flip_end_tsc - entry->flip_tsc);
+        out->finish_wait_ns = gliTscToNanoseconds(entry->finish_wait_tsc);
+        // The clocks can drift apart slightly, so a frame the GPU finished quickly may seem to end before it began
+        out->gpu_busy_ns =
+            (entry->complete_tsc > gpu_start_tsc) ? gliTscToNanoseconds(entry->complete_tsc - gpu_start_tsc) : 0;
+        out->gpu_idle_ns = gliTscToNanoseconds(gpu_idle_tsc);
+        out->missed_vblanks = entry->missed_vblanks;
+        out->pushbuffer_words = entry->pushbuffer_words;
+    }
+    return filled;
+}
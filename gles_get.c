@@ -149,6 +149,38 @@ GL_API void GL_APIENTRY glGetIntegerv(GLenum pname, GLint *data)
     }
 }
 
+#ifdef GL_EXT_disjoint_timer_query
+GL_API void GL_APIENTRY glGetInteger64vEXT(GLenum pname, GLint64 *data)
+{
+    if (data == NULL) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    // The current time on the same clock as timer queries
+    if (pname == GL_TIMESTAMP_EXT) {
+        // On the PTIMER clock timer query results use, by way of the offset gliQueryInit measured
+        data[0] = (GLint64)gliTscToGpuTime(gliReadTsc());
+        return;
+    }
+
+    enum gli_get_type element_type;
+    GLint element_count;
+    gliGetElementPtr(pname, &element_type, &element_count);
+    if (element_type == -1 || element_count == -1) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    GLint idata[16];
+    assert(element_count <= (GLint)GLI_ARRAY_SIZE(idata));
+    glGetIntegerv(pname, idata);
+    for (GLint i = 0; i < element_count; i++) {
+        data[i] = idata[i];
+    }
+}
+#endif
+
 GL_API void GL_APIENTRY glGetFloatv(GLenum pname, GLfloat *data)
 {
     enum gli_get_type element_type;
@@ -240,6 +272,14 @@ GL_API void GL_APIENTRY glGetPointerv(GLenum pname, void **params)
         case GL_POINT_SIZE_ARRAY_POINTER_OES:
             *params = (void *)context->vertex_array_data.point_size_array_ptr;
             return;
+#ifdef GL_OES_matrix_palette
+        case GL_MATRIX_INDEX_ARRAY_POINTER_OES:
+            *params = (void *)context->vertex_array_data.matrix_index_array_ptr;
+            return;
+        case GL_WEIGHT_ARRAY_POINTER_OES:
+            *params = (void *)context->vertex_array_data.weight_array_ptr;
+            return;
+#endif
         case GL_TEXTURE_COORD_ARRAY_POINTER:
             *params = (void *)context->vertex_array_data
                           .texcoord_array_ptr[context->vertex_array_data.client_active_texture - GL_TEXTURE0];
@@ -527,6 +567,58 @@ static const void *gliGetElementPtr(GLenum pname, enum gli_get_type *element_typ
             *element_type = GLI_INT;
             *element_count = 1;
             return &context->rasterization_state.cull_front_face;
+#ifdef GL_EXT_disjoint_timer_query
+        case GL_GPU_DISJOINT_EXT:
+            // params returns a single boolean value indicating whether timer query results may be invalid. PTIMER and
+            // the CPU time stamp counter both run at a fixed rate, so they never are.
+            static GLboolean gpu_disjoint = GL_FALSE;
+            *element_type = GLI_BOOLEAN;
+            *element_count = 1;
+            return &gpu_disjoint;
+#endif
+#ifdef GL_NV2A_frame_counters
+        case GL_FRAME_DRAW_CALLS_NV2A:
+        case GL_FRAME_VERTICES_NV2A:
+        case GL_FRAME_INDICES_NV2A:
+        case GL_FRAME_STAGED_BYTES_NV2A:
+        case GL_FRAME_STAGING_WRAPS_NV2A:
+        case GL_FRAME_TEXTURE_UPLOADS_NV2A:
+        case GL_FRAME_TEXTURE_UPLOAD_BYTES_NV2A:
+        case GL_FRAME_COMBINER_UPDATES_NV2A:
+        case GL_FRAME_STATE_FLUSHES_NV2A:
+        case GL_FRAME_EMPTY_STATE_FLUSHES_NV2A:
+        case GL_FRAME_PUSHBUFFER_WORDS_NV2A:
+            // params returns one value, the counter over the last frame. The enums follow gli_counter_t
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->last_frame_counters[pname - GL_FRAME_DRAW_CALLS_NV2A];
+        case GL_TEXTURE_MEMORY_NV2A:
+            // params returns one value, the bytes of contiguous memory held by resident textures
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->texture_resident_bytes;
+        case GL_BUFFER_MEMORY_NV2A:
+            // params returns one value, the bytes of contiguous memory held by buffer objects
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->buffer_resident_bytes;
+        case GL_RENDERBUFFER_MEMORY_NV2A:
+            // params returns one value, the bytes of contiguous memory held by renderbuffers
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->renderbuffer_resident_bytes;
+        case GL_STAGING_MEMORY_NV2A:
+            // params returns one value, the size of the client array staging arena
+            static const GLuint staging_memory = GLI_STAGING_ARENA_SIZE;
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &staging_memory;
+        case GL_PENDING_FREE_MEMORY_NV2A:
+            // params returns one value, the bytes of deleted objects waiting for the GPU before they are freed
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->deferred_free_bytes;
+#endif
         case GL_GREEN_BITS: {
             // params returns one value, the number of green bitplanes in the color buffer.
             *element_type = GLI_INT;
@@ -557,6 +649,68 @@ static const void *gliGetElementPtr(GLenum pname, enum gli_get_type *element_typ
             *element_type = GLI_INT;
             *element_count = 1;
             return &context->rbo_binding;
+        case GL_VERTEX_ARRAY_BINDING_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_binding;
+#ifdef GL_OES_matrix_palette
+        case GL_MATRIX_PALETTE_OES:
+            *element_type = GLI_BOOLEAN;
+            *element_count = 1;
+            return &context->transformation_state.matrix_palette_enabled;
+        case GL_MAX_PALETTE_MATRICES_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->implementation_limits.max_palette_matrices;
+        case GL_MAX_VERTEX_UNITS_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->implementation_limits.max_vertex_units;
+        case GL_CURRENT_PALETTE_MATRIX_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->transformation_state.current_palette_matrix;
+        case GL_MATRIX_INDEX_ARRAY_OES:
+            *element_type = GLI_BOOLEAN;
+            *element_count = 1;
+            return &context->vertex_array_data.matrix_index_array_enabled;
+        case GL_MATRIX_INDEX_ARRAY_BUFFER_BINDING_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_data.matrix_index_array_buffer_binding;
+        case GL_MATRIX_INDEX_ARRAY_SIZE_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_data.matrix_index_array_size;
+        case GL_MATRIX_INDEX_ARRAY_STRIDE_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_data.matrix_index_array_stride;
+        case GL_MATRIX_INDEX_ARRAY_TYPE_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_data.matrix_index_array_type;
+        case GL_WEIGHT_ARRAY_OES:
+            *element_type = GLI_BOOLEAN;
+            *element_count = 1;
+            return &context->vertex_array_data.weight_array_enabled;
+        case GL_WEIGHT_ARRAY_BUFFER_BINDING_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_data.weight_array_buffer_binding;
+        case GL_WEIGHT_ARRAY_SIZE_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_data.weight_array_size;
+        case GL_WEIGHT_ARRAY_STRIDE_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_data.weight_array_stride;
+        case GL_WEIGHT_ARRAY_TYPE_OES:
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->vertex_array_data.weight_array_type;
+#endif
         case GL_LIGHT_MODEL_AMBIENT:
             // params returns four values: the red, green, blue, and alpha components of the ambient intensity of the
             // entire scene. See glLightModel.
@@ -993,6 +1147,36 @@ static const void *gliGetElementPtr(GLenum pname, enum gli_get_type *element_typ
             *element_type = GLI_INT;
             *element_count = 1;
             return &context->texture_environment.texture_units[tu].texture_binding_2d;
+#ifdef GL_OES_texture_cube_map
+        case GL_TEXTURE_CUBE_MAP_OES:
+            // params returns a single boolean value indicating whether cube map texturing is enabled for the active
+            // texture unit. The initial value is GL_FALSE.
+            *element_type = GLI_BOOLEAN;
+            *element_count = 1;
+            return &context->texture_environment.texture_units[tu].texture_cube_map_enabled;
+        case GL_TEXTURE_BINDING_CUBE_MAP_OES:
+            // params returns one value, the name of the texture currently bound to the target GL_TEXTURE_CUBE_MAP_OES.
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->texture_environment.texture_units[tu].texture_binding_cube_map;
+        case GL_TEXTURE_GEN_STR_OES:
+            // params returns a single boolean value indicating whether texture coordinate generation is enabled for
+            // the active texture unit. The initial value is GL_FALSE. See glTexGenOES.
+            *element_type = GLI_BOOLEAN;
+            *element_count = 1;
+            return &context->texture_environment.texture_units[tu].texgen_enabled;
+        case GL_MAX_CUBE_MAP_TEXTURE_SIZE_OES:
+            // params returns one value, the largest cube map face the GL can handle.
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->implementation_limits.max_cube_map_texture_size;
+#endif
+        case GL_TEXTURE_COMPRESSION_HINT:
+            // params returns one value, a symbolic constant indicating the mode of the texture compression hint. See
+            // glHint.
+            *element_type = GLI_INT;
+            *element_count = 1;
+            return &context->hints_state.texture_compression_hint;
         case GL_TEXTURE_COORD_ARRAY:
             // params returns a single boolean value indicating whether the texture coordinate array is enabled. The
             // initial value is GL_FALSE. See glTexCoordPointer.
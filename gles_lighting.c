@@ -456,6 +456,11 @@ void gliLightingFlush(void)
 
     material_t *materials[2] = {&lighting->material_front, &lighting->material_back};
 
+    if (materials[0]->material_dirty || materials[1]->material_dirty || lighting->lighting_model_dirty ||
+        lighting->light_mask_dirty) {
+        context->vertex_program_state.lighting_dirty = GL_TRUE;
+    }
+
     // github.com/abaire/nxdk_pgraph_tests/blob/5920c89548e47675f28c7e347f07fc3ee54a4709/src/tests/material_color_tests.cpp
     if (materials[0]->material_dirty || materials[1]->material_dirty || lighting->lighting_model_dirty) {
         uint32_t *pb = pb_begin();
@@ -518,6 +523,7 @@ void gliLightingFlush(void)
 
         if (light->light_dirty || lighting->lighting_model_dirty) {
             lighting->light_mask_dirty = GL_TRUE;
+            context->vertex_program_state.lighting_dirty = GL_TRUE;
             // If w == 0, it's a directional light
             if (light->position[3] == 0) {
                 light_mask &= ~(0x03 << light_mask_shift);
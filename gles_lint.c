@@ -0,0 +1,115 @@
+#include "gles_private.h"
+
+// Redundant state lint. Define GLI_LINT as 1 to have the entry points watch for call patterns that cost CPU or GPU time
+// for nothing, such as setting state to the value it already has or drawing with client side indices. Each one is
+// counted against the address the entry point returns to, and every GLI_LINT_REPORT_FRAMES frames glFlipNV2A prints
+// the worst call sites through gliDebugF. Map the addresses to source lines with addr2line or the linker map.
+// With GLI_LINT at 0 the checks compile away.
+
+#if GLI_LINT
+static const char *const issue_names[GLI_LINT_COUNT] = {
+    "redundant glEnable/glDisable",
+    "redundant glBindTexture",
+    "redundant glBlendFunc",
+    "glTexParameter to its current value",
+    "glTexParameter re-dirtied a texture",
+    "gl*Pointer to the current array",
+    "glDrawElements with client indices",
+    "glFinish",
+};
+
+void gliLintRecord(gli_lint_t issue, const void *site)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (context->lint_sites == NULL) {
+        context->lint_sites = GLI_MALLOC(GLI_LINT_SITES * sizeof(lint_site_t));
+        if (context->lint_sites == NULL) {
+            return;
+        }
+        gli_memset(context->lint_sites, 0, GLI_LINT_SITES * sizeof(lint_site_t));
+    }
+
+    // Open addressing on the call site and issue
+    GLuint slot = (((uintptr_t)site >> 2) ^ (issue * 0x9E3779B1u)) & (GLI_LINT_SITES - 1);
+    for (GLuint probe = 0; probe < GLI_LINT_SITES; probe++, slot = (slot + 1) & (GLI_LINT_SITES - 1)) {
+        lint_site_t *entry = &context->lint_sites[slot];
+        if (entry->site == NULL) {
+            entry->site = site;
+            entry->issue = issue;
+        } else if (entry->site != site || entry->issue != issue) {
+            continue;
+        }
+        entry->calls++;
+        if (entry->frames == 0 || entry->last_frame != context->frame_count) {
+            entry->frames++;
+            entry->last_frame = context->frame_count;
+        }
+        return;
+    }
+    context->lint_dropped++;
+}
+
+void gliLintReset(void)
+{
+    gli_context_t *context = gliGetContext();
+    if (context->lint_sites != NULL) {
+        gli_memset(context->lint_sites, 0, GLI_LINT_SITES * sizeof(lint_site_t));
+    }
+    context->lint_frames = 0;
+    context->lint_dropped = 0;
+}
+
+// Print the call sites with the most calls since the last report, then start counting again
+static void lint_report(gli_context_t *context)
+{
+    lint_site_t *sites = context->lint_sites;
+    const GLuint frames = context->lint_frames;
+
+    // Move the used slots to the front. The table is cleared after the report so the hashing doesn't need to hold
+    GLuint used = 0;
+    for (GLuint i = 0; i < GLI_LINT_SITES; i++) {
+        if (sites[i].site != NULL) {
+            sites[used++] = sites[i];
+        }
+    }
+
+    gliDebugF("[gles] lint: %u call sites over %u frames\n", used, frames);
+    const GLuint top = GLI_MIN(used, (GLuint)GLI_LINT_REPORT_TOP);
+    for (GLuint i = 0; i < top; i++) {
+        GLuint worst = i;
+        for (GLuint j = i + 1; j < used; j++) {
+            if (sites[j].calls > sites[worst].calls) {
+                worst = j;
+            }
+        }
+        const lint_site_t entry = sites[worst];
+        sites[worst] = sites[i];
+        sites[i] = entry;
+
+        const GLuint per_frame_x100 = (GLuint)((uint64_t)entry.calls * 100 / frames);
+        gliDebugF("[gles] lint: %8u calls %5u.%02u/frame in %4u frames  %-36s at %p\n",
+                  entry.calls,
+                  per_frame_x100 / 100,
+                  per_frame_x100 % 100,
+                  entry.frames,
+                  issue_names[entry.issue],
+                  entry.site);
+    }
+    if (context->lint_dropped > 0) {
+        gliDebugF("[gles] lint: %u calls not counted, raise GLI_LINT_SITES\n", context->lint_dropped);
+    }
+}
+
+void gliLintFlip(void)
+{
+    gli_context_t *context = gliGetContext();
+    if (++context->lint_frames < GLI_LINT_REPORT_FRAMES) {
+        return;
+    }
+    if (context->lint_sites != NULL) {
+        lint_report(context);
+    }
+    gliLintReset();
+}
+#endif
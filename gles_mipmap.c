@@ -31,6 +31,41 @@ void gliCalcMipmapChain(GLuint width, GLuint height, GLuint bytes_per_pixel, GLu
     }
 }
 
+// Block compressed levels round up to whole 4x4 blocks, so the smallest levels still occupy one block
+GLuint gliCompressedLevelSize(GLuint width, GLuint height, GLuint block_size)
+{
+    return GLI_MAX(1, (width + 3) / 4) * GLI_MAX(1, (height + 3) / 4) * block_size;
+}
+
+void gliCalcCompressedMipmapChain(GLuint width, GLuint height, GLuint block_size, GLuint *out_size, uint8_t *out_levels)
+{
+    GLuint size = 0;
+    uint8_t levels = 0;
+    GLuint w = width;
+    GLuint h = height;
+
+    while (w > 0 && h > 0) {
+        size += gliCompressedLevelSize(w, h, block_size);
+        levels++;
+        if (w == 1 && h == 1) {
+            break;
+        }
+        if (w > 1) {
+            w /= 2;
+        }
+        if (h > 1) {
+            h /= 2;
+        }
+    }
+
+    if (out_size) {
+        *out_size = size;
+    }
+    if (out_levels) {
+        *out_levels = levels;
+    }
+}
+
 // Simple box filter to generate the next mipmap level
 static void generate_next_mipmap_level(const GLubyte *src, GLuint src_w, GLuint src_h, GLuint bpp, GLubyte *dst)
 {
@@ -61,6 +96,71 @@ static void generate_next_mipmap_level(const GLubyte *src, GLuint src_w, GLuint
     }
 }
 
+// Box filter for 16-bit packed formats, where channels don't sit on byte boundaries.
+// Each channel is described by its shift and width, a width of 0 marks an unused channel
+static void generate_next_mipmap_level_packed16(
+    const uint16_t *src, GLuint src_w, GLuint src_h, const uint8_t shift[4], const uint8_t bits[4], uint16_t *dst)
+{
+    GLuint dst_w = src_w > 1 ? src_w / 2 : 1;
+    GLuint dst_h = src_h > 1 ? src_h / 2 : 1;
+
+    for (GLuint y = 0; y < dst_h; y++) {
+        for (GLuint x = 0; x < dst_w; x++) {
+            uint16_t out = 0;
+            for (GLuint c = 0; c < 4; c++) {
+                if (bits[c] == 0) {
+                    continue;
+                }
+                const GLuint mask = (1 << bits[c]) - 1;
+                GLuint sum = 0;
+                GLuint count = 0;
+
+                // Sample 2x2 box
+                for (GLuint sy = 0; sy < 2; sy++) {
+                    for (GLuint sx = 0; sx < 2; sx++) {
+                        GLuint px = x * 2 + sx;
+                        GLuint py = y * 2 + sy;
+                        if (px < src_w && py < src_h) {
+                            sum += (src[py * src_w + px] >> shift[c]) & mask;
+                            count++;
+                        }
+                    }
+                }
+
+                out |= (uint16_t)((((sum + count / 2) / count) & mask) << shift[c]);
+            }
+            dst[y * dst_w + x] = out;
+        }
+    }
+}
+
+static void generate_next_mipmap_level_for_format(
+    const GLubyte *src, GLuint src_w, GLuint src_h, GLuint bpp, XguTexFormatColor format, GLubyte *dst)
+{
+    static const uint8_t shift_565[4] = {11, 5, 0, 0}, bits_565[4] = {5, 6, 5, 0};
+    static const uint8_t shift_1555[4] = {10, 5, 0, 15}, bits_1555[4] = {5, 5, 5, 1};
+    static const uint8_t shift_4444[4] = {8, 4, 0, 12}, bits_4444[4] = {4, 4, 4, 4};
+
+    switch (format) {
+        case XGU_TEXTURE_FORMAT_R5G6B5_SWIZZLED:
+            generate_next_mipmap_level_packed16(
+                (const uint16_t *)src, src_w, src_h, shift_565, bits_565, (uint16_t *)dst);
+            break;
+        case XGU_TEXTURE_FORMAT_A1R5G5B5_SWIZZLED:
+        case XGU_TEXTURE_FORMAT_X1R5G5B5_SWIZZLED:
+            generate_next_mipmap_level_packed16(
+                (const uint16_t *)src, src_w, src_h, shift_1555, bits_1555, (uint16_t *)dst);
+            break;
+        case XGU_TEXTURE_FORMAT_A4R4G4B4_SWIZZLED:
+            generate_next_mipmap_level_packed16(
+                (const uint16_t *)src, src_w, src_h, shift_4444, bits_4444, (uint16_t *)dst);
+            break;
+        default:
+            generate_next_mipmap_level(src, src_w, src_h, bpp, dst);
+            break;
+    }
+}
+
 // Swizzled texture auto-generator
 void gliGenSwizzledMipmaps(xgu_texture_t *xgu_texture)
 {
@@ -97,7 +197,8 @@ void gliGenSwizzledMipmaps(xgu_texture_t *xgu_texture)
             return;
         }
 
-        generate_next_mipmap_level(current_src, current_w, current_h, bpp, unswizzled_next);
+        generate_next_mipmap_level_for_format(
+            current_src, current_w, current_h, bpp, xgu_texture->format, unswizzled_next);
 
         // Swizzle directly into the xgu_texture->data buffer
         swizzle_rect(unswizzled_next, next_w, next_h, dst_swizzled, next_w * bpp, bpp);
@@ -139,12 +240,18 @@ GL_API void GL_APIENTRY glGenerateMipmapOES(GLenum target)
 
     xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
 
-    // Mipmaps require swizzled textures (which in turn requires power-of-two)
-    if (!xgu_texture->swizzled) {
+    // Mipmaps require swizzled textures (which in turn requires power-of-two). Compressed textures must provide
+    // their own levels with glCompressedTexImage2D
+    if (!xgu_texture->swizzled || xgu_texture->compressed) {
         gliSetError(GL_INVALID_OPERATION);
         return;
     }
 
+    if (!gliTextureMakeResident(texture_object)) {
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
+
     // Check if we need to reallocate memory for the mipmap chain
     GLuint required_size;
     uint8_t required_levels;
@@ -155,8 +262,7 @@ GL_API void GL_APIENTRY glGenerateMipmapOES(GLenum target)
                        &required_levels);
 
     if (xgu_texture->data_size < required_size) {
-        GLubyte *new_data =
-            MmAllocateContiguousMemoryEx(required_size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE | PAGE_WRITECOMBINE);
+        GLubyte *new_data = gliTextureAlloc(required_size);
         if (!new_data) {
             gliSetError(GL_OUT_OF_MEMORY);
             return;
@@ -166,7 +272,7 @@ GL_API void GL_APIENTRY glGenerateMipmapOES(GLenum target)
         GLuint base_size = xgu_texture->data_width * xgu_texture->data_height * xgu_texture->bytes_per_pixel;
         gli_memcpy(new_data, xgu_texture->data, base_size);
 
-        MmFreeContiguousMemory(xgu_texture->data);
+        gliTextureFree(xgu_texture->data, xgu_texture->data_size);
         xgu_texture->data = new_data;
         xgu_texture->data_size = required_size;
         xgu_texture->data_physical_address = (GLubyte *)MmGetPhysicalAddress(xgu_texture->data);
@@ -0,0 +1,235 @@
+#include "gles_private.h"
+
+// Object name tables, shared by textures, buffers, framebuffers and renderbuffers.
+// Names from glGen* are small and dense, so they index straight into a growable array. Apps are also free to bind
+// any name they like without generating it first, so names past GLI_NAME_TABLE_DENSE_MAX go into an open addressed
+// hash table instead of growing the array without bound. Deleted names are kept on a free list and handed out again
+// by gliNameGen before new ones.
+
+#define HASH_MIN_CAPACITY 64
+
+// Stored against names handed out by gliNameGen that have not been bound yet, so they are not handed out twice
+static GLubyte reserved_name;
+#define RESERVED ((void *)&reserved_name)
+
+static inline GLuint hash_name(GLuint name, GLuint mask)
+{
+    // Fibonacci hashing spreads runs of consecutive names across the table
+    return (name * 2654435769u) & mask;
+}
+
+static GLboolean grow_dense(gli_name_table_t *table, GLuint name)
+{
+    GLuint capacity = GLI_MAX(table->dense_capacity, 64);
+    while (capacity <= name) {
+        capacity *= 2;
+    }
+    capacity = GLI_MIN(capacity, GLI_NAME_TABLE_DENSE_MAX);
+
+    void **dense = GLI_MALLOC(capacity * sizeof(void *));
+    if (dense == NULL) {
+        return GL_FALSE;
+    }
+    if (table->dense) {
+        gli_memcpy(dense, table->dense, table->dense_capacity * sizeof(void *));
+        GLI_FREE(table->dense);
+    }
+    gli_memset(dense + table->dense_capacity, 0, (capacity - table->dense_capacity) * sizeof(void *));
+
+    table->dense = dense;
+    table->dense_capacity = capacity;
+    return GL_TRUE;
+}
+
+static GLboolean grow_hash(gli_name_table_t *table)
+{
+    const GLuint capacity = (table->hash_capacity) ? table->hash_capacity * 2 : HASH_MIN_CAPACITY;
+    GLuint *keys = GLI_MALLOC(capacity * sizeof(GLuint));
+    void **values = GLI_MALLOC(capacity * sizeof(void *));
+    if (keys == NULL || values == NULL) {
+        GLI_FREE(keys);
+        GLI_FREE(values);
+        return GL_FALSE;
+    }
+    gli_memset(keys, 0, capacity * sizeof(GLuint));
+
+    // Rehash everything into the new table. Name 0 is never stored, so it marks an empty slot
+    const GLuint mask = capacity - 1;
+    for (GLuint i = 0; i < table->hash_capacity; i++) {
+        if (table->hash_keys[i] == 0) {
+            continue;
+        }
+        GLuint slot = hash_name(table->hash_keys[i], mask);
+        while (keys[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        keys[slot] = table->hash_keys[i];
+        values[slot] = table->hash_values[i];
+    }
+
+    GLI_FREE(table->hash_keys);
+    GLI_FREE(table->hash_values);
+    table->hash_keys = keys;
+    table->hash_values = values;
+    table->hash_capacity = capacity;
+    return GL_TRUE;
+}
+
+static GLint find_hash_slot(const gli_name_table_t *table, GLuint name)
+{
+    if (table->hash_count == 0) {
+        return -1;
+    }
+    const GLuint mask = table->hash_capacity - 1;
+    for (GLuint slot = hash_name(name, mask);; slot = (slot + 1) & mask) {
+        if (table->hash_keys[slot] == name) {
+            return (GLint)slot;
+        }
+        if (table->hash_keys[slot] == 0) {
+            return -1;
+        }
+    }
+}
+
+static void *lookup(const gli_name_table_t *table, GLuint name)
+{
+    if (name < table->dense_capacity) {
+        return table->dense[name];
+    }
+    if (name < GLI_NAME_TABLE_DENSE_MAX) {
+        return NULL;
+    }
+    GLint slot = find_hash_slot(table, name);
+    return (slot < 0) ? NULL : table->hash_values[slot];
+}
+
+void *gliNameLookup(const gli_name_table_t *table, GLuint name)
+{
+    void *object = lookup(table, name);
+    return (object == RESERVED) ? NULL : object;
+}
+
+// Whether the name is in use, either generated by gliNameGen or holding an object
+GLboolean gliNameIsUsed(const gli_name_table_t *table, GLuint name)
+{
+    return (name != 0 && lookup(table, name) != NULL) ? GL_TRUE : GL_FALSE;
+}
+
+GLboolean gliNameInsert(gli_name_table_t *table, GLuint name, void *object)
+{
+    if (name == 0) {
+        return GL_FALSE;
+    }
+
+    if (name < GLI_NAME_TABLE_DENSE_MAX) {
+        if (name >= table->dense_capacity && !grow_dense(table, name)) {
+            return GL_FALSE;
+        }
+        table->dense[name] = object;
+        return GL_TRUE;
+    }
+
+    GLint slot = find_hash_slot(table, name);
+    if (slot >= 0) {
+        table->hash_values[slot] = object;
+        return GL_TRUE;
+    }
+
+    // Keep the load factor under 3/4
+    if ((table->hash_count + 1) * 4 > table->hash_capacity * 3 && !grow_hash(table)) {
+        return GL_FALSE;
+    }
+
+    const GLuint mask = table->hash_capacity - 1;
+    GLuint s = hash_name(name, mask);
+    while (table->hash_keys[s] != 0) {
+        s = (s + 1) & mask;
+    }
+    table->hash_keys[s] = name;
+    table->hash_values[s] = object;
+    table->hash_count++;
+    return GL_TRUE;
+}
+
+void gliNameRemove(gli_name_table_t *table, GLuint name)
+{
+    if (name == 0) {
+        return;
+    }
+
+    if (name < GLI_NAME_TABLE_DENSE_MAX) {
+        if (name >= table->dense_capacity || table->dense[name] == NULL) {
+            return;
+        }
+        table->dense[name] = NULL;
+
+        // Only dense names are recycled, gliNameGen never hands out sparse ones
+        if (table->free_count == table->free_capacity) {
+            const GLuint capacity = (table->free_capacity) ? table->free_capacity * 2 : 64;
+            GLuint *free_names = GLI_MALLOC(capacity * sizeof(GLuint));
+            if (free_names == NULL) {
+                return; // The name is still free, it just won't be reused early
+            }
+            if (table->free_names) {
+                gli_memcpy(free_names, table->free_names, table->free_count * sizeof(GLuint));
+                GLI_FREE(table->free_names);
+            }
+            table->free_names = free_names;
+            table->free_capacity = capacity;
+        }
+        table->free_names[table->free_count++] = name;
+        return;
+    }
+
+    GLint slot = find_hash_slot(table, name);
+    if (slot < 0) {
+        return;
+    }
+
+    // Backward shift deletion. Pull following entries of the probe run back so lookups never stop early
+    const GLuint mask = table->hash_capacity - 1;
+    GLuint hole = (GLuint)slot;
+    GLuint next = (hole + 1) & mask;
+    while (table->hash_keys[next] != 0) {
+        const GLuint home = hash_name(table->hash_keys[next], mask);
+        // Move the entry if the hole lies cyclically between its home slot and where it is now
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table->hash_keys[hole] = table->hash_keys[next];
+            table->hash_values[hole] = table->hash_values[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    table->hash_keys[hole] = 0;
+    table->hash_values[hole] = NULL;
+    table->hash_count--;
+}
+
+// Find an unused name for glGen*. The name is reserved until the app binds or deletes it
+GLuint gliNameGen(gli_name_table_t *table)
+{
+    GLuint name = 0;
+
+    // A name can be on the free list more than once if the app bound it again itself, so check it is still free
+    while (table->free_count > 0 && name == 0) {
+        name = table->free_names[--table->free_count];
+        if (lookup(table, name) != NULL) {
+            name = 0;
+        }
+    }
+
+    while (name == 0) {
+        if (table->next_name == 0) {
+            table->next_name++;
+        }
+        if (lookup(table, table->next_name) == NULL) {
+            name = table->next_name;
+        }
+        table->next_name++;
+    }
+
+    if (!gliNameInsert(table, name, RESERVED)) {
+        gliSetError(GL_OUT_OF_MEMORY);
+    }
+    return name;
+}
@@ -0,0 +1,422 @@
+#include "gles_private.h"
+
+// OES_matrix_palette.
+// NV2A's fixed function pipeline can blend up to four modelview matrices per vertex (the skin modes), but it has no
+// per vertex matrix indices. Skinned draws are therefore split on the CPU. The primitives are walked in order and
+// packed into batches that reference at most four palette matrices. Each batch loads its matrices into the hardware
+// modelview slots and gets its own weight array in the staging arena, with each vertex's weights moved to the slots
+// that its matrix indices map to. Eye space is then taken to screen space by the projection matrix, which
+// gliTransformFlush keeps loaded while the palette is enabled.
+
+#ifdef GL_OES_matrix_palette
+#define SKIN_SLOTS XGU_WEIGHT_COUNT
+
+GL_API void GL_APIENTRY glCurrentPaletteMatrixOES(GLuint matrixpaletteindex)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (matrixpaletteindex >= GLI_MAX_PALETTE_MATRICES) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    context->transformation_state.current_palette_matrix = matrixpaletteindex;
+}
+
+GL_API void GL_APIENTRY glLoadPaletteFromModelViewMatrixOES(void)
+{
+    gli_context_t *context = gliGetContext();
+    transformation_state_t *ts = &context->transformation_state;
+    glm_mat4_copy(*gliCurrentModelView(), ts->palette_matrix[ts->current_palette_matrix]);
+}
+
+GL_API void GL_APIENTRY glMatrixIndexPointerOES(GLint size, GLenum type, GLsizei stride, const void *pointer)
+{
+    gli_context_t *context = gliGetContext();
+    vertex_array_data_t *vad = &context->vertex_array_data;
+
+    if (GLI_INVALID(stride < 0)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    if (GLI_INVALID(type != GL_UNSIGNED_BYTE)) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+    if (GLI_INVALID(size < 1 || size > GLI_MAX_VERTEX_UNITS)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLI_LINT_IF(vad->matrix_index_array_buffer_binding == vad->array_buffer_binding &&
+                    vad->matrix_index_array_size == size && vad->matrix_index_array_type == type &&
+                    vad->matrix_index_array_stride == stride && vad->matrix_index_array_ptr == pointer,
+                GLI_LINT_REDUNDANT_POINTER);
+    vad->matrix_index_array_buffer_binding = vad->array_buffer_binding;
+    vad->matrix_index_array_buffer = vad->array_buffer;
+
+    vad->matrix_index_array_size = size;
+    vad->matrix_index_array_type = type;
+    vad->matrix_index_array_stride = stride;
+    vad->matrix_index_array_ptr = pointer;
+    vad->attrib_serial++;
+}
+
+GL_API void GL_APIENTRY glWeightPointerOES(GLint size, GLenum type, GLsizei stride, const void *pointer)
+{
+    gli_context_t *context = gliGetContext();
+    vertex_array_data_t *vad = &context->vertex_array_data;
+
+    if (GLI_INVALID(stride < 0)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    if (GLI_INVALID(type != GL_FIXED && type != GL_FLOAT)) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+    if (GLI_INVALID(size < 1 || size > GLI_MAX_VERTEX_UNITS)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLI_LINT_IF(vad->weight_array_buffer_binding == vad->array_buffer_binding && vad->weight_array_size == size &&
+                    vad->weight_array_type == type && vad->weight_array_stride == stride &&
+                    vad->weight_array_ptr == pointer,
+                GLI_LINT_REDUNDANT_POINTER);
+    vad->weight_array_buffer_binding = vad->array_buffer_binding;
+    vad->weight_array_buffer = vad->array_buffer;
+
+    vad->weight_array_size = size;
+    vad->weight_array_type = type;
+    vad->weight_array_stride = stride;
+    vad->weight_array_ptr = pointer;
+    vad->attrib_serial++;
+}
+
+GLboolean gliPaletteDrawActive(void)
+{
+    gli_context_t *context = gliGetContext();
+    vertex_array_data_t *vad = &context->vertex_array_data;
+
+    // Without both arrays there is nothing to blend with, so draw with the modelview matrix as usual
+    return context->transformation_state.matrix_palette_enabled && vad->matrix_index_array_enabled &&
+           vad->weight_array_enabled && (vad->matrix_index_array_ptr || vad->matrix_index_array_buffer) &&
+           (vad->weight_array_ptr || vad->weight_array_buffer);
+}
+
+typedef struct
+{
+    const GLubyte *indices;
+    GLsizei index_stride;
+    const GLubyte *weights;
+    GLsizei weight_stride;
+    GLenum weight_type;
+    GLuint units;
+} skin_source_t;
+
+// Palette matrix and weight for one vertex unit. The weight is zero for indices outside the palette
+static inline GLubyte vertex_influence(const skin_source_t *src, GLuint vertex, GLuint unit, GLfloat *weight)
+{
+    const GLubyte matrix = src->indices[vertex * src->index_stride + unit];
+    const GLubyte *w = src->weights + vertex * src->weight_stride;
+    if (src->weight_type == GL_FLOAT) {
+        *weight = ((const GLfloat *)w)[unit];
+    } else {
+        *weight = gliFixedtoFloat(((const GLfixed *)w)[unit]);
+    }
+    if (matrix >= GLI_MAX_PALETTE_MATRICES) {
+        *weight = 0.0f;
+    }
+    return matrix;
+}
+
+static inline int find_slot(const GLubyte *slots, GLuint slot_count, GLubyte matrix)
+{
+    for (GLuint s = 0; s < slot_count; s++) {
+        if (slots[s] == matrix) {
+            return (int)s;
+        }
+    }
+    return -1;
+}
+
+// Primitive list that a draw mode is split into. Returns the number of vertices per primitive
+static GLuint list_primitive(GLenum mode, DWORD *primitive)
+{
+    switch (mode) {
+        case GL_POINTS:
+            *primitive = NV097_SET_BEGIN_END_OP_POINTS;
+            return 1;
+        case GL_LINES:
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            *primitive = NV097_SET_BEGIN_END_OP_LINES;
+            return 2;
+        default:
+            *primitive = NV097_SET_BEGIN_END_OP_TRIANGLES;
+            return 3;
+    }
+}
+
+static GLuint primitive_count(GLenum mode, GLuint count)
+{
+    switch (mode) {
+        case GL_POINTS:
+            return count;
+        case GL_LINES:
+            return count / 2;
+        case GL_LINE_STRIP:
+            return (count >= 2) ? count - 1 : 0;
+        case GL_LINE_LOOP:
+            return (count >= 2) ? count : 0;
+        case GL_TRIANGLES:
+            return count / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:
+            return (count >= 3) ? count - 2 : 0;
+        default:
+            return 0;
+    }
+}
+
+// Position within the draw of each vertex of primitive p. The provoking vertex stays last
+static void primitive_vertices(GLenum mode, GLuint p, GLuint count, GLuint *v)
+{
+    switch (mode) {
+        case GL_POINTS:
+            v[0] = p;
+            break;
+        case GL_LINES:
+            v[0] = p * 2;
+            v[1] = p * 2 + 1;
+            break;
+        case GL_LINE_STRIP:
+            v[0] = p;
+            v[1] = p + 1;
+            break;
+        case GL_LINE_LOOP:
+            v[0] = p;
+            v[1] = (p + 1) % count;
+            break;
+        case GL_TRIANGLES:
+            v[0] = p * 3;
+            v[1] = p * 3 + 1;
+            v[2] = p * 3 + 2;
+            break;
+        case GL_TRIANGLE_STRIP:
+            // Odd triangles swap their first two vertices to keep the winding
+            v[0] = (p & 1) ? p + 1 : p;
+            v[1] = (p & 1) ? p : p + 1;
+            v[2] = p + 2;
+            break;
+        case GL_TRIANGLE_FAN:
+            v[0] = 0;
+            v[1] = p + 1;
+            v[2] = p + 2;
+            break;
+    }
+}
+
+// Draw one batch of list primitives whose vertices only reference the palette matrices in slots
+static GLboolean draw_batch(const skin_source_t *src,
+                            const GLubyte *slots,
+                            GLuint slot_count,
+                            DWORD primitive,
+                            const uint32_t *elements,
+                            GLuint element_count)
+{
+    gli_context_t *context = gliGetContext();
+    transformation_state_t *ts = &context->transformation_state;
+
+    GLuint min_vertex = elements[0];
+    GLuint max_vertex = elements[0];
+    for (GLuint i = 1; i < element_count; i++) {
+        min_vertex = GLI_MIN(min_vertex, elements[i]);
+        max_vertex = GLI_MAX(max_vertex, elements[i]);
+    }
+
+    // Only the batch's own vertex range gets weights. The array offset is moved back so vertex indices still line up
+    const GLuint weight_stride = SKIN_SLOTS * sizeof(GLfloat);
+    GLfloat *weights = gliStagingAlloc((max_vertex - min_vertex + 1) * weight_stride);
+    if (!weights) {
+        gliDebugF("[gles] staging arena overflow (%u bytes). Increase GLI_STAGING_ARENA_SIZE.\n",
+                  (unsigned)GLI_STAGING_ARENA_SIZE);
+        gliSetError(GL_OUT_OF_MEMORY);
+        return GL_FALSE;
+    }
+
+    for (GLuint i = 0; i < element_count; i++) {
+        const GLuint vertex = elements[i];
+        GLfloat slot_weight[SKIN_SLOTS] = {0.0f};
+        for (GLuint u = 0; u < src->units; u++) {
+            GLfloat weight;
+            const GLubyte matrix = vertex_influence(src, vertex, u, &weight);
+            const int slot = find_slot(slots, slot_count, matrix);
+            if (slot >= 0) {
+                slot_weight[slot] += weight;
+            }
+        }
+        GLfloat *dst = &weights[(vertex - min_vertex) * SKIN_SLOTS];
+        for (GLuint s = 0; s < SKIN_SLOTS; s++) {
+            dst[s] = slot_weight[s];
+        }
+    }
+    __asm__ __volatile__("sfence");
+
+    const uint32_t weights_address = (uint32_t)MmGetPhysicalAddress(weights) - min_vertex * weight_stride;
+    const XguSkinMode skin_mode = (slot_count <= 2) ? XGU_SKIN_MODE_2
+                                  : (slot_count == 3) ? XGU_SKIN_MODE_3
+                                                      : XGU_SKIN_MODE_4;
+
+    uint32_t *pb = pb_begin();
+    pb = xgu_set_skin_mode(pb, skin_mode);
+    pb = xgu_set_vertex_data_array_format(
+        pb, (XguVertexArray)NV2A_VERTEX_ATTR_WEIGHT, XGU_FLOAT, SKIN_SLOTS, weight_stride);
+    pb = xgu_set_vertex_data_array_offset(pb, (XguVertexArray)NV2A_VERTEX_ATTR_WEIGHT, (void *)weights_address);
+    pb = pb_push1(pb, NV097_BREAK_VERTEX_BUFFER_CACHE, 0);
+    pb_end(pb);
+
+    // The skin mode blends at least two matrices, and a batch that has fewer (a single matrix, or only zero weights)
+    // leaves the others in use with a weight of 0. Whatever was left in those slots is replaced with the identity, as
+    // 0 times a NaN or infinity in a stale matrix would still poison the blend
+    const GLuint blended = (slot_count <= 2) ? 2 : slot_count;
+    for (GLuint s = 0; s < blended; s++) {
+        mat4 identity;
+        mat4 *palette = &identity;
+        if (s < slot_count) {
+            palette = &ts->palette_matrix[slots[s]];
+        } else {
+            glm_mat4_identity(identity);
+        }
+        pb = pb_begin();
+        pb = pb_push_transposed_matrix(pb, NV097_SET_MODEL_VIEW_MATRIX + s * 64, (const float *)*palette);
+        if (context->lighting_state.lighting_enabled) {
+            mat4 palette_inv;
+            glm_mat4_inv(*palette, palette_inv);
+            pb = pb_push_4x4_matrix(pb, NV097_SET_INVERSE_MODEL_VIEW_MATRIX + s * 64, (const float *)palette_inv);
+        }
+        pb_end(pb);
+    }
+
+    xgux_draw_elements32(primitive, elements, element_count);
+    return GL_TRUE;
+}
+
+// Draw with the matrix palette. indices is NULL for glDrawArrays, otherwise a CPU pointer to count indices of type
+void gliPaletteDraw(GLenum mode, GLint first, GLsizei count, GLenum type, const void *indices)
+{
+    gli_context_t *context = gliGetContext();
+    vertex_array_data_t *vad = &context->vertex_array_data;
+
+    const GLuint prim_count = primitive_count(mode, (GLuint)count);
+    if (prim_count == 0) {
+        return;
+    }
+
+    skin_source_t src;
+    // Every vertex's indices and weights are read more than once, so buffers are read through their cached copy
+    src.indices = gliGetBufferCpuPointer(vad->matrix_index_array_buffer, vad->matrix_index_array_ptr);
+    src.index_stride = (vad->matrix_index_array_stride) ? vad->matrix_index_array_stride : vad->matrix_index_array_size;
+    src.weights = gliGetBufferCpuPointer(vad->weight_array_buffer, vad->weight_array_ptr);
+    src.weight_stride = (vad->weight_array_stride) ? vad->weight_array_stride
+                                                   : vad->weight_array_size * gliEnumtoByteSize(vad->weight_array_type);
+    src.weight_type = vad->weight_array_type;
+    src.units = GLI_MIN(vad->matrix_index_array_size, vad->weight_array_size);
+
+    DWORD primitive;
+    const GLuint prim_size = list_primitive(mode, &primitive);
+    const GLuint element_count = prim_count * prim_size;
+
+    // Expand the draw into a list of absolute vertex indices
+    uint32_t stack_alloc[768];
+    uint32_t *elements = stack_alloc;
+    if (element_count > GLI_ARRAY_SIZE(stack_alloc)) {
+        elements = GLI_MALLOC(sizeof(uint32_t) * element_count);
+        if (!elements) {
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+    for (GLuint p = 0; p < prim_count; p++) {
+        GLuint v[3];
+        primitive_vertices(mode, p, (GLuint)count, v);
+        for (GLuint k = 0; k < prim_size; k++) {
+            if (indices == NULL) {
+                elements[p * prim_size + k] = first + v[k];
+            } else if (type == GL_UNSIGNED_INT) {
+                elements[p * prim_size + k] = ((const uint32_t *)indices)[v[k]];
+            } else if (type == GL_UNSIGNED_SHORT) {
+                elements[p * prim_size + k] = ((const uint16_t *)indices)[v[k]];
+            } else {
+                elements[p * prim_size + k] = ((const uint8_t *)indices)[v[k]];
+            }
+        }
+    }
+
+    // Greedily pack consecutive primitives into batches of at most SKIN_SLOTS matrices. A single primitive that
+    // needs more than that keeps its first SKIN_SLOTS matrices and loses the rest of its weights
+    GLubyte slots[SKIN_SLOTS];
+    GLuint slot_count = 0;
+    GLuint batch_start = 0;
+    for (GLuint p = 0; p < prim_count; p++) {
+        // Every matrix this primitive has a weight for, and how many of them are not in a slot yet
+        GLubyte used[3 * GLI_MAX_VERTEX_UNITS];
+        GLuint used_count = 0;
+        GLuint new_count = 0;
+        for (GLuint k = 0; k < prim_size; k++) {
+            for (GLuint u = 0; u < src.units; u++) {
+                GLfloat weight;
+                const GLubyte matrix = vertex_influence(&src, elements[p * prim_size + k], u, &weight);
+                if (weight == 0.0f || find_slot(used, used_count, matrix) >= 0) {
+                    continue;
+                }
+                used[used_count++] = matrix;
+                new_count += (find_slot(slots, slot_count, matrix) < 0);
+            }
+        }
+
+        if (slot_count + new_count > SKIN_SLOTS && p > batch_start) {
+            if (!draw_batch(&src,
+                            slots,
+                            slot_count,
+                            primitive,
+                            &elements[batch_start * prim_size],
+                            (p - batch_start) * prim_size)) {
+                goto done;
+            }
+            batch_start = p;
+            slot_count = 0;
+        }
+
+        for (GLuint i = 0; i < used_count && slot_count < SKIN_SLOTS; i++) {
+            if (find_slot(slots, slot_count, used[i]) < 0) {
+                slots[slot_count++] = used[i];
+            }
+        }
+    }
+    draw_batch(&src,
+               slots,
+               slot_count,
+               primitive,
+               &elements[batch_start * prim_size],
+               (prim_count - batch_start) * prim_size);
+
+done:
+    if (elements != stack_alloc) {
+        GLI_FREE(elements);
+    }
+
+    // Put the hardware back to single matrix transforms. Modelview slot 0 was overwritten, so it is pushed again
+    uint32_t *pb = pb_begin();
+    pb = xgu_set_skin_mode(pb, XGU_SKIN_MODE_OFF);
+    pb = xgu_set_vertex_data_array_format(pb, (XguVertexArray)NV2A_VERTEX_ATTR_WEIGHT, XGU_FLOAT, 0, 0);
+    pb_end(pb);
+    context->transformation_state.modelview_matrix_dirty = GL_TRUE;
+
+    // See glDrawArrays
+    glColor4f(context->current_values.current_color[0],
+              context->current_values.current_color[1],
+              context->current_values.current_color[2],
+              context->current_values.current_color[3]);
+}
+#endif
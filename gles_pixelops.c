@@ -40,6 +40,8 @@ GL_API void GL_APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor)
         gliSetError(GL_INVALID_ENUM);
         return;
     }
+    GLI_LINT_IF(context->pixel_ops_state.blend_src == sfactor && context->pixel_ops_state.blend_dst == dfactor,
+                GLI_LINT_REDUNDANT_BLEND_FUNC);
 
     context->pixel_ops_state.blend_src = sfactor;
     context->pixel_ops_state.blend_dst = dfactor;
@@ -31,6 +31,12 @@
 #ifndef GLI_MAX_CLIP_PLANES
 #define GLI_MAX_CLIP_PLANES 1
 #endif
+#ifndef GLI_MAX_VERTEX_UNITS
+#define GLI_MAX_VERTEX_UNITS 3
+#endif
+#ifndef GLI_MAX_PALETTE_MATRICES
+#define GLI_MAX_PALETTE_MATRICES 32 // OES_matrix_palette requires at least 9
+#endif
 #ifndef GLI_UNPACK_ALIGNMENT
 #define GLI_UNPACK_ALIGNMENT 4
 #endif
@@ -49,6 +55,76 @@
 #ifndef GLI_NUM_COMPRESSED_TEXTURE_FORMATS
 #define GLI_NUM_COMPRESSED_TEXTURE_FORMATS 0
 #endif
+#ifndef GLI_TEXTURE_MEMORY_BUDGET
+#define GLI_TEXTURE_MEMORY_BUDGET 0 // Bytes of contiguous memory textures may occupy before eviction. 0 is unlimited
+#endif
+#ifndef GLI_MAX_DEFERRED_FREES
+#define GLI_MAX_DEFERRED_FREES 128
+#endif
+#ifndef GLI_NAME_TABLE_DENSE_MAX
+#define GLI_NAME_TABLE_DENSE_MAX 65536 // Object names below this are looked up by direct index, above by hash
+#endif
+#ifndef GLI_DRAW_MERGE_MAX_DRAWS
+#define GLI_DRAW_MERGE_MAX_DRAWS 64 // Draws that may share one begin/end block when GLI_DRAW_MERGING is enabled
+#endif
+#ifndef GLI_VERTEX_PROGRAM
+#define GLI_VERTEX_PROGRAM 0 // Compile the fixed function state into vertex programs. See gles_vertex_program.c
+#endif
+#ifndef GLI_VERTEX_PROGRAM_CACHE_SIZE
+#define GLI_VERTEX_PROGRAM_CACHE_SIZE 16
+#endif
+#ifndef GLI_MAX_QUERIES
+#define GLI_MAX_QUERIES 256 // Query objects that may exist at once. Each takes a 16 byte report slot on first use
+#endif
+#ifndef GLI_MAX_TIMER_MARKERS
+#define GLI_MAX_TIMER_MARKERS 64 // Timer query markers the GPU may have outstanding before a new one waits
+#endif
+#ifndef GLI_FRAMES_IN_FLIGHT
+#define GLI_FRAMES_IN_FLIGHT 0 // Frames glFlipNV2A may leave queued on the GPU. 0 keeps the blocking flip
+#endif
+#define GLI_MAX_FRAMES_IN_FLIGHT 3 // pbkit rotates through three framebuffers
+#ifndef GLI_FRAME_STATS_HISTORY
+#define GLI_FRAME_STATS_HISTORY 64 // Frames of statistics kept for glGetFrameStatsNV2A
+#endif
+#ifndef GLI_PROFILE
+#define GLI_PROFILE 0 // Time each stage of the draw path with rdtsc. See gles_profile.c
+#endif
+#ifndef GLI_PROFILE_TRACE_EVENTS
+#define GLI_PROFILE_TRACE_EVENTS 65536 // Scope events a trace started by glTraceNV2A can hold
+#endif
+#ifndef GLI_LINT
+#define GLI_LINT 0 // Report wasteful GL call patterns per call site through gliDebugF. See gles_lint.c
+#endif
+#ifndef GLI_LINT_SITES
+#define GLI_LINT_SITES 512 // Call sites the lint can track, a power of two
+#endif
+#ifndef GLI_LINT_REPORT_FRAMES
+#define GLI_LINT_REPORT_FRAMES 300 // Frames between lint reports
+#endif
+#ifndef GLI_LINT_REPORT_TOP
+#define GLI_LINT_REPORT_TOP 20 // Call sites listed in each lint report
+#endif
+#ifndef GLI_NO_ERROR
+#define GLI_NO_ERROR 0 // Leave argument checks out of the hot entry points, as KHR_no_error does. See GLI_INVALID
+#endif
+#ifndef GLI_CAPTURE
+#define GLI_CAPTURE 0 // Set by the NXDK_GLES11_WITH_CAPTURE build, which routes every entry point through gl_capture.c
+#endif
+#ifndef GLI_MEMCPY_STREAM_THRESHOLD
+#define GLI_MEMCPY_STREAM_THRESHOLD 64 // Smallest gli_memcpy that streams. Measure with samples/memcpy_bench.c
+#endif
+#ifndef GLI_MEMCPY_PREFETCH_DISTANCE
+#define GLI_MEMCPY_PREFETCH_DISTANCE 256 // Bytes gli_memcpy prefetches ahead of the streaming loop
+#endif
+#ifndef GLI_TSC_FREQUENCY
+#define GLI_TSC_FREQUENCY 733333333ULL // CPU time stamp counter rate in Hz
+#endif
+#ifndef GLI_TEXTURE_COMPRESSION_HINT
+#define GLI_TEXTURE_COMPRESSION_HINT GL_DONT_CARE
+#endif
+#ifndef GLI_COMPACT_TEXTURE_DITHER
+#define GLI_COMPACT_TEXTURE_DITHER 1
+#endif
 #ifndef GLI_VENDOR_STRING
 #define GLI_VENDOR_STRING "UnspecifiedVendor"
 #endif
@@ -164,6 +240,18 @@ typedef struct
     GLsizei point_size_array_stride;
     const GLvoid *point_size_array_ptr;
 
+    // Matrix index and weight arrays (Extension). These are read on the CPU to build skinned draws, see gles_palette.c
+    GLboolean matrix_index_array_enabled;
+    GLint matrix_index_array_size;
+    GLenum matrix_index_array_type;
+    GLsizei matrix_index_array_stride;
+    const GLvoid *matrix_index_array_ptr;
+    GLboolean weight_array_enabled;
+    GLint weight_array_size;
+    GLenum weight_array_type;
+    GLsizei weight_array_stride;
+    const GLvoid *weight_array_ptr;
+
     // Bindings
     GLuint array_buffer_binding;
     GLuint element_array_buffer_binding;
@@ -172,6 +260,26 @@ typedef struct
     GLuint color_array_buffer_binding;
     GLuint texcoord_array_buffer_binding[GLI_MAX_TEXTURE_UNITS];
     GLuint point_size_array_buffer_binding;
+    GLuint matrix_index_array_buffer_binding;
+    GLuint weight_array_buffer_binding;
+
+    // Buffer objects behind the bindings above, resolved when they are bound so draws don't need to look them up
+    struct buffer_object *array_buffer;
+    struct buffer_object *element_array_buffer;
+    struct buffer_object *vertex_array_buffer;
+    struct buffer_object *normal_array_buffer;
+    struct buffer_object *color_array_buffer;
+    struct buffer_object *texcoord_array_buffer[GLI_MAX_TEXTURE_UNITS];
+    struct buffer_object *point_size_array_buffer;
+    struct buffer_object *matrix_index_array_buffer;
+    struct buffer_object *weight_array_buffer;
+
+    // Incremented whenever a buffer's storage moves. gliArrayFlush re-sends buffer backed attributes when it changes
+    GLuint buffer_generation;
+    GLuint flushed_buffer_generation;
+
+    // Incremented by every change to the attribute setup, so VAOs know when to re-encode
+    GLuint attrib_serial;
 } vertex_array_data_t;
 
 // Table 6.6 - Buffer Object State
@@ -181,6 +289,9 @@ typedef struct buffer_object
     GLuint buffer_size;
     GLenum buffer_usage;
     void *buffer_data;
+    ULONG buffer_protect; // Page protection buffer_data was allocated with
+    void *cpu_shadow;     // Cached copy of write-combined buffer_data for CPU reads, made on first use
+    struct buffer_object *prev;
     struct buffer_object *next;
 } buffer_object_t;
 
@@ -207,6 +318,10 @@ typedef struct
     vec4 clip_plane[GLI_MAX_CLIP_PLANES];
     GLboolean clip_plane_enabled[GLI_MAX_CLIP_PLANES];
     GLboolean clip_plane_dirty;
+    GLboolean draw_texture_active; // Hardware is set up for glDrawTex screen space quads, see gles_draw_texture.c
+    mat4 palette_matrix[GLI_MAX_PALETTE_MATRICES];
+    GLuint current_palette_matrix;
+    GLboolean matrix_palette_enabled;
 } transformation_state_t;
 
 // Table 6.8 - Coloring
@@ -305,8 +420,9 @@ typedef struct
 typedef struct texture_object
 {
     GLuint texture_name;
+    GLenum target; // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP_OES, fixed by the first bind
     GLboolean texture_object_dirty;
-    const GLvoid *texture_2d; // This is implementation-defined image data
+    const GLvoid *texture_2d; // This is implementation-defined image data. Holds all six faces for a cube map
     GLenum min_filter;
     GLenum mag_filter;
     GLenum wrap_s;
@@ -314,6 +430,9 @@ typedef struct texture_object
     GLenum internalformat;
 
     GLboolean generate_mipmap;
+    GLint crop_rect[4]; // Ucr, Vcr, Wcr, Hcr for OES_draw_texture
+    GLuint last_used_frame; // For LRU eviction
+    struct texture_object *prev;
     struct texture_object *next;
 } texture_object_t;
 
@@ -325,6 +444,14 @@ typedef struct texture_unit
     texture_object_t *bound_texture_object;
     texture_object_t unbound_texture_object; // Used when texture_binding_2d is 0
 
+    GLboolean texture_cube_map_enabled;
+    GLuint texture_binding_cube_map;
+    texture_object_t *bound_cube_map_object;
+    texture_object_t unbound_cube_map_object; // Used when texture_binding_cube_map is 0
+
+    GLboolean texgen_enabled; // GL_TEXTURE_GEN_STR_OES
+    GLenum texgen_mode;
+
     GLenum tex_env_mode;
     vec4 tex_env_color;
     GLboolean coord_replace_oes_enabled;
@@ -404,6 +531,7 @@ typedef struct
     GLenum line_smooth_hint;
     GLenum fog_hint;
     GLenum generate_mipmap_hint;
+    GLenum texture_compression_hint;
 } hints_state_t;
 
 // Table 6.20 - Implemenation Limits
@@ -416,12 +544,15 @@ typedef struct
     GLint max_texture_stack_depth;
     GLint subpixel_bits;
     GLint max_texture_size;
+    GLint max_cube_map_texture_size;
     GLint max_viewport_dims[2];
     GLfloat aliased_point_size_range[2];
     GLfloat antialiased_point_size_range[2];
     GLfloat aliased_line_width_range[2];
     GLfloat antialiased_line_width_range[2];
     GLint max_texture_units;
+    GLint max_vertex_units;
+    GLint max_palette_matrices;
     GLint sample_buffers;
     GLint samples;
     GLenum *compressed_texture_formats;
@@ -437,6 +568,8 @@ typedef struct renderbuffer_object
     GLboolean swizzled;
     GLubyte *data;
     GLubyte *data_physical_address;
+    GLuint data_size;
+    struct renderbuffer_object *prev;
     struct renderbuffer_object *next;
 } renderbuffer_object_t;
 
@@ -455,9 +588,188 @@ typedef struct framebuffer_object
     framebuffer_attachment_t color;
     framebuffer_attachment_t depth;
     framebuffer_attachment_t stencil;
+    struct framebuffer_object *prev;
     struct framebuffer_object *next;
 } framebuffer_object_t;
 
+// OES_vertex_array_object. See gles_vao.c
+typedef struct vertex_array_object
+{
+    GLuint name;
+    vertex_array_data_t state;
+
+    // Pre-encoded SET_VERTEX_DATA_ARRAY_FORMAT/OFFSET words for the attributes that don't need staging
+    uint32_t pb_words[(4 + GLI_MAX_TEXTURE_UNITS) * 4];
+    GLuint pb_word_count;
+    GLuint encoded_mask; // Bit per XguVertexArray slot covered by pb_words
+    GLuint encoded_serial;
+    GLuint encoded_generation;
+    GLboolean encoded;
+
+    struct vertex_array_object *prev;
+    struct vertex_array_object *next;
+} vertex_array_object_t;
+
+// Maps object names to objects. See gles_names.c
+typedef struct
+{
+    void **dense;
+    GLuint dense_capacity;
+    GLuint *hash_keys;
+    void **hash_values;
+    GLuint hash_capacity;
+    GLuint hash_count;
+    GLuint *free_names;
+    GLuint free_count;
+    GLuint free_capacity;
+    GLuint next_name;
+} gli_name_table_t;
+
+// A fixed function state compiled to a vertex program. See gles_vertex_program.c
+typedef struct
+{
+    GLuint key;
+    GLboolean valid;
+    GLuint count; // Zero if the state can't be drawn with a program
+    XguTransformProgramInstruction *instructions;
+} vertex_program_t;
+
+typedef struct
+{
+    GLboolean active; // Hardware is in program mode
+    GLboolean transform_dirty;
+    GLboolean lighting_dirty;
+    vertex_program_t *loaded; // Program in program memory
+    vertex_program_t programs[GLI_VERTEX_PROGRAM_CACHE_SIZE];
+} vertex_program_state_t;
+
+typedef struct
+{
+    void *data;
+    GLuint size;
+    ULONG protect;
+    GLuint fence; // Safe to free once the GPU has reached this fence
+} deferred_free_t;
+
+typedef struct
+{
+    GLuint name;
+    GLenum target;      // 0 until the first glBeginQueryEXT or glQueryCounterEXT
+    GLuint slot;        // Index of this query's report in the report slab
+    GLuint fence;       // The result is complete once the GPU passes this fence
+    GLboolean resolved; // result holds the result of the last glEndQueryEXT or glQueryCounterEXT
+    uint64_t result;
+    uint64_t begin_tsc; // Timer queries: GPU time of each marker on the time stamp counter's scale, 0 until resolved
+    uint64_t end_tsc;
+} query_object_t;
+
+typedef struct
+{
+    GLuint fence;
+    GLint report;  // Report slot the GPU timestamps as it passes the marker, or GLI_NO_REPORT
+    uint64_t *tsc; // Written once the fence is seen to pass. NULL if the query was deleted
+} timer_marker_t;
+
+// Report slots in the query slab. Each query owns the slot of the same index for its result or end time, timer queries
+// also own one for their begin time, each frame of statistics has one for its completion, and the last is used by
+// gliQueryInit to check the GPU writes real timestamps
+#define GLI_NO_REPORT                -1
+#define GLI_REPORT_QUERY_BEGIN(slot) (GLI_MAX_QUERIES + (slot))
+#define GLI_REPORT_FRAME(frame)      (2 * GLI_MAX_QUERIES + (GLint)((frame) % GLI_FRAME_STATS_HISTORY))
+#define GLI_REPORT_CALIBRATION       (2 * GLI_MAX_QUERIES + GLI_FRAME_STATS_HISTORY)
+#define GLI_REPORT_COUNT             (GLI_REPORT_CALIBRATION + 1)
+
+// Stages of the draw path timed when GLI_PROFILE is enabled. Keep in sync with scope_names in gles_profile.c
+typedef enum
+{
+    GLI_SCOPE_FBO,
+    GLI_SCOPE_TRANSFORM,
+    GLI_SCOPE_FOG,
+    GLI_SCOPE_TEXTURE,
+    GLI_SCOPE_COMBINER, // Part of GLI_SCOPE_TEXTURE
+    GLI_SCOPE_POINT_PARAMS,
+    GLI_SCOPE_LIGHTING,
+    GLI_SCOPE_ARRAYS,
+    GLI_SCOPE_VERTEX_PROGRAM,
+    GLI_SCOPE_STAGING,
+    GLI_SCOPE_INDICES,
+    GLI_SCOPE_FLIP,
+    GLI_SCOPE_COUNT
+} gli_profile_scope_t;
+
+typedef struct
+{
+    uint64_t tsc;
+    GLuint calls;
+} profile_counter_t;
+
+// Wasteful call patterns reported when GLI_LINT is enabled. Keep in sync with issue_names in gles_lint.c
+typedef enum
+{
+    GLI_LINT_REDUNDANT_ENABLE,
+    GLI_LINT_REDUNDANT_BIND_TEXTURE,
+    GLI_LINT_REDUNDANT_BLEND_FUNC,
+    GLI_LINT_REDUNDANT_TEX_PARAMETER,
+    GLI_LINT_TEX_PARAMETER_REDIRTY,
+    GLI_LINT_REDUNDANT_POINTER,
+    GLI_LINT_CLIENT_INDICES,
+    GLI_LINT_FINISH,
+    GLI_LINT_COUNT
+} gli_lint_t;
+
+typedef struct
+{
+    const void *site; // Return address of the entry point, NULL for an unused slot
+    gli_lint_t issue;
+    GLuint calls;
+    GLuint frames;     // Frames the issue was seen in at this site
+    GLuint last_frame; // frame_count when it was last seen
+} lint_site_t;
+
+typedef struct
+{
+    uint64_t start_tsc;
+    uint64_t end_tsc;
+    gli_profile_scope_t scope;
+} trace_event_t;
+
+// Per frame counters read through the GL_NV2A_frame_counters enums, in the same order
+typedef enum
+{
+    GLI_COUNTER_DRAW_CALLS,
+    GLI_COUNTER_VERTICES,
+    GLI_COUNTER_INDICES,
+    GLI_COUNTER_STAGED_BYTES,
+    GLI_COUNTER_STAGING_WRAPS,
+    GLI_COUNTER_TEXTURE_UPLOADS,
+    GLI_COUNTER_TEXTURE_UPLOAD_BYTES,
+    GLI_COUNTER_COMBINER_UPDATES,
+    GLI_COUNTER_STATE_FLUSHES,
+    GLI_COUNTER_EMPTY_STATE_FLUSHES,
+    GLI_COUNTER_PUSHBUFFER_WORDS,
+    GLI_COUNTER_COUNT
+} gli_counter_t;
+
+// Times are CPU time stamp counter values
+typedef struct
+{
+    GLuint frame;
+    uint64_t begin_tsc;       // The previous glFlipNV2A returned
+    uint64_t flip_tsc;        // glFlipNV2A was called
+    uint64_t flip_end_tsc;    // glFlipNV2A returned
+    uint64_t finish_wait_tsc; // Spent waiting in glFinish
+    uint64_t complete_tsc;    // The GPU finished the frame, from its report. 0 until the fence is seen to pass
+    GLuint fence;
+    GLuint missed_vblanks;
+    GLuint pushbuffer_words;
+} frame_stats_t;
+
+typedef struct
+{
+    GLenum condition;
+    GLuint fence; // From the last glSetFenceNV
+} fence_object_t;
+
 typedef struct
 {
     current_values_t current_values;
@@ -496,28 +808,213 @@ typedef struct
     uint32_t current_surface_format;
     uint32_t current_surface_width;
     uint32_t current_surface_height;
+
+    // Incremented by every glFlipNV2A
+    GLuint frame_count;
+
+    // Queued presentation. Fence of each recent frame, indexed by frame_count % (GLI_MAX_FRAMES_IN_FLIGHT + 1)
+    GLuint max_frames_in_flight;
+    GLuint frame_fences[GLI_MAX_FRAMES_IN_FLIGHT + 1];
+    GLuint present_vbl;
+
+    // Statistics of the frame being built and the recent ones, indexed by frame % GLI_FRAME_STATS_HISTORY
+    uint32_t *pb_window; // Start of the current pb_begin/pb_end window
+    GLuint frame_counters[GLI_COUNTER_COUNT];
+    GLuint last_frame_counters[GLI_COUNTER_COUNT];
+    uint64_t frame_begin_tsc;
+    uint64_t frame_finish_wait_tsc;
+    GLuint frame_end_vbl;
+    frame_stats_t frame_stats[GLI_FRAME_STATS_HISTORY];
+
+    // Draw path profile of the frame being built and the last one, and the trace being recorded. See GLI_PROFILE
+    profile_counter_t profile_frame[GLI_SCOPE_COUNT];
+    profile_counter_t profile_last_frame[GLI_SCOPE_COUNT];
+    GLboolean trace_enabled;
+    trace_event_t *trace_events;
+    GLuint trace_event_count;
+    uint64_t trace_start_tsc;
+
+    // Wasteful call patterns seen since the last lint report, see GLI_LINT
+    lint_site_t *lint_sites; // GLI_LINT_SITES slots, allocated when the first issue is seen
+    GLuint lint_frames;
+    GLuint lint_dropped; // Reports lost to a full table
+
+    // GL call capture being written, see gles_capture.c
+    void *capture_stream; // FILE *
+
+    // Contiguous memory in use. Texture residency budgets texture_resident_bytes
+    GLuint texture_resident_bytes;
+    GLuint buffer_resident_bytes;
+    GLuint renderbuffer_resident_bytes;
+
+    // Object name lookup
+    gli_name_table_t texture_names;
+    gli_name_table_t buffer_names;
+    gli_name_table_t framebuffer_names;
+    gli_name_table_t renderbuffer_names;
+    gli_name_table_t vertex_array_names;
+
+    // OES_vertex_array_object state
+    GLuint vertex_array_binding;
+    vertex_array_object_t *bound_vertex_array;
+    vertex_array_object_t default_vertex_array;
+    vertex_array_object_t *vertex_array_objects;
+
+    // GPU fences and memory waiting for the GPU before it can be freed
+    volatile GLuint *fence_semaphore;
+    GLuint fence_semaphore_physical_address;
+    GLuint fence_value;
+    struct s_CtxDma fence_dma;
+    gli_name_table_t fence_names; // NV_fence objects
+    deferred_free_t deferred_frees[GLI_MAX_DEFERRED_FREES];
+    GLuint deferred_free_count;
+    GLuint deferred_free_bytes;
+
+    // Query objects and the slab of reports the GPU writes their results to. See gles_query.c
+    gli_name_table_t query_names;
+    query_object_t *active_occlusion_query;
+    query_object_t *active_timer_query;
+    timer_marker_t timer_markers[GLI_MAX_TIMER_MARKERS]; // Oldest first, from timer_marker_head
+    GLuint timer_marker_head;
+    GLuint timer_marker_count;
+    volatile GLuint *query_reports;
+    struct s_CtxDma query_dma;
+    GLboolean gpu_timestamps; // Reports carry PTIMER timestamps. Otherwise markers are timed when seen to pass
+    uint64_t gpu_time_base;   // PTIMER and the time stamp counter read together by gliQueryInit
+    uint64_t tsc_base;
+    GLuint query_free_slots[GLI_MAX_QUERIES];
+    GLuint query_free_count;
+
+    // Begin/end block left open by the last draw for the next one to join. See GLI_DRAW_MERGING
+    GLboolean draw_open;
+    GLboolean draw_open_elements;
+    DWORD draw_open_primitive;
+    GLuint draw_open_last_index;
+    GLuint draw_open_vertex_count;
+    GLuint draw_open_draw_count;
+
+    // Fixed function vertex programs. See GLI_VERTEX_PROGRAM
+    vertex_program_state_t vertex_program_state;
 } gli_context_t;
 
 void gliFlushStateChange(void);
-texture_object_t *gliFindTextureObject(GLuint name, texture_object_t **prev);
-framebuffer_object_t *gliFindFramebufferObject(GLuint name, framebuffer_object_t **prev);
-renderbuffer_object_t *gliFindRenderbufferObject(GLuint name, renderbuffer_object_t **prev);
-buffer_object_t *gliFindBufferObject(GLuint name, buffer_object_t **prev);
+texture_object_t *gliFindTextureObject(GLuint name);
+framebuffer_object_t *gliFindFramebufferObject(GLuint name);
+renderbuffer_object_t *gliFindRenderbufferObject(GLuint name);
+buffer_object_t *gliFindBufferObject(GLuint name);
+vertex_array_object_t *gliFindVertexArrayObject(GLuint name);
+void gliVertexArraysDetachBuffer(const buffer_object_t *buffer);
+void *gliNameLookup(const gli_name_table_t *table, GLuint name);
+GLboolean gliNameIsUsed(const gli_name_table_t *table, GLuint name);
+GLboolean gliNameInsert(gli_name_table_t *table, GLuint name, void *object);
+void gliNameRemove(gli_name_table_t *table, GLuint name);
+GLuint gliNameGen(gli_name_table_t *table);
 int gliDebugF(const char *fmt, ...);
 void gliSetError(GLenum error);
 void gliFBOFlush(void);
 void gliArrayFlush(void);
 void gliStagingInit(void);
 void gliStagingDestroy(void);
+void gliFenceInit(void);
+void gliQueryInit(void);
+void gliTimerPoll(void);
+GLuint gliTimerMarkerInsert(uint64_t *tsc, GLint report);
+uint64_t gliGpuTimeToTsc(uint64_t gpu_time);
+uint64_t gliTscToGpuTime(uint64_t tsc);
+GLuint gliFrameStatsSubmit(uint64_t flip_tsc);
+void gliFrameStatsFlipDone(GLint swap_interval);
+GLuint gliFenceInsert(void);
+GLboolean gliFenceReached(GLuint value);
+void gliFenceWait(GLuint value);
+void gliDeferredFree(void *data, GLuint size, ULONG protect);
+void gliDeferredDrain(GLboolean wait);
+void *gliContiguousAlloc(GLuint size, ULONG protect);
 GLboolean gliNeedsStaging(void);
 GLboolean gliStageClientArrays(GLsizei vertex_count);
+#if GLI_DRAW_MERGING
+void gliDrawClose(void);
+#else
+static inline void gliDrawClose(void)
+{
+}
+#endif
+#if GLI_VERTEX_PROGRAM
+void gliVertexProgramFlush(void);
+void gliVertexProgramSuspend(void);
+#else
+static inline void gliVertexProgramFlush(void)
+{
+}
+static inline void gliVertexProgramSuspend(void)
+{
+}
+#endif
+#if GLI_PROFILE
+void gliProfileRecord(gli_profile_scope_t scope, uint64_t start_tsc);
+void gliProfileFlip(void);
+#define GLI_PROFILE_BEGIN(scope) const uint64_t gli_profile_start_##scope = gliReadTsc()
+#define GLI_PROFILE_END(scope)   gliProfileRecord(scope, gli_profile_start_##scope)
+#else
+static inline void gliProfileFlip(void)
+{
+}
+#define GLI_PROFILE_BEGIN(scope)
+#define GLI_PROFILE_END(scope)
+#endif
+#define GLI_PROFILE_CALL(scope, call)                                                                                  \
+    do {                                                                                                               \
+        GLI_PROFILE_BEGIN(scope);                                                                                      \
+        call;                                                                                                          \
+        GLI_PROFILE_END(scope);                                                                                        \
+    } while (0)
+#if GLI_LINT
+void gliLintRecord(gli_lint_t issue, const void *site);
+void gliLintFlip(void);
+void gliLintReset(void);
+#define GLI_LINT_CALLER() __builtin_return_address(0)
+#define GLI_LINT_IF_AT(cond, issue, site)                                                                              \
+    do {                                                                                                               \
+        if (cond) {                                                                                                    \
+            gliLintRecord(issue, site);                                                                                \
+        }                                                                                                              \
+    } while (0)
+#else
+static inline void gliLintFlip(void)
+{
+}
+static inline void gliLintReset(void)
+{
+}
+#define GLI_LINT_CALLER() NULL
+#define GLI_LINT_IF_AT(cond, issue, site)                                                                              \
+    do {                                                                                                               \
+        (void)(site);                                                                                                  \
+    } while (0)
+#endif
+// Record issue against the application call site when cond holds. cond isn't evaluated unless GLI_LINT is enabled
+#define GLI_LINT_IF(cond, issue) GLI_LINT_IF_AT(cond, issue, GLI_LINT_CALLER())
+// Argument checks in the draw, pointer, bind, current value and texture environment entry points. A GLI_NO_ERROR build
+// drops them, so invalid arguments there are undefined behaviour rather than an error. GL_OUT_OF_MEMORY is still set
+#if GLI_NO_ERROR
+#define GLI_INVALID(cond) GL_FALSE
+#else
+#define GLI_INVALID(cond) __builtin_expect(!!(cond), 0)
+#endif
 GLsizei gliScanMaxIndex(GLenum type, const void *indices, GLsizei count);
+void *gliStagingAlloc(GLuint size);
+GLboolean gliPaletteDrawActive(void);
+void gliPaletteDraw(GLenum mode, GLint first, GLsizei count, GLenum type, const void *indices);
 void gliLightingFlush(void);
 void gliTransformFlush(void);
 void gliTextureFlush(void);
+GLubyte *gliTextureAlloc(GLuint size);
+void gliTextureFree(GLubyte *data, GLuint size);
+void gliTextureRelease(xgu_texture_t *xgu_texture);
+GLboolean gliTextureMakeResident(texture_object_t *texture_object);
 void gliFogFlush(void);
 void gliPointParamsFlush(void);
-GLvoid *gliGetBufferPointer(GLuint buffer_binding, const GLvoid *ptr);
+GLvoid *gliGetBufferPointer(const buffer_object_t *buffer, const GLvoid *ptr);
+const GLvoid *gliGetBufferCpuPointer(buffer_object_t *buffer, const GLvoid *ptr);
 gli_context_t *gliGetContext(void);
 GLuint gliFormatToBpp(GLenum format);
 GLuint gliEnumtoByteSize(GLenum type);
@@ -525,6 +1022,12 @@ void *gli_memcpy(void *dst, const void *src, size_t n);
 void *gli_memset(void *dst, int c, size_t n);
 void gliCalcMipmapChain(GLuint width, GLuint height, GLuint bytes_per_pixel, GLuint *out_size, uint8_t *out_levels);
 void gliGenSwizzledMipmaps(xgu_texture_t *xgu_texture);
+GLuint gliCompressedLevelSize(GLuint width, GLuint height, GLuint block_size);
+void gliCalcCompressedMipmapChain(GLuint width, GLuint height, GLuint block_size, GLuint *out_size, uint8_t *out_levels);
+void gliTranscodeETC1ToDXT1(const GLubyte *src, GLubyte *dst, GLuint block_count);
+void gliCompressedPalettedTexImage2D(
+    GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLsizei imageSize, const void *data);
+void gliHardwareTextureMatrix(gli_context_t *context, GLuint unit, const xgu_texture_t *xgu_texture, mat4 out);
 void gliCalculateHardwareScissor(gli_context_t *context, GLint *sx, GLint *sy, GLint *sw, GLint *sh);
 
 static inline GLfloat gliFixedtoFloat(GLfixed x)
@@ -553,6 +1056,36 @@ static inline mat4 *gliCurrentModelView(void)
                 .modelview_matrix_stack[context->transformation_state.modelview_matrix_stack_depth - 1];
 }
 
+static inline void gliCount(gli_counter_t counter, GLuint amount)
+{
+    gliGetContext()->frame_counters[counter] += amount;
+}
+
+// The texture object a unit samples from, or NULL if texturing is disabled on it. An enabled cube map takes precedence
+// over an enabled 2D texture
+static inline texture_object_t *gliSampledTextureObject(const texture_unit_t *texture_unit)
+{
+    if (texture_unit->texture_cube_map_enabled) {
+        return texture_unit->bound_cube_map_object;
+    }
+    if (texture_unit->texture_2d_enabled) {
+        return texture_unit->bound_texture_object;
+    }
+    return NULL;
+}
+
+// CPU time stamp counter. The Xbox CPU clock is fixed, so it is a steady time base
+static inline uint64_t gliReadTsc(void)
+{
+    return __builtin_ia32_rdtsc();
+}
+
+static inline uint64_t gliTscToNanoseconds(uint64_t tsc)
+{
+    // Split so the multiply can't overflow
+    return (tsc / GLI_TSC_FREQUENCY) * 1000000000ULL + ((tsc % GLI_TSC_FREQUENCY) * 1000000000ULL) / GLI_TSC_FREQUENCY;
+}
+
 /** Convert GLuint in [0,4294967295] to GLfloat in [0.0,1.0] */
 #define UINT_TO_FLOAT(U) ((GLfloat)((U) * (1.0F / 4294967295.0)))
 
@@ -0,0 +1,149 @@
+#include "gles_private.h"
+#include <stdarg.h>
+#include <stb_sprintf.h>
+
+// Draw path profiling. Define GLI_PROFILE as 1 to time each stage of the draw path with rdtsc. Every scope adds its
+// time to a per stage counter for the frame being built, and glFlipNV2A moves those to the last frame counters read
+// by glGetProfileNV2A. Between glTraceNV2A(GL_TRUE) and glTraceNV2A(GL_FALSE) each scope is also recorded as an event
+// for glExportTraceNV2A to write out as Chrome trace event JSON (chrome://tracing or ui.perfetto.dev).
+// With GLI_PROFILE at 0 the scopes compile away and the entry points report nothing.
+
+static const char *const scope_names[GLI_SCOPE_COUNT] = {
+    "gliFBOFlush",
+    "gliTransformFlush",
+    "gliFogFlush",
+    "gliTextureFlush",
+    "combiner_set_texture_env",
+    "gliPointParamsFlush",
+    "gliLightingFlush",
+    "gliArrayFlush",
+    "gliVertexProgramFlush",
+    "staging",
+    "index submission",
+    "glFlipNV2A",
+};
+
+#if GLI_PROFILE
+void gliProfileRecord(gli_profile_scope_t scope, uint64_t start_tsc)
+{
+    gli_context_t *context = gliGetContext();
+    const uint64_t end_tsc = gliReadTsc();
+
+    context->profile_frame[scope].tsc += end_tsc - start_tsc;
+    context->profile_frame[scope].calls++;
+
+    if (context->trace_enabled && context->trace_event_count < GLI_PROFILE_TRACE_EVENTS) {
+        trace_event_t *event = &context->trace_events[context->trace_event_count++];
+        event->start_tsc = start_tsc;
+        event->end_tsc = end_tsc;
+        event->scope = scope;
+    }
+}
+
+void gliProfileFlip(void)
+{
+    gli_context_t *context = gliGetContext();
+    for (GLuint i = 0; i < GLI_SCOPE_COUNT; i++) {
+        context->profile_last_frame[i] = context->profile_frame[i];
+        context->profile_frame[i].tsc = 0;
+        context->profile_frame[i].calls = 0;
+    }
+}
+#endif
+
+GLint glGetProfileNV2A(GLint count, GLprofileScopeNV2A *scopes)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (count < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return 0;
+    }
+    if (!GLI_PROFILE) {
+        return 0;
+    }
+
+    const GLint filled = GLI_MIN(count, (GLint)GLI_SCOPE_COUNT);
+    for (GLint i = 0; i < filled; i++) {
+        scopes[i].name = scope_names[i];
+        scopes[i].time_ns = gliTscToNanoseconds(context->profile_last_frame[i].tsc);
+        scopes[i].calls = context->profile_last_frame[i].calls;
+    }
+    return filled;
+}
+
+void glTraceNV2A(GLboolean enable)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (!GLI_PROFILE || enable == context->trace_enabled) {
+        return;
+    }
+
+    // Starting a trace drops the events of the previous one. They are kept after stopping until then, for export
+    if (enable) {
+        if (context->trace_events == NULL) {
+            context->trace_events = GLI_MALLOC(GLI_PROFILE_TRACE_EVENTS * sizeof(trace_event_t));
+            if (context->trace_events == NULL) {
+                gliSetError(GL_OUT_OF_MEMORY);
+                return;
+            }
+        }
+        context->trace_event_count = 0;
+        context->trace_start_tsc = gliReadTsc();
+    }
+    context->trace_enabled = enable;
+}
+
+// Append to the output like snprintf, counting the full length even once the buffer is full
+static GLsizei trace_printf(char *buffer, GLsizei size, GLsizei length, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    const GLsizei space = (length < size) ? size - length : 0;
+    const int n = stbsp_vsnprintf((space > 0) ? buffer + length : NULL, space, fmt, ap);
+    va_end(ap);
+    return length + n;
+}
+
+// Microseconds with three decimals, as the trace format wants, without going through floats
+static GLsizei trace_print_us(char *buffer, GLsizei size, GLsizei length, const char *key, uint64_t tsc)
+{
+    const uint64_t ns = gliTscToNanoseconds(tsc);
+    return trace_printf(buffer,
+                        size,
+                        length,
+                        "\"%s\":%llu.%03u",
+                        key,
+                        (unsigned long long)(ns / 1000),
+                        (unsigned)(ns % 1000));
+}
+
+// Write the recorded trace to buffer as Chrome trace event JSON. Returns the length of the whole trace, not counting
+// the terminator, so a call with a NULL buffer and size 0 gives the size needed. Output that doesn't fit is cut short
+GLsizei glExportTraceNV2A(char *buffer, GLsizei size)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (size < 0 || (buffer == NULL && size > 0)) {
+        gliSetError(GL_INVALID_VALUE);
+        return 0;
+    }
+
+    GLsizei length = trace_printf(buffer, size, 0, "{\"traceEvents\":[");
+    for (GLuint i = 0; i < context->trace_event_count; i++) {
+        const trace_event_t *event = &context->trace_events[i];
+        length = trace_printf(buffer,
+                              size,
+                              length,
+                              "%s{\"name\":\"%s\",\"cat\":\"gles\",\"ph\":\"X\",\"pid\":1,\"tid\":1,",
+                              (i > 0) ? "," : "",
+                              scope_names[event->scope]);
+        length = trace_print_us(buffer, size, length, "ts", event->start_tsc - context->trace_start_tsc);
+        length = trace_printf(buffer, size, length, ",");
+        length = trace_print_us(buffer, size, length, "dur", event->end_tsc - event->start_tsc);
+        length = trace_printf(buffer, size, length, "}");
+    }
+    length = trace_printf(buffer, size, length, "]}\n");
+    return length;
+}
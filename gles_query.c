@@ -0,0 +1,508 @@
+#include "gles_private.h"
+
+// Query objects for EXT_occlusion_query_boolean and EXT_disjoint_timer_query.
+//
+// Occlusion queries (plus GL_SAMPLES_PASSED for the sample count).
+// NV2A counts the samples that pass the depth test while NV097_SET_ZPASS_PIXEL_COUNT_ENABLE is set. glBeginQueryEXT
+// clears the counter and starts counting. glEndQueryEXT has the GPU write the count to the query's 16 byte slot in a
+// slab of contiguous memory, then inserts a fence. The result is available once the GPU passes that fence, so polling
+// GL_QUERY_RESULT_AVAILABLE_EXT never stalls. Only reading GL_QUERY_RESULT_EXT early waits for the GPU.
+//
+// Timer queries.
+// Every report the GPU writes starts with a 64-bit PTIMER timestamp in nanoseconds, taken once the work pushed before
+// it has finished. Each timer marker has the GPU write a report to its own slot, then inserts a fence. gliQueryInit
+// reads PTIMER and the CPU time stamp counter together, so marker times and GL_TIMESTAMP_EXT can be moved between the
+// two clocks with a fixed offset. If the reports don't carry real timestamps, as on some emulators, a marker is instead
+// timed with the time stamp counter when its fence is first seen to have passed. gliTimerPoll checks for that on every
+// draw, in every fence wait and at flip, so the time can be late by up to the gap until the next of those.
+
+// Channel 20 and 21 are used by gliFBOFlush and 22 by the fences
+#define QUERY_DMA_CHANNEL 23
+
+// Each report is a 64-bit timestamp, the 32-bit value then a 32-bit status
+#define REPORT_SIZE            16
+#define REPORT_TIMESTAMP_INDEX 0
+#define REPORT_VALUE_INDEX     2
+
+// PTIMER, in the NV2A's register space
+#define NV2A_MMIO_BASE  0xFD000000
+#define NV_PTIMER_BASE  0x00009000
+#define PTIMER_REGISTER(offset) (*(volatile uint32_t *)(NV2A_MMIO_BASE + NV_PTIMER_BASE + (offset)))
+
+static uint64_t read_ptimer(void)
+{
+    // Read the high word either side of the low one so a carry between the two reads is caught
+    uint32_t high, low;
+    do {
+        high = PTIMER_REGISTER(NV_PTIMER_TIME_1);
+        low = PTIMER_REGISTER(NV_PTIMER_TIME_0);
+    } while (high != PTIMER_REGISTER(NV_PTIMER_TIME_1));
+    return ((uint64_t)high << 32) | low;
+}
+
+static uint64_t report_timestamp(gli_context_t *context, GLuint report)
+{
+    const volatile GLuint *data = &context->query_reports[report * (REPORT_SIZE / 4) + REPORT_TIMESTAMP_INDEX];
+    return ((uint64_t)data[1] << 32) | data[0];
+}
+
+// Have the GPU write a report to the slot once everything pushed so far has finished. The zpass count type is used
+// for timer reports too; the count is ignored and only the timestamp is read back
+static void push_report(gli_context_t *context, GLuint report)
+{
+    uint32_t *pb = pb_begin();
+    pb = pb_push1(pb, NV097_SET_CONTEXT_DMA_REPORT, context->query_dma.ChannelID);
+    pb = pb_push1(pb,
+                  NV097_GET_REPORT,
+                  PB_MASK(NV097_GET_REPORT_OFFSET, report * REPORT_SIZE) |
+                      PB_MASK(NV097_GET_REPORT_TYPE, NV097_GET_REPORT_TYPE_ZPASS_PIXEL_CNT));
+    pb_end(pb);
+}
+
+uint64_t gliGpuTimeToTsc(uint64_t gpu_time)
+{
+    gli_context_t *context = gliGetContext();
+    const uint64_t ns = gpu_time - context->gpu_time_base;
+    // Split so the multiply can't overflow
+    return context->tsc_base + (ns / 1000000000ULL) * GLI_TSC_FREQUENCY +
+           ((ns % 1000000000ULL) * GLI_TSC_FREQUENCY) / 1000000000ULL;
+}
+
+uint64_t gliTscToGpuTime(uint64_t tsc)
+{
+    gli_context_t *context = gliGetContext();
+    return context->gpu_time_base + gliTscToNanoseconds(tsc - context->tsc_base);
+}
+
+void gliQueryInit(void)
+{
+    gli_context_t *context = gliGetContext();
+
+    const GLuint size = GLI_REPORT_COUNT * REPORT_SIZE;
+    context->query_reports =
+        MmAllocateContiguousMemoryEx(size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE | PAGE_WRITECOMBINE);
+    assert(context->query_reports != NULL);
+    gli_memset((void *)context->query_reports, 0, size);
+
+    // Report offsets are only 24 bits, so the DMA context starts at the slab rather than at the start of memory
+    const GLuint physical_address = (GLuint)MmGetPhysicalAddress((void *)context->query_reports);
+    pb_create_dma_ctx(QUERY_DMA_CHANNEL, DMA_CLASS_3D, physical_address, size - 1, &context->query_dma);
+    pb_bind_channel(&context->query_dma);
+
+    // Hand out the lowest slots first
+    for (GLuint i = 0; i < GLI_MAX_QUERIES; i++) {
+        context->query_free_slots[i] = GLI_MAX_QUERIES - 1 - i;
+    }
+    context->query_free_count = GLI_MAX_QUERIES;
+    context->active_occlusion_query = NULL;
+    context->active_timer_query = NULL;
+    context->timer_marker_head = 0;
+    context->timer_marker_count = 0;
+
+    // Line PTIMER up with the time stamp counter, taking the counter either side of the register read
+    const uint64_t tsc_before = gliReadTsc();
+    context->gpu_time_base = read_ptimer();
+    const uint64_t tsc_after = gliReadTsc();
+    context->tsc_base = tsc_before + (tsc_after - tsc_before) / 2;
+
+    // Only trust report timestamps if one taken now lands between the calibration and a fresh PTIMER read
+    push_report(context, GLI_REPORT_CALIBRATION);
+    gliFenceWait(gliFenceInsert());
+    const uint64_t timestamp = report_timestamp(context, GLI_REPORT_CALIBRATION);
+    context->gpu_timestamps =
+        (timestamp >= context->gpu_time_base && timestamp <= read_ptimer()) ? GL_TRUE : GL_FALSE;
+}
+
+void gliTimerPoll(void)
+{
+    gli_context_t *context = gliGetContext();
+    const uint64_t now = gliReadTsc();
+
+    // Markers are queued in fence order, so stop at the first one the GPU has not reached
+    while (context->timer_marker_count > 0) {
+        timer_marker_t *marker = &context->timer_markers[context->timer_marker_head];
+        if (!gliFenceReached(marker->fence)) {
+            break;
+        }
+        if (marker->tsc) {
+            const GLboolean timestamped = context->gpu_timestamps && marker->report != GLI_NO_REPORT;
+            *marker->tsc = timestamped ? gliGpuTimeToTsc(report_timestamp(context, marker->report)) : now;
+        }
+        context->timer_marker_head = (context->timer_marker_head + 1) % GLI_MAX_TIMER_MARKERS;
+        context->timer_marker_count--;
+    }
+}
+
+// Queue a marker that writes its time to tsc once the GPU reaches it. The GPU timestamps it into the report slot, if
+// one is given. Returns the marker's fence
+GLuint gliTimerMarkerInsert(uint64_t *tsc, GLint report)
+{
+    gli_context_t *context = gliGetContext();
+
+    // Make room by waiting for the oldest marker, which gliFenceWait times as it retires
+    if (context->timer_marker_count == GLI_MAX_TIMER_MARKERS) {
+        gliFenceWait(context->timer_markers[context->timer_marker_head].fence);
+    }
+
+    if (report != GLI_NO_REPORT) {
+        push_report(context, (GLuint)report);
+    }
+
+    *tsc = 0;
+    const GLuint fence = gliFenceInsert();
+    const GLuint tail = (context->timer_marker_head + context->timer_marker_count) % GLI_MAX_TIMER_MARKERS;
+    context->timer_markers[tail].fence = fence;
+    context->timer_markers[tail].report = report;
+    context->timer_markers[tail].tsc = tsc;
+    context->timer_marker_count++;
+    return fence;
+}
+
+static query_object_t *find_query_object(GLuint name)
+{
+    gli_context_t *context = gliGetContext();
+    return (query_object_t *)gliNameLookup(&context->query_names, name);
+}
+
+// The active query binding for a glBeginQueryEXT target. All occlusion targets share the one hardware counter
+static query_object_t **active_query(gli_context_t *context, GLenum target)
+{
+    switch (target) {
+        case GL_ANY_SAMPLES_PASSED_EXT:
+        case GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT:
+        case GL_SAMPLES_PASSED:
+            return &context->active_occlusion_query;
+        case GL_TIME_ELAPSED_EXT:
+            return &context->active_timer_query;
+        default:
+            return NULL;
+    }
+}
+
+static void end_occlusion_query(gli_context_t *context)
+{
+    query_object_t *query = context->active_occlusion_query;
+
+    push_report(context, query->slot);
+    uint32_t *pb = pb_begin();
+    pb = pb_push1(pb, NV097_SET_ZPASS_PIXEL_COUNT_ENABLE, 0);
+    pb_end(pb);
+
+    query->fence = gliFenceInsert();
+    context->active_occlusion_query = NULL;
+}
+
+static void end_timer_query(gli_context_t *context)
+{
+    query_object_t *query = context->active_timer_query;
+    query->fence = gliTimerMarkerInsert(&query->end_tsc, (GLint)query->slot);
+    context->active_timer_query = NULL;
+}
+
+// Work out the result once the GPU is done with the query, waiting for it if wait is set. Returns GL_FALSE if the
+// result is not available yet
+static GLboolean resolve_query(gli_context_t *context, query_object_t *query, GLboolean wait)
+{
+    if (query->resolved) {
+        return GL_TRUE;
+    }
+    if (!gliFenceReached(query->fence)) {
+        if (!wait) {
+            return GL_FALSE;
+        }
+        gliFenceWait(query->fence);
+    }
+
+    switch (query->target) {
+        case GL_TIME_ELAPSED_EXT:
+            gliTimerPoll();
+            query->result = gliTscToNanoseconds(query->end_tsc - query->begin_tsc);
+            break;
+        case GL_TIMESTAMP_EXT:
+            gliTimerPoll();
+            query->result = gliTscToGpuTime(query->end_tsc);
+            break;
+        default: {
+            const GLuint count = context->query_reports[query->slot * (REPORT_SIZE / 4) + REPORT_VALUE_INDEX];
+            query->result = (query->target == GL_SAMPLES_PASSED) ? count : (count != 0);
+            break;
+        }
+    }
+    query->resolved = GL_TRUE;
+    return GL_TRUE;
+}
+
+// A query object, and its report slot, only exists once a generated name is first used by glBeginQueryEXT or
+// glQueryCounterEXT. Sets the error and returns NULL if the name wasn't generated or nothing is left to create it with
+static query_object_t *create_query_object(gli_context_t *context, GLuint name)
+{
+    if (!gliNameIsUsed(&context->query_names, name)) {
+        gliSetError(GL_INVALID_OPERATION);
+        return NULL;
+    }
+    if (context->query_free_count == 0) {
+        gliSetError(GL_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    query_object_t *query = GLI_MALLOC(sizeof(query_object_t));
+    if (query == NULL) {
+        gliSetError(GL_OUT_OF_MEMORY);
+        return NULL;
+    }
+    gli_memset(query, 0, sizeof(query_object_t));
+
+    if (!gliNameInsert(&context->query_names, name, query)) {
+        GLI_FREE(query);
+        gliSetError(GL_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    query->name = name;
+    query->slot = context->query_free_slots[--context->query_free_count];
+    query->resolved = GL_TRUE;
+    return query;
+}
+
+GL_API void GL_APIENTRY glGenQueriesEXT(GLsizei n, GLuint *ids)
+{
+    gli_context_t *context = gliGetContext();
+    if (ids == NULL || n < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    // Only the names are reserved here. Apps often generate a pool of them up front, so the objects and report slots
+    // wait for first use
+    for (GLsizei i = 0; i < n; i++) {
+        ids[i] = gliNameGen(&context->query_names);
+    }
+}
+
+GL_API void GL_APIENTRY glDeleteQueriesEXT(GLsizei n, const GLuint *ids)
+{
+    gli_context_t *context = gliGetContext();
+    if (ids == NULL || n < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    for (GLsizei i = 0; i < n; i++) {
+        query_object_t *query = find_query_object(ids[i]);
+        if (query == NULL) {
+            gliNameRemove(&context->query_names, ids[i]); // Generated but never used
+            continue;
+        }
+
+        // Deleting an active query ends it. Any report still in flight lands in the slot before a later query's report
+        // can, so the slot can be handed straight out again
+        if (query == context->active_occlusion_query) {
+            end_occlusion_query(context);
+        }
+        if (query == context->active_timer_query) {
+            end_timer_query(context);
+        }
+        for (GLuint m = 0; m < GLI_MAX_TIMER_MARKERS; m++) {
+            timer_marker_t *marker = &context->timer_markers[m];
+            if (marker->tsc == &query->begin_tsc || marker->tsc == &query->end_tsc) {
+                marker->tsc = NULL;
+            }
+        }
+
+        gliNameRemove(&context->query_names, query->name);
+        context->query_free_slots[context->query_free_count++] = query->slot;
+        GLI_FREE(query);
+    }
+}
+
+GL_API GLboolean GL_APIENTRY glIsQueryEXT(GLuint id)
+{
+    // A generated name only becomes a query object once it has been used
+    query_object_t *query = find_query_object(id);
+    return (query != NULL && query->target != 0) ? GL_TRUE : GL_FALSE;
+}
+
+GL_API void GL_APIENTRY glBeginQueryEXT(GLenum target, GLuint id)
+{
+    gli_context_t *context = gliGetContext();
+    query_object_t **active = active_query(context, target);
+    if (active == NULL) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (*active != NULL) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    query_object_t *query = find_query_object(id);
+    if (query == NULL && (query = create_query_object(context, id)) == NULL) {
+        return;
+    }
+    if ((query->target != 0 && query->target != target) || query == context->active_occlusion_query ||
+        query == context->active_timer_query) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    query->target = target;
+    query->resolved = GL_FALSE;
+    *active = query;
+
+    if (target == GL_TIME_ELAPSED_EXT) {
+        gliTimerMarkerInsert(&query->begin_tsc, GLI_REPORT_QUERY_BEGIN(query->slot));
+        return;
+    }
+
+    uint32_t *pb = pb_begin();
+    pb = pb_push1(pb, NV097_CLEAR_REPORT_VALUE, NV097_CLEAR_REPORT_VALUE_TYPE_ZPASS_PIXEL_CNT);
+    pb = pb_push1(pb, NV097_SET_ZPASS_PIXEL_COUNT_ENABLE, 1);
+    pb_end(pb);
+}
+
+GL_API void GL_APIENTRY glEndQueryEXT(GLenum target)
+{
+    gli_context_t *context = gliGetContext();
+    query_object_t **active = active_query(context, target);
+    if (active == NULL) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (*active == NULL || (*active)->target != target) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    if (target == GL_TIME_ELAPSED_EXT) {
+        end_timer_query(context);
+    } else {
+        end_occlusion_query(context);
+    }
+}
+
+GL_API void GL_APIENTRY glQueryCounterEXT(GLuint id, GLenum target)
+{
+    gli_context_t *context = gliGetContext();
+    if (target != GL_TIMESTAMP_EXT) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    query_object_t *query = find_query_object(id);
+    if (query == NULL && (query = create_query_object(context, id)) == NULL) {
+        return;
+    }
+    if ((query->target != 0 && query->target != target) || query == context->active_occlusion_query ||
+        query == context->active_timer_query) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    query->target = target;
+    query->resolved = GL_FALSE;
+    query->fence = gliTimerMarkerInsert(&query->end_tsc, (GLint)query->slot);
+}
+
+GL_API void GL_APIENTRY glGetQueryivEXT(GLenum target, GLenum pname, GLint *params)
+{
+    gli_context_t *context = gliGetContext();
+    query_object_t **active = active_query(context, target);
+    if (active == NULL && target != GL_TIMESTAMP_EXT) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (params == NULL) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    switch (pname) {
+        case GL_CURRENT_QUERY_EXT:
+            params[0] = (active != NULL && *active != NULL && (*active)->target == target) ? (GLint)(*active)->name : 0;
+            break;
+        case GL_QUERY_COUNTER_BITS_EXT:
+            // Occlusion queries count with 32 bits. Timer results are 64-bit nanoseconds on the PTIMER clock
+            params[0] = (target == GL_TIME_ELAPSED_EXT || target == GL_TIMESTAMP_EXT) ? 64 : 32;
+            break;
+        default:
+            gliSetError(GL_INVALID_ENUM);
+            break;
+    }
+}
+
+// Shared by the glGetQueryObject* variants. Returns GL_FALSE on error
+static GLboolean get_query_object(GLuint id, GLenum pname, uint64_t *result)
+{
+    gli_context_t *context = gliGetContext();
+
+    query_object_t *query = find_query_object(id);
+    if (query == NULL || query->target == 0 || query == context->active_occlusion_query ||
+        query == context->active_timer_query) {
+        gliSetError(GL_INVALID_OPERATION);
+        return GL_FALSE;
+    }
+
+    switch (pname) {
+        case GL_QUERY_RESULT_EXT:
+            resolve_query(context, query, GL_TRUE);
+            *result = query->result;
+            return GL_TRUE;
+        case GL_QUERY_RESULT_AVAILABLE_EXT:
+            *result = resolve_query(context, query, GL_FALSE);
+            return GL_TRUE;
+        default:
+            gliSetError(GL_INVALID_ENUM);
+            return GL_FALSE;
+    }
+}
+
+GL_API void GL_APIENTRY glGetQueryObjectuivEXT(GLuint id, GLenum pname, GLuint *params)
+{
+    uint64_t result;
+    if (params == NULL) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    if (get_query_object(id, pname, &result)) {
+        params[0] = (GLuint)GLI_MIN(result, 0xFFFFFFFFULL);
+    }
+}
+
+GL_API void GL_APIENTRY glGetQueryObjectivEXT(GLuint id, GLenum pname, GLint *params)
+{
+    uint64_t result;
+    if (params == NULL) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    if (get_query_object(id, pname, &result)) {
+        params[0] = (GLint)GLI_MIN(result, 0x7FFFFFFFULL);
+    }
+}
+
+GL_API void GL_APIENTRY glGetQueryObjectui64vEXT(GLuint id, GLenum pname, GLuint64 *params)
+{
+    uint64_t result;
+    if (params == NULL) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    if (get_query_object(id, pname, &result)) {
+        params[0] = result;
+    }
+}
+
+GL_API void GL_APIENTRY glGetQueryObjecti64vEXT(GLuint id, GLenum pname, GLint64 *params)
+{
+    uint64_t result;
+    if (params == NULL) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    if (get_query_object(id, pname, &result)) {
+        params[0] = (GLint64)result;
+    }
+}
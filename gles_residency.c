@@ -0,0 +1,130 @@
+#include "gles_private.h"
+
+// Texture residency. All texture storage in contiguous memory goes through gliTextureAlloc so usage can be kept under
+// GLI_TEXTURE_MEMORY_BUDGET. When the budget is exceeded, or contiguous memory runs out, the least recently used
+// textures are copied out to normal RAM and their contiguous memory released. They are copied back the next time
+// gliTextureFlush finds them bound to an enabled unit.
+
+static GLboolean texture_is_attached(gli_context_t *context, texture_object_t *texture_object)
+{
+    for (framebuffer_object_t *it = context->framebuffer_objects; it != NULL; it = it->next) {
+        if (it->color.type == GL_TEXTURE_2D && it->color.texture == texture_object) {
+            return GL_TRUE;
+        }
+    }
+    return GL_FALSE;
+}
+
+static texture_object_t *find_lru_texture(gli_context_t *context)
+{
+    texture_object_t *lru = NULL;
+    for (texture_object_t *it = context->texture_environment.texture_objects; it != NULL; it = it->next) {
+        xgu_texture_t *xgu_texture = (xgu_texture_t *)it->texture_2d;
+        if (xgu_texture == NULL || xgu_texture->data == NULL) {
+            continue;
+        }
+
+        // Prefer textures no recent frame used. Anything used this frame, or a frame still queued on the GPU, is likely
+        // to be drawn with again. Render targets are never evicted
+        if (it->last_used_frame + context->max_frames_in_flight >= context->frame_count ||
+            texture_is_attached(context, it)) {
+            continue;
+        }
+
+        if (lru == NULL || it->last_used_frame < lru->last_used_frame) {
+            lru = it;
+        }
+    }
+    return lru;
+}
+
+static GLboolean evict_texture(texture_object_t *texture_object)
+{
+    xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
+
+    GLubyte *backing = GLI_MALLOC(xgu_texture->data_size);
+    if (backing == NULL) {
+        return GL_FALSE;
+    }
+    gli_memcpy(backing, xgu_texture->data, xgu_texture->data_size);
+
+    // Nothing waits for the GPU at flip with a swap interval of 0 or frames in flight, so the age check above doesn't
+    // prove the GPU is done with the texture. gliTextureFree only returns the memory once the GPU passes a fence
+    gliTextureFree(xgu_texture->data, xgu_texture->data_size);
+    xgu_texture->data = NULL;
+    xgu_texture->data_physical_address = NULL;
+    xgu_texture->backing = backing;
+    texture_object->texture_object_dirty = GL_TRUE;
+    return GL_TRUE;
+}
+
+GLubyte *gliTextureAlloc(GLuint size)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (GLI_TEXTURE_MEMORY_BUDGET > 0) {
+        while (context->texture_resident_bytes + size > GLI_TEXTURE_MEMORY_BUDGET) {
+            texture_object_t *lru = find_lru_texture(context);
+            if (lru == NULL || !evict_texture(lru)) {
+                break; // Nothing left to evict. Go over budget rather than fail
+            }
+        }
+    }
+
+    GLubyte *data;
+    while ((data = gliContiguousAlloc(size, PAGE_READWRITE | PAGE_WRITECOMBINE)) == NULL) {
+        texture_object_t *lru = find_lru_texture(context);
+        if (lru == NULL || !evict_texture(lru)) {
+            return NULL;
+        }
+    }
+
+    context->texture_resident_bytes += size;
+    return data;
+}
+
+void gliTextureFree(GLubyte *data, GLuint size)
+{
+    gli_context_t *context = gliGetContext();
+    gliDeferredFree(data, size, PAGE_READWRITE | PAGE_WRITECOMBINE);
+    context->texture_resident_bytes -= size;
+}
+
+// Free all storage of a texture, resident or not
+void gliTextureRelease(xgu_texture_t *xgu_texture)
+{
+    if (xgu_texture->data) {
+        gliTextureFree(xgu_texture->data, xgu_texture->data_size);
+        xgu_texture->data = NULL;
+    }
+    if (xgu_texture->backing) {
+        GLI_FREE(xgu_texture->backing);
+        xgu_texture->backing = NULL;
+    }
+}
+
+// Bring an evicted texture back into contiguous memory. It also counts as used this frame, so it is not immediately
+// picked for eviction again by a following allocation
+GLboolean gliTextureMakeResident(texture_object_t *texture_object)
+{
+    gli_context_t *context = gliGetContext();
+    xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
+
+    texture_object->last_used_frame = context->frame_count;
+    if (xgu_texture == NULL || xgu_texture->data != NULL) {
+        return GL_TRUE;
+    }
+
+    GLubyte *data = gliTextureAlloc(xgu_texture->data_size);
+    if (data == NULL) {
+        return GL_FALSE;
+    }
+    gli_memcpy(data, xgu_texture->backing, xgu_texture->data_size);
+    GLI_FREE(xgu_texture->backing);
+
+    xgu_texture->backing = NULL;
+    xgu_texture->data = data;
+    xgu_texture->data_physical_address = (GLubyte *)MmGetPhysicalAddress(data);
+    texture_object->texture_object_dirty = GL_TRUE;
+    return GL_TRUE;
+}
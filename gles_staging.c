@@ -40,6 +40,21 @@ void gliStagingDestroy(void)
     }
 }
 
+// Allocate GPU-accessible memory from the staging arena for data generated at draw time.
+// Returns NULL on arena overflow.
+void *gliStagingAlloc(GLuint size)
+{
+    gli_context_t *context = gliGetContext();
+    arena_t *arena = &context->staging_arena;
+
+    // Round robin if we will go over capacity
+    if (arena_available(arena) < size) {
+        arena_reset(arena);
+        gliCount(GLI_COUNTER_STAGING_WRAPS, 1);
+    }
+    return arena_alloc(arena, size);
+}
+
 // Check if this source range is fully contained within an already-staged range.
 // If so, return the destination pointer adjusted for the offset, otherwise return NULL.
 static void *find_staged_overlap(const staged_range_t *ranges,
@@ -59,7 +74,7 @@ static void *find_staged_overlap(const staged_range_t *ranges,
 // Copy a source range into the staging arena. Checks for interleaving first.
 // Returns the new GPU-accessible pointer, or NULL on arena overflow.
 static void *stage_range(
-    arena_t *arena, staged_range_t *ranges, int *range_count, const void *ptr, GLsizei stride, GLsizei vertex_count)
+    staged_range_t *ranges, int *range_count, const void *ptr, GLsizei stride, GLsizei vertex_count)
 {
     const uint8_t *src_start = (const uint8_t *)ptr;
     const uint8_t *src_end = src_start + (vertex_count * stride);
@@ -72,16 +87,12 @@ static void *stage_range(
 
     uint32_t byte_size = (uint32_t)(src_end - src_start);
 
-    // Round robin if we will go over capacity
-    if (arena_available(arena) < byte_size) {
-        arena_reset(arena);
-    }
-
-    void *dst = arena_alloc(arena, byte_size);
+    void *dst = gliStagingAlloc(byte_size);
     if (!dst) {
         return NULL;
     }
     gli_memcpy(dst, src_start, byte_size);
+    gliCount(GLI_COUNTER_STAGED_BYTES, byte_size);
 
     // Record this range for interleaving detection
     if (*range_count < MAX_STAGED_RANGES) {
@@ -104,11 +115,10 @@ static GLsizei compute_stride(GLsizei user_stride, GLint component_count, GLenum
     return (GLsizei)(component_count * gliEnumtoByteSize(type));
 }
 
-GLboolean gliStageClientArrays(GLsizei vertex_count)
+static GLboolean stage_client_arrays(GLsizei vertex_count)
 {
     gli_context_t *context = gliGetContext();
     vertex_array_data_t *vad = &context->vertex_array_data;
-    arena_t *arena = &context->staging_arena;
 
     if (vertex_count <= 0) {
         return GL_TRUE;
@@ -120,7 +130,7 @@ GLboolean gliStageClientArrays(GLsizei vertex_count)
     // --- Vertex array ---
     if (vad->vertex_array_enabled && vad->vertex_array_buffer_binding == 0 && vad->vertex_array_ptr != NULL) {
         GLsizei stride = compute_stride(vad->vertex_array_stride, vad->vertex_array_size, vad->vertex_array_type);
-        void *staged = stage_range(arena, ranges, &range_count, vad->vertex_array_ptr, stride, vertex_count);
+        void *staged = stage_range(ranges, &range_count, vad->vertex_array_ptr, stride, vertex_count);
         if (!staged) {
             goto out_of_memory;
         }
@@ -132,7 +142,7 @@ GLboolean gliStageClientArrays(GLsizei vertex_count)
     // --- Normal array ---
     if (vad->normal_array_enabled && vad->normal_array_buffer_binding == 0 && vad->normal_array_ptr != NULL) {
         GLsizei stride = compute_stride(vad->normal_array_stride, 3, vad->normal_array_type);
-        void *staged = stage_range(arena, ranges, &range_count, vad->normal_array_ptr, stride, vertex_count);
+        void *staged = stage_range(ranges, &range_count, vad->normal_array_ptr, stride, vertex_count);
         if (!staged) {
             goto out_of_memory;
         }
@@ -144,7 +154,7 @@ GLboolean gliStageClientArrays(GLsizei vertex_count)
     // --- Color array ---
     if (vad->color_array_enabled && vad->color_array_buffer_binding == 0 && vad->color_array_ptr != NULL) {
         GLsizei stride = compute_stride(vad->color_array_stride, vad->color_array_size, vad->color_array_type);
-        void *staged = stage_range(arena, ranges, &range_count, vad->color_array_ptr, stride, vertex_count);
+        void *staged = stage_range(ranges, &range_count, vad->color_array_ptr, stride, vertex_count);
         if (!staged) {
             goto out_of_memory;
         }
@@ -159,7 +169,7 @@ GLboolean gliStageClientArrays(GLsizei vertex_count)
             vad->texcoord_array_ptr[i] != NULL) {
             GLsizei stride =
                 compute_stride(vad->texcoord_array_stride[i], vad->texcoord_array_size[i], vad->texcoord_array_type[i]);
-            void *staged = stage_range(arena, ranges, &range_count, vad->texcoord_array_ptr[i], stride, vertex_count);
+            void *staged = stage_range(ranges, &range_count, vad->texcoord_array_ptr[i], stride, vertex_count);
             if (!staged) {
                 goto out_of_memory;
             }
@@ -173,7 +183,7 @@ GLboolean gliStageClientArrays(GLsizei vertex_count)
     if (vad->point_size_array_enabled && vad->point_size_array_buffer_binding == 0 &&
         vad->point_size_array_ptr != NULL) {
         GLsizei stride = compute_stride(vad->point_size_array_stride, 1, vad->point_size_array_type);
-        void *staged = stage_range(arena, ranges, &range_count, vad->point_size_array_ptr, stride, vertex_count);
+        void *staged = stage_range(ranges, &range_count, vad->point_size_array_ptr, stride, vertex_count);
         if (!staged) {
             goto out_of_memory;
         }
@@ -198,10 +208,19 @@ out_of_memory:
     return GL_FALSE;
 }
 
+GLboolean gliStageClientArrays(GLsizei vertex_count)
+{
+    GLI_PROFILE_BEGIN(GLI_SCOPE_STAGING);
+    const GLboolean staged = stage_client_arrays(vertex_count);
+    GLI_PROFILE_END(GLI_SCOPE_STAGING);
+    return staged;
+}
+
 // Scan an index buffer to find the maximum index value.
 // This determines how many vertices we need to stage for glDrawElements.
 GLsizei gliScanMaxIndex(GLenum type, const void *indices, GLsizei count)
 {
+    GLI_PROFILE_BEGIN(GLI_SCOPE_STAGING);
     GLsizei max_idx = 0;
     if (type == GL_UNSIGNED_BYTE) {
         const uint8_t *idx = (const uint8_t *)indices;
@@ -228,6 +247,7 @@ GLsizei gliScanMaxIndex(GLenum type, const void *indices, GLsizei count)
         }
     }
 #endif
+    GLI_PROFILE_END(GLI_SCOPE_STAGING);
     return max_idx;
 }
 
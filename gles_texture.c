@@ -1,27 +1,11 @@
 #include "gles_private.h"
 #include <swizzle.h>
+#include <xmmintrin.h>
 
-texture_object_t *gliFindTextureObject(GLuint name, texture_object_t **prev)
+texture_object_t *gliFindTextureObject(GLuint name)
 {
     gli_context_t *context = gliGetContext();
-    texture_object_t *g_textures_head = context->texture_environment.texture_objects;
-    if (prev) {
-        *prev = NULL;
-    }
-
-    if (name == 0) {
-        return NULL;
-    }
-
-    for (texture_object_t *it = g_textures_head; it != NULL; it = it->next) {
-        if (it->texture_name == name) {
-            return it;
-        }
-        if (prev) {
-            *prev = it;
-        }
-    }
-    return NULL;
+    return (texture_object_t *)gliNameLookup(&context->texture_names, name);
 }
 
 GL_API void GL_APIENTRY glActiveTexture(GLenum texture)
@@ -48,6 +32,7 @@ GL_API void GL_APIENTRY glClientActiveTexture(GLenum texture)
 
 GL_API void GL_APIENTRY glGenTextures(GLsizei n, GLuint *textures)
 {
+    gli_context_t *context = gliGetContext();
     if (textures == NULL) {
         gliSetError(GL_INVALID_VALUE);
         return;
@@ -56,18 +41,8 @@ GL_API void GL_APIENTRY glGenTextures(GLsizei n, GLuint *textures)
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    static GLuint next = 1;
     for (GLsizei i = 0; i < n; i++) {
-        while (1) {
-            if (next == 0) {
-                next++;
-            }
-            if (gliFindTextureObject(next, NULL) == NULL) {
-                break;
-            }
-            next++;
-        }
-        textures[i] = next++;
+        textures[i] = gliNameGen(&context->texture_names);
     }
 }
 
@@ -75,7 +50,12 @@ GL_API void GL_APIENTRY glBindTexture(GLenum target, GLuint texture)
 {
     gli_context_t *context = gliGetContext();
 
-    if (target != GL_TEXTURE_2D) { // GL_TEXTURE_CUBE_MAP_OES maybe?
+#ifdef GL_OES_texture_cube_map
+    const GLboolean cube_map = (target == GL_TEXTURE_CUBE_MAP_OES);
+#else
+    const GLboolean cube_map = GL_FALSE;
+#endif
+    if (GLI_INVALID(target != GL_TEXTURE_2D && !cube_map)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -83,22 +63,31 @@ GL_API void GL_APIENTRY glBindTexture(GLenum target, GLuint texture)
     // The texture object is bound to the active texture texture_unit
     GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
     texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
+    GLuint *binding = (cube_map) ? &texture_unit->texture_binding_cube_map : &texture_unit->texture_binding_2d;
+    texture_object_t **bound_object =
+        (cube_map) ? &texture_unit->bound_cube_map_object : &texture_unit->bound_texture_object;
+    GLI_LINT_IF(*binding == texture, GLI_LINT_REDUNDANT_BIND_TEXTURE);
 
     // If the texture name is zero just unbind any texture currently bound to the target
     if (texture == 0) {
-        texture_unit->texture_binding_2d = 0;
-        texture_unit->bound_texture_object = &texture_unit->unbound_texture_object;
-        texture_unit->bound_texture_object->texture_object_dirty = GL_TRUE;
+        *binding = 0;
+        *bound_object = (cube_map) ? &texture_unit->unbound_cube_map_object : &texture_unit->unbound_texture_object;
+        (*bound_object)->texture_object_dirty = GL_TRUE;
         context->transformation_state.texture_matrix_dirty[texture_index] = GL_TRUE;
         return;
     }
 
     // First check if the object already exists, if so just bind it to the texture_unit and we are done
-    texture_object_t *texture_object = gliFindTextureObject(texture, NULL);
+    texture_object_t *texture_object = gliFindTextureObject(texture);
     if (texture_object != NULL) {
-        texture_unit->texture_binding_2d = texture;
-        texture_unit->bound_texture_object = texture_object;
-        texture_unit->bound_texture_object->texture_object_dirty = GL_TRUE;
+        // A texture object keeps the target it was first bound to
+        if (GLI_INVALID(texture_object->target != target)) {
+            gliSetError(GL_INVALID_OPERATION);
+            return;
+        }
+        *binding = texture;
+        *bound_object = texture_object;
+        texture_object->texture_object_dirty = GL_TRUE;
         context->transformation_state.texture_matrix_dirty[texture_index] = GL_TRUE;
         return;
     }
@@ -115,7 +104,13 @@ GL_API void GL_APIENTRY glBindTexture(GLenum target, GLuint texture)
     // the value for TEXTURE MAG FILTER is LINEAR. s and t wrap modes are both set
     // to REPEAT. The value of GENERATE MIPMAP is false
     gli_memset(texture_object, 0, sizeof(texture_object_t));
+    if (!gliNameInsert(&context->texture_names, texture, texture_object)) {
+        GLI_FREE(texture_object);
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
     texture_object->texture_name = texture;
+    texture_object->target = target;
     texture_object->texture_object_dirty = GL_TRUE;
     texture_object->min_filter = GL_NEAREST_MIPMAP_LINEAR;
     texture_object->mag_filter = GL_LINEAR;
@@ -124,12 +119,15 @@ GL_API void GL_APIENTRY glBindTexture(GLenum target, GLuint texture)
     texture_object->generate_mipmap = GL_FALSE;
 
     // Bind the object to the texture_unit
-    texture_unit->texture_binding_2d = texture;
-    texture_unit->bound_texture_object = texture_object;
+    *binding = texture;
+    *bound_object = texture_object;
     context->transformation_state.texture_matrix_dirty[texture_index] = GL_TRUE;
 
     // Add the object to the context's list
     texture_object->next = context->texture_environment.texture_objects;
+    if (texture_object->next) {
+        texture_object->next->prev = texture_object;
+    }
     context->texture_environment.texture_objects = texture_object;
 }
 
@@ -148,15 +146,18 @@ GL_API void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures)
 
     for (GLint i = 0; i < n; i++) {
         GLuint name = textures[i];
-        texture_object_t *prev = NULL; // Track previous for linked list removal
-        texture_object_t *texture_object = gliFindTextureObject(name, &prev);
+        texture_object_t *texture_object = gliFindTextureObject(name);
+        gliNameRemove(&context->texture_names, name);
         if (texture_object) {
             // Remove from the context's list
-            if (prev) {
-                prev->next = texture_object->next;
+            if (texture_object->prev) {
+                texture_object->prev->next = texture_object->next;
             } else {
                 context->texture_environment.texture_objects = texture_object->next;
             }
+            if (texture_object->next) {
+                texture_object->next->prev = texture_object->prev;
+            }
 
             // If a texture that is currently bound is deleted, the binding reverts to 0
             for (int u = 0; u < GLI_MAX_TEXTURE_UNITS; ++u) {
@@ -166,6 +167,11 @@ GL_API void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures)
                     texture_unit->bound_texture_object = &texture_unit->unbound_texture_object;
                     texture_unit->bound_texture_object->texture_object_dirty = GL_TRUE;
                 }
+                if (texture_unit->texture_binding_cube_map == name) {
+                    texture_unit->texture_binding_cube_map = 0;
+                    texture_unit->bound_cube_map_object = &texture_unit->unbound_cube_map_object;
+                    texture_unit->bound_cube_map_object->texture_object_dirty = GL_TRUE;
+                }
             }
 
             // If a texture is deleted while attached to a framebuffer, it must be detached
@@ -179,9 +185,7 @@ GL_API void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures)
 
             xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
             if (xgu_texture) {
-                if (xgu_texture->data) {
-                    MmFreeContiguousMemory(xgu_texture->data);
-                }
+                gliTextureRelease(xgu_texture);
                 GLI_FREE(xgu_texture);
             }
             GLI_FREE(texture_object);
@@ -192,17 +196,35 @@ GL_API void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures)
 GL_API GLboolean GL_APIENTRY glIsTexture(GLuint texture)
 {
     gli_context_t *context = gliGetContext();
-    texture_object_t *texture_object = gliFindTextureObject(texture, NULL);
+    texture_object_t *texture_object = gliFindTextureObject(texture);
     if (texture == 0 || texture_object == NULL) {
         return GL_FALSE;
     }
     return GL_TRUE;
 }
 
-GL_API void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLint *params)
+// The texture object bound to target on the active texture unit, or NULL if target is not a texture target
+static texture_object_t *target_texture_object(gli_context_t *context, GLenum target)
+{
+    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
+    texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
+    if (target == GL_TEXTURE_2D) {
+        return texture_unit->bound_texture_object;
+    }
+#ifdef GL_OES_texture_cube_map
+    if (target == GL_TEXTURE_CUBE_MAP_OES) {
+        return texture_unit->bound_cube_map_object;
+    }
+#endif
+    return NULL;
+}
+
+// The glTexParameter forms share this, passing on the application call site for GLI_LINT
+static void tex_parameteriv(GLenum target, GLenum pname, const GLint *params, const void *caller)
 {
     gli_context_t *context = gliGetContext();
-    if (target != GL_TEXTURE_2D) { // GL_TEXTURE_CUBE_MAP_OES maybe?
+    texture_object_t *texture_object = target_texture_object(context, target);
+    if (texture_object == NULL) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -212,15 +234,6 @@ GL_API void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLin
         return;
     }
 
-    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
-    texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
-    texture_object_t *texture_object = texture_unit->bound_texture_object;
-
-    if (texture_object == NULL) {
-        gliSetError(GL_INVALID_OPERATION);
-        return;
-    }
-
     switch (pname) {
         case GL_TEXTURE_MIN_FILTER:
             if (params[0] != GL_NEAREST && params[0] != GL_LINEAR && params[0] != GL_NEAREST_MIPMAP_NEAREST &&
@@ -229,6 +242,7 @@ GL_API void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLin
                 gliSetError(GL_INVALID_ENUM);
                 return;
             }
+            GLI_LINT_IF_AT(texture_object->min_filter == params[0], GLI_LINT_REDUNDANT_TEX_PARAMETER, caller);
             texture_object->min_filter = params[0];
             break;
         case GL_TEXTURE_MAG_FILTER:
@@ -236,6 +250,7 @@ GL_API void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLin
                 gliSetError(GL_INVALID_ENUM);
                 return;
             }
+            GLI_LINT_IF_AT(texture_object->mag_filter == params[0], GLI_LINT_REDUNDANT_TEX_PARAMETER, caller);
             texture_object->mag_filter = params[0];
             break;
         case GL_TEXTURE_WRAP_S:
@@ -243,6 +258,7 @@ GL_API void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLin
                 gliSetError(GL_INVALID_ENUM);
                 return;
             }
+            GLI_LINT_IF_AT(texture_object->wrap_s == params[0], GLI_LINT_REDUNDANT_TEX_PARAMETER, caller);
             texture_object->wrap_s = params[0];
             break;
         case GL_TEXTURE_WRAP_T:
@@ -250,18 +266,49 @@ GL_API void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLin
                 gliSetError(GL_INVALID_ENUM);
                 return;
             }
+            GLI_LINT_IF_AT(texture_object->wrap_t == params[0], GLI_LINT_REDUNDANT_TEX_PARAMETER, caller);
             texture_object->wrap_t = params[0];
             break;
         case GL_GENERATE_MIPMAP:
+            GLI_LINT_IF_AT(texture_object->generate_mipmap == (params[0] != 0),
+                           GLI_LINT_REDUNDANT_TEX_PARAMETER,
+                           caller);
             texture_object->generate_mipmap = (params[0]) ? GL_TRUE : GL_FALSE;
             break;
+#ifdef GL_OES_draw_texture
+        case GL_TEXTURE_CROP_RECT_OES:
+            // Only used by glDrawTex, so there is nothing to flush to hardware
+            texture_object->crop_rect[0] = params[0];
+            texture_object->crop_rect[1] = params[1];
+            texture_object->crop_rect[2] = params[2];
+            texture_object->crop_rect[3] = params[3];
+            return;
+#endif
         default:
             gliSetError(GL_INVALID_ENUM);
             return;
     }
+    GLI_LINT_IF_AT(!texture_object->texture_object_dirty, GLI_LINT_TEX_PARAMETER_REDIRTY, caller);
     texture_object->texture_object_dirty = GL_TRUE;
 }
 
+static void tex_parameteri(GLenum target, GLenum pname, GLint param, const void *caller)
+{
+#ifdef GL_OES_draw_texture
+    // The crop rectangle has four values so can only be set through the vector functions
+    if (pname == GL_TEXTURE_CROP_RECT_OES) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+#endif
+    tex_parameteriv(target, pname, &param, caller);
+}
+
+GL_API void GL_APIENTRY glTexParameteriv(GLenum target, GLenum pname, const GLint *params)
+{
+    tex_parameteriv(target, pname, params, GLI_LINT_CALLER());
+}
+
 GL_API void GL_APIENTRY glTexParameterfv(GLenum target, GLenum pname, const GLfloat *params)
 {
     if (!params) {
@@ -275,8 +322,16 @@ GL_API void GL_APIENTRY glTexParameterfv(GLenum target, GLenum pname, const GLfl
         case GL_TEXTURE_WRAP_S:
         case GL_TEXTURE_WRAP_T:
         case GL_GENERATE_MIPMAP:
-            glTexParameterf(target, pname, params[0]);
+            // Nothing in GLES 1.1 uses float parameters, so just cast to int
+            tex_parameteri(target, pname, (GLint)params[0], GLI_LINT_CALLER());
+            break;
+#ifdef GL_OES_draw_texture
+        case GL_TEXTURE_CROP_RECT_OES: {
+            const GLint crop_rect[4] = {(GLint)params[0], (GLint)params[1], (GLint)params[2], (GLint)params[3]};
+            tex_parameteriv(target, pname, crop_rect, GLI_LINT_CALLER());
             break;
+        }
+#endif
         default:
             gliSetError(GL_INVALID_ENUM);
             return;
@@ -296,8 +351,16 @@ GL_API void GL_APIENTRY glTexParameterxv(GLenum target, GLenum pname, const GLfi
         case GL_TEXTURE_WRAP_S:
         case GL_TEXTURE_WRAP_T:
         case GL_GENERATE_MIPMAP:
-            glTexParameterx(target, pname, params[0]);
+            tex_parameteri(target, pname, (GLint)gliFixedtoFloat(params[0]), GLI_LINT_CALLER());
+            break;
+#ifdef GL_OES_draw_texture
+        case GL_TEXTURE_CROP_RECT_OES: {
+            const GLint crop_rect[4] = {(GLint)gliFixedtoFloat(params[0]), (GLint)gliFixedtoFloat(params[1]),
+                                        (GLint)gliFixedtoFloat(params[2]), (GLint)gliFixedtoFloat(params[3])};
+            tex_parameteriv(target, pname, crop_rect, GLI_LINT_CALLER());
             break;
+        }
+#endif
         default:
             gliSetError(GL_INVALID_ENUM);
             return;
@@ -306,30 +369,30 @@ GL_API void GL_APIENTRY glTexParameterxv(GLenum target, GLenum pname, const GLfi
 
 GL_API void GL_APIENTRY glTexParameteri(GLenum target, GLenum pname, GLint param)
 {
-    glTexParameteriv(target, pname, &param);
+    tex_parameteri(target, pname, param, GLI_LINT_CALLER());
 }
 
 GL_API void GL_APIENTRY glTexParameterf(GLenum target, GLenum pname, GLfloat param)
 {
     // Nothing in GLES 1.1 uses float parameters, so just cast to int
-    glTexParameteri(target, pname, (GLint)param);
+    tex_parameteri(target, pname, (GLint)param, GLI_LINT_CALLER());
 }
 
 GL_API void GL_APIENTRY glTexParameterx(GLenum target, GLenum pname, GLfixed param)
 {
-    glTexParameterf(target, pname, gliFixedtoFloat(param));
+    tex_parameteri(target, pname, (GLint)gliFixedtoFloat(param), GLI_LINT_CALLER());
 }
 
 GL_API void GL_APIENTRY glTexEnviv(GLenum target, GLenum pname, const GLint *params)
 {
     gli_context_t *context = gliGetContext();
 
-    if (!params) {
+    if (GLI_INVALID(!params)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
 
-    if (target != GL_TEXTURE_ENV && target != GL_POINT_SPRITE_OES) {
+    if (GLI_INVALID(target != GL_TEXTURE_ENV && target != GL_POINT_SPRITE_OES)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -339,17 +402,10 @@ GL_API void GL_APIENTRY glTexEnviv(GLenum target, GLenum pname, const GLint *par
 
     switch (pname) {
         case GL_TEXTURE_ENV_MODE:
-            switch (params[0]) {
-                case GL_MODULATE:
-                case GL_DECAL:
-                case GL_BLEND:
-                case GL_REPLACE:
-                case GL_ADD:
-                case GL_COMBINE:
-                    break;
-                default:
-                    gliSetError(GL_INVALID_ENUM);
-                    return;
+            if (GLI_INVALID(params[0] != GL_MODULATE && params[0] != GL_DECAL && params[0] != GL_BLEND &&
+                            params[0] != GL_REPLACE && params[0] != GL_ADD && params[0] != GL_COMBINE)) {
+                gliSetError(GL_INVALID_ENUM);
+                return;
             }
             texture_unit->tex_env_mode = (GLenum)params[0];
             break;
@@ -360,34 +416,19 @@ GL_API void GL_APIENTRY glTexEnviv(GLenum target, GLenum pname, const GLint *par
             texture_unit->tex_env_color[3] = INT_TO_FLOAT(params[3]);
             break;
         case GL_COMBINE_RGB:
-            switch (params[0]) {
-                case GL_REPLACE:
-                case GL_MODULATE:
-                case GL_ADD:
-                case GL_ADD_SIGNED:
-                case GL_INTERPOLATE:
-                case GL_SUBTRACT:
-                case GL_DOT3_RGB:
-                case GL_DOT3_RGBA:
-                    break;
-                default:
-                    gliSetError(GL_INVALID_ENUM);
-                    return;
+            if (GLI_INVALID(params[0] != GL_REPLACE && params[0] != GL_MODULATE && params[0] != GL_ADD &&
+                            params[0] != GL_ADD_SIGNED && params[0] != GL_INTERPOLATE && params[0] != GL_SUBTRACT &&
+                            params[0] != GL_DOT3_RGB && params[0] != GL_DOT3_RGBA)) {
+                gliSetError(GL_INVALID_ENUM);
+                return;
             }
             texture_unit->combine_rgb_function = (GLenum)params[0];
             break;
         case GL_COMBINE_ALPHA:
-            switch (params[0]) {
-                case GL_REPLACE:
-                case GL_MODULATE:
-                case GL_ADD:
-                case GL_ADD_SIGNED:
-                case GL_INTERPOLATE:
-                case GL_SUBTRACT:
-                    break;
-                default:
-                    gliSetError(GL_INVALID_ENUM);
-                    return;
+            if (GLI_INVALID(params[0] != GL_REPLACE && params[0] != GL_MODULATE && params[0] != GL_ADD &&
+                            params[0] != GL_ADD_SIGNED && params[0] != GL_INTERPOLATE && params[0] != GL_SUBTRACT)) {
+                gliSetError(GL_INVALID_ENUM);
+                return;
             }
             texture_unit->combine_alpha_function = (GLenum)params[0];
             break;
@@ -396,15 +437,10 @@ GL_API void GL_APIENTRY glTexEnviv(GLenum target, GLenum pname, const GLint *par
         case GL_SRC1_RGB:
         case GL_SRC2_RGB: {
             const GLint index = pname - GL_SRC0_RGB;
-            switch (params[0]) {
-                case GL_TEXTURE:
-                case GL_CONSTANT:
-                case GL_PRIMARY_COLOR:
-                case GL_PREVIOUS:
-                    break;
-                default:
-                    gliSetError(GL_INVALID_ENUM);
-                    return;
+            if (GLI_INVALID(params[0] != GL_TEXTURE && params[0] != GL_CONSTANT && params[0] != GL_PRIMARY_COLOR &&
+                            params[0] != GL_PREVIOUS)) {
+                gliSetError(GL_INVALID_ENUM);
+                return;
             }
             texture_unit->combine_rgb_source[index] = (GLenum)params[0];
         } break;
@@ -413,15 +449,10 @@ GL_API void GL_APIENTRY glTexEnviv(GLenum target, GLenum pname, const GLint *par
         case GL_SRC1_ALPHA:
         case GL_SRC2_ALPHA: {
             const GLint index = pname - GL_SRC0_ALPHA;
-            switch (params[0]) {
-                case GL_TEXTURE:
-                case GL_CONSTANT:
-                case GL_PRIMARY_COLOR:
-                case GL_PREVIOUS:
-                    break;
-                default:
-                    gliSetError(GL_INVALID_ENUM);
-                    return;
+            if (GLI_INVALID(params[0] != GL_TEXTURE && params[0] != GL_CONSTANT && params[0] != GL_PRIMARY_COLOR &&
+                            params[0] != GL_PREVIOUS)) {
+                gliSetError(GL_INVALID_ENUM);
+                return;
             }
             texture_unit->combine_alpha_source[index] = (GLenum)params[0];
         } break;
@@ -430,15 +461,10 @@ GL_API void GL_APIENTRY glTexEnviv(GLenum target, GLenum pname, const GLint *par
         case GL_OPERAND1_RGB:
         case GL_OPERAND2_RGB: {
             const GLint index = pname - GL_OPERAND0_RGB;
-            switch (params[0]) {
-                case GL_SRC_COLOR:
-                case GL_ONE_MINUS_SRC_COLOR:
-                case GL_SRC_ALPHA:
-                case GL_ONE_MINUS_SRC_ALPHA:
-                    break;
-                default:
-                    gliSetError(GL_INVALID_ENUM);
-                    return;
+            if (GLI_INVALID(params[0] != GL_SRC_COLOR && params[0] != GL_ONE_MINUS_SRC_COLOR &&
+                            params[0] != GL_SRC_ALPHA && params[0] != GL_ONE_MINUS_SRC_ALPHA)) {
+                gliSetError(GL_INVALID_ENUM);
+                return;
             }
             texture_unit->combine_rgb_operand[index] = (GLenum)params[0];
         } break;
@@ -447,19 +473,15 @@ GL_API void GL_APIENTRY glTexEnviv(GLenum target, GLenum pname, const GLint *par
         case GL_OPERAND1_ALPHA:
         case GL_OPERAND2_ALPHA: {
             const GLint index = pname - GL_OPERAND0_ALPHA;
-            switch (params[0]) {
-                case GL_SRC_ALPHA:
-                case GL_ONE_MINUS_SRC_ALPHA:
-                    break;
-                default:
-                    gliSetError(GL_INVALID_ENUM);
-                    return;
+            if (GLI_INVALID(params[0] != GL_SRC_ALPHA && params[0] != GL_ONE_MINUS_SRC_ALPHA)) {
+                gliSetError(GL_INVALID_ENUM);
+                return;
             }
             texture_unit->combine_alpha_operand[index] = (GLenum)params[0];
         } break;
 
         case GL_RGB_SCALE:
-            if (params[0] != 1 && params[0] != 2 && params[0] != 4) {
+            if (GLI_INVALID(params[0] != 1 && params[0] != 2 && params[0] != 4)) {
                 gliSetError(GL_INVALID_VALUE);
                 return;
             }
@@ -467,7 +489,7 @@ GL_API void GL_APIENTRY glTexEnviv(GLenum target, GLenum pname, const GLint *par
             break;
 
         case GL_ALPHA_SCALE:
-            if (params[0] != 1 && params[0] != 2 && params[0] != 4) {
+            if (GLI_INVALID(params[0] != 1 && params[0] != 2 && params[0] != 4)) {
                 gliSetError(GL_INVALID_VALUE);
                 return;
             }
@@ -489,12 +511,12 @@ GL_API void GL_APIENTRY glTexEnvfv(GLenum target, GLenum pname, const GLfloat *p
 {
     gli_context_t *context = gliGetContext();
 
-    if (!params) {
+    if (GLI_INVALID(!params)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
 
-    if (target != GL_TEXTURE_ENV && target != GL_POINT_SPRITE_OES) {
+    if (GLI_INVALID(target != GL_TEXTURE_ENV && target != GL_POINT_SPRITE_OES)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -519,7 +541,7 @@ GL_API void GL_APIENTRY glTexEnvfv(GLenum target, GLenum pname, const GLfloat *p
 
 GL_API void GL_APIENTRY glTexEnvxv(GLenum target, GLenum pname, const GLfixed *params)
 {
-    if (!params) {
+    if (GLI_INVALID(!params)) {
         gliSetError(GL_INVALID_VALUE);
         return;
     }
@@ -543,7 +565,7 @@ GL_API void GL_APIENTRY glTexEnvi(GLenum target, GLenum pname, GLint param)
 
 GL_API void GL_APIENTRY glTexEnvf(GLenum target, GLenum pname, GLfloat param)
 {
-    if (pname == GL_TEXTURE_ENV_COLOR) {
+    if (GLI_INVALID(pname == GL_TEXTURE_ENV_COLOR)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -554,7 +576,7 @@ GL_API void GL_APIENTRY glTexEnvf(GLenum target, GLenum pname, GLfloat param)
 
 GL_API void GL_APIENTRY glTexEnvx(GLenum target, GLenum pname, GLfixed param)
 {
-    if (pname == GL_TEXTURE_ENV_COLOR) {
+    if (GLI_INVALID(pname == GL_TEXTURE_ENV_COLOR)) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -566,7 +588,8 @@ GL_API void GL_APIENTRY glTexEnvx(GLenum target, GLenum pname, GLfixed param)
 GL_API void GL_APIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLint *params)
 {
     gli_context_t *context = gliGetContext();
-    if (target != GL_TEXTURE_2D) { // GL_TEXTURE_CUBE_MAP_OES maybe?
+    texture_object_t *texture_object = target_texture_object(context, target);
+    if (texture_object == NULL) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -576,12 +599,6 @@ GL_API void GL_APIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLint *
         return;
     }
 
-    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
-    texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
-    texture_object_t *texture_object = texture_unit->bound_texture_object;
-
-    assert(texture_object != NULL);
-
     switch (pname) {
         case GL_TEXTURE_MIN_FILTER:
             params[0] = (GLint)texture_object->min_filter;
@@ -598,6 +615,14 @@ GL_API void GL_APIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLint *
         case GL_GENERATE_MIPMAP:
             params[0] = texture_object->generate_mipmap;
             break;
+#ifdef GL_OES_draw_texture
+        case GL_TEXTURE_CROP_RECT_OES:
+            params[0] = texture_object->crop_rect[0];
+            params[1] = texture_object->crop_rect[1];
+            params[2] = texture_object->crop_rect[2];
+            params[3] = texture_object->crop_rect[3];
+            break;
+#endif
         default:
             gliSetError(GL_INVALID_ENUM);
             return;
@@ -611,9 +636,16 @@ GL_API void GL_APIENTRY glGetTexParameterfv(GLenum target, GLenum pname, GLfloat
         return;
     }
 
-    GLint ival;
-    glGetTexParameteriv(target, pname, &ival);
-    params[0] = (GLfloat)ival;
+    GLint ival[4];
+    glGetTexParameteriv(target, pname, ival);
+    params[0] = (GLfloat)ival[0];
+#ifdef GL_OES_draw_texture
+    if (pname == GL_TEXTURE_CROP_RECT_OES) {
+        params[1] = (GLfloat)ival[1];
+        params[2] = (GLfloat)ival[2];
+        params[3] = (GLfloat)ival[3];
+    }
+#endif
 }
 
 GL_API void GL_APIENTRY glGetTexParameterxv(GLenum target, GLenum pname, GLfixed *params)
@@ -622,10 +654,17 @@ GL_API void GL_APIENTRY glGetTexParameterxv(GLenum target, GLenum pname, GLfixed
         gliSetError(GL_INVALID_VALUE);
         return;
     }
-    // GLES 1.1 has no parameters that require multiple elements. We just get the single value, convert and return.
-    GLfloat paramf;
-    glGetTexParameterfv(target, pname, &paramf);
-    *params = gliFloattoFixed(paramf);
+    // Only the OES_draw_texture crop rectangle has more than one element
+    GLfloat paramf[4];
+    glGetTexParameterfv(target, pname, paramf);
+    params[0] = gliFloattoFixed(paramf[0]);
+#ifdef GL_OES_draw_texture
+    if (pname == GL_TEXTURE_CROP_RECT_OES) {
+        params[1] = gliFloattoFixed(paramf[1]);
+        params[2] = gliFloattoFixed(paramf[2]);
+        params[3] = gliFloattoFixed(paramf[3]);
+    }
+#endif
 }
 
 GL_API void GL_APIENTRY glGetTexEnviv(GLenum target, GLenum pname, GLint *params)
@@ -746,6 +785,81 @@ GL_API void GL_APIENTRY glGetTexEnvxv(GLenum target, GLenum pname, GLfixed *para
     *params = gliFloattoFixed(paramf);
 }
 
+#ifdef GL_OES_texture_cube_map
+// The only texture generation state in ES is a single mode shared by the s, t and r coordinates of the active unit
+GL_API void GL_APIENTRY glTexGenivOES(GLenum coord, GLenum pname, const GLint *params)
+{
+    gli_context_t *context = gliGetContext();
+    if (coord != GL_TEXTURE_GEN_STR_OES || pname != GL_TEXTURE_GEN_MODE_OES) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (!params) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    if (params[0] != GL_NORMAL_MAP_OES && params[0] != GL_REFLECTION_MAP_OES) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
+    texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
+    texture_unit->texgen_mode = (GLenum)params[0];
+    texture_unit->texture_unit_dirty = GL_TRUE;
+}
+
+GL_API void GL_APIENTRY glTexGeniOES(GLenum coord, GLenum pname, GLint param)
+{
+    glTexGenivOES(coord, pname, &param);
+}
+
+GL_API void GL_APIENTRY glTexGenfvOES(GLenum coord, GLenum pname, const GLfloat *params)
+{
+    if (!params) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    glTexGeniOES(coord, pname, (GLint)params[0]);
+}
+
+GL_API void GL_APIENTRY glTexGenfOES(GLenum coord, GLenum pname, GLfloat param)
+{
+    glTexGeniOES(coord, pname, (GLint)param);
+}
+
+GL_API void GL_APIENTRY glGetTexGenivOES(GLenum coord, GLenum pname, GLint *params)
+{
+    gli_context_t *context = gliGetContext();
+    if (coord != GL_TEXTURE_GEN_STR_OES || pname != GL_TEXTURE_GEN_MODE_OES) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (!params) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
+    params[0] = (GLint)context->texture_environment.texture_units[texture_index].texgen_mode;
+}
+
+GL_API void GL_APIENTRY glGetTexGenfvOES(GLenum coord, GLenum pname, GLfloat *params)
+{
+    if (!params) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLint param = 0;
+    glGetTexGenivOES(coord, pname, &param);
+    params[0] = (GLfloat)param;
+}
+#endif
+
 static inline void convert_to_bgra(const uint8_t *restrict src, uint8_t *restrict dst, size_t pixel_count, int src_bpp)
 {
     for (size_t i = 0; i < pixel_count; ++i) {
@@ -759,6 +873,284 @@ static inline void convert_to_bgra(const uint8_t *restrict src, uint8_t *restric
     }
 }
 
+// 4x4 ordered dither thresholds, 0-15
+static const uint8_t dither_4x4[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+
+static inline __m64 pack_r5g6b5(__m64 p)
+{
+    __m64 r = _mm_and_si64(_mm_srli_pi32(p, 8), _mm_set1_pi32(0xF800));
+    __m64 g = _mm_and_si64(_mm_srli_pi32(p, 5), _mm_set1_pi32(0x07E0));
+    __m64 b = _mm_and_si64(_mm_srli_pi32(p, 3), _mm_set1_pi32(0x001F));
+    // Sign extend so the signed saturating pack keeps all 16 bits
+    return _mm_srai_pi32(_mm_slli_pi32(_mm_or_si64(_mm_or_si64(r, g), b), 16), 16);
+}
+
+static inline __m64 pack_a1r5g5b5(__m64 p)
+{
+    __m64 a = _mm_and_si64(_mm_srli_pi32(p, 16), _mm_set1_pi32(0x8000));
+    __m64 r = _mm_and_si64(_mm_srli_pi32(p, 9), _mm_set1_pi32(0x7C00));
+    __m64 g = _mm_and_si64(_mm_srli_pi32(p, 6), _mm_set1_pi32(0x03E0));
+    __m64 b = _mm_and_si64(_mm_srli_pi32(p, 3), _mm_set1_pi32(0x001F));
+    return _mm_srai_pi32(_mm_slli_pi32(_mm_or_si64(_mm_or_si64(a, r), _mm_or_si64(g, b)), 16), 16);
+}
+
+// Pack BGRA8888 texels to R5G6B5 or A1R5G5B5 in place, four texels per iteration. The source rows must be tightly
+// packed. When dithering, an ordered offset below one output step is added to each channel with unsigned saturation
+// before it is truncated.
+static void pack_bgra_to_16bpp(GLubyte *pixels, GLuint width, GLuint height, XguTexFormatColor format, GLboolean dither)
+{
+    const GLboolean rgb565 = (format == XGU_TEXTURE_FORMAT_R5G6B5_SWIZZLED || format == XGU_TEXTURE_FORMAT_R5G6B5);
+    const uint32_t *src = (const uint32_t *)pixels;
+    uint16_t *dst = (uint16_t *)pixels;
+
+    for (GLuint y = 0; y < height; y++) {
+        uint32_t dither_px[4] = {0, 0, 0, 0};
+        if (dither) {
+            for (GLuint i = 0; i < 4; i++) {
+                const uint32_t d5 = dither_4x4[y & 3][i] >> 1;
+                const uint32_t d6 = (rgb565) ? (dither_4x4[y & 3][i] >> 2) : d5;
+                dither_px[i] = (d5 << 16) | (d6 << 8) | d5;
+            }
+        }
+        const __m64 d01 = _mm_set_pi32(dither_px[1], dither_px[0]);
+        const __m64 d23 = _mm_set_pi32(dither_px[3], dither_px[2]);
+
+        // dst never overtakes src, so converting in place is safe
+        GLuint x = 0;
+        for (; x + 4 <= width; x += 4) {
+            __m64 p01 = _mm_adds_pu8(*(const __m64 *)&src[x], d01);
+            __m64 p23 = _mm_adds_pu8(*(const __m64 *)&src[x + 2], d23);
+            if (rgb565) {
+                p01 = pack_r5g6b5(p01);
+                p23 = pack_r5g6b5(p23);
+            } else {
+                p01 = pack_a1r5g5b5(p01);
+                p23 = pack_a1r5g5b5(p23);
+            }
+            *(__m64 *)&dst[x] = _mm_packs_pi32(p01, p23);
+        }
+
+        for (; x < width; x++) {
+            const uint32_t p = src[x];
+            const uint32_t d = dither_px[x & 3];
+            const uint32_t b = GLI_MIN(0xFF, (p & 0xFF) + (d & 0xFF));
+            const uint32_t g = GLI_MIN(0xFF, ((p >> 8) & 0xFF) + ((d >> 8) & 0xFF));
+            const uint32_t r = GLI_MIN(0xFF, ((p >> 16) & 0xFF) + ((d >> 16) & 0xFF));
+            if (rgb565) {
+                dst[x] = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+            } else {
+                dst[x] = (uint16_t)(((p >> 31) << 15) | ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3));
+            }
+        }
+
+        src += width;
+        dst += width;
+    }
+    _mm_empty();
+}
+
+// RGBA textures can only be stored as A1R5G5B5 if every alpha value is fully opaque or fully transparent
+static GLboolean alpha_is_binary(const GLubyte *pixels, GLsizei width, GLsizei height, size_t pitch)
+{
+    for (GLsizei y = 0; y < height; y++) {
+        const GLubyte *row = pixels + y * pitch;
+        for (GLsizei x = 0; x < width; x++) {
+            const GLubyte a = row[x * 4 + 3];
+            if (a != 0x00 && a != 0xFF) {
+                return GL_FALSE;
+            }
+        }
+    }
+    return GL_TRUE;
+}
+
+// Move an A1R5G5B5 texture to A8R8G8B8 storage, for an upload whose alpha would not survive being cut to 1 bit. The
+// texels already stored widen exactly, and swizzling and the mipmap layout only depend on the texel index, so the
+// storage is converted texel for texel
+static GLboolean widen_a1r5g5b5(xgu_texture_t *xgu_texture)
+{
+    const GLuint old_pitch = xgu_texture->pitch;
+    const GLuint new_pitch = (xgu_texture->swizzled) ? xgu_texture->data_width * 4
+                                                     : ((xgu_texture->data_width * 4 + 63) & ~63);
+    const GLuint rows = (xgu_texture->swizzled) ? 1 : xgu_texture->data_height;
+    const GLuint row_texels = (xgu_texture->swizzled) ? xgu_texture->data_size / 2 : xgu_texture->data_width;
+    const GLuint new_size = (xgu_texture->swizzled) ? xgu_texture->data_size * 2 : new_pitch * rows;
+
+    GLubyte *new_data = gliTextureAlloc(new_size);
+    if (new_data == NULL) {
+        return GL_FALSE;
+    }
+
+    for (GLuint y = 0; y < rows; y++) {
+        const uint16_t *src = (const uint16_t *)(xgu_texture->data + y * old_pitch);
+        uint32_t *dst = (uint32_t *)(new_data + y * new_pitch);
+        for (GLuint x = 0; x < row_texels; x++) {
+            const uint32_t p = src[x];
+            const uint32_t r = (p >> 10) & 0x1F, g = (p >> 5) & 0x1F, b = p & 0x1F;
+            dst[x] = ((p & 0x8000) ? 0xFF000000u : 0) | (((r << 3) | (r >> 2)) << 16) | (((g << 3) | (g >> 2)) << 8) |
+                     ((b << 3) | (b >> 2));
+        }
+    }
+
+    gliTextureFree(xgu_texture->data, xgu_texture->data_size);
+    xgu_texture->data = new_data;
+    xgu_texture->data_size = new_size;
+    xgu_texture->data_physical_address = (GLubyte *)MmGetPhysicalAddress(xgu_texture->data);
+    xgu_texture->format = (xgu_texture->swizzled) ? XGU_TEXTURE_FORMAT_A8R8G8B8_SWIZZLED : XGU_TEXTURE_FORMAT_A8R8G8B8;
+    xgu_texture->bytes_per_pixel = 4;
+    xgu_texture->pitch = new_pitch;
+    return GL_TRUE;
+}
+
+// An A1R5G5B5 texture only stays that way while every GL_RGBA upload into it has binary alpha. Call before converting
+// an upload. Returns GL_FALSE if the texture needed widening and there was no memory for it
+static GLboolean keep_alpha_precision(xgu_texture_t *xgu_texture, const void *pixels, GLsizei width, GLsizei height,
+                                      GLenum format, GLenum type, GLint alignment)
+{
+    const GLboolean a1r5g5b5 = xgu_texture->format == XGU_TEXTURE_FORMAT_A1R5G5B5_SWIZZLED ||
+                               xgu_texture->format == XGU_TEXTURE_FORMAT_A1R5G5B5;
+    if (!a1r5g5b5 || pixels == NULL || format != GL_RGBA || type != GL_UNSIGNED_BYTE) {
+        return GL_TRUE;
+    }
+
+    const size_t rgba_pitch = (((size_t)width * 4) + (alignment - 1)) & ~(size_t)(alignment - 1);
+    if (alpha_is_binary(pixels, width, height, rgba_pitch)) {
+        return GL_TRUE;
+    }
+    return widen_a1r5g5b5(xgu_texture);
+}
+
+// Bytes written to texture storage, for the GL_NV2A_frame_counters upload counters
+static void count_texture_upload(GLuint bytes)
+{
+    gliCount(GLI_COUNTER_TEXTURE_UPLOADS, 1);
+    gliCount(GLI_COUNTER_TEXTURE_UPLOAD_BYTES, bytes);
+}
+
+// Convert 8-bit RGB/RGBA client data into the texture's storage format. The returned copy is tightly packed
+static GLubyte *convert_rgba8_upload(const GLubyte *pixels, GLsizei width, GLsizei height, GLenum format,
+                                     const xgu_texture_t *xgu_texture)
+{
+    GLubyte *converted_pixels = GLI_MALLOC((size_t)width * height * 4);
+    if (converted_pixels == NULL) {
+        return NULL;
+    }
+
+    convert_to_bgra(pixels, converted_pixels, width * height, (format == GL_RGBA) ? 4 : 3);
+
+    // Compact storage selected by GL_TEXTURE_COMPRESSION_HINT
+    if (xgu_texture->bytes_per_pixel == 2) {
+        pack_bgra_to_16bpp(converted_pixels, width, height, xgu_texture->format, GLI_COMPACT_TEXTURE_DITHER);
+    }
+    return converted_pixels;
+}
+
+#ifdef GL_OES_texture_cube_map
+// OES_texture_cube_map. All six faces share one allocation, laid out from +X to -Z and padded to the 128 byte boundary
+// NV2A expects between faces. Faces are always square, power of two and swizzled, and only the base level is stored.
+// A face with a different size or format to the existing storage starts the cube map over
+static void tex_image_cube_face(gli_context_t *context,
+                                GLuint face,
+                                GLint level,
+                                GLint internalformat,
+                                GLsizei width,
+                                GLsizei height,
+                                GLenum format,
+                                GLenum type,
+                                const void *pixels)
+{
+    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
+    texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
+    texture_object_t *texture_object = texture_unit->bound_cube_map_object;
+
+    if (width != height || width == 0 || width != (GLsizei)npot2pot(width) ||
+        width > context->implementation_limits.max_cube_map_texture_size) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    if (level > 0) {
+        gliSetError(GL_INVALID_OPERATION); // Cube map mipmaps are not supported
+        return;
+    }
+
+    GLuint bytes_per_pixel = 0;
+    XguTexFormatColor xgu_format = gliEnumToNvTexFormat(format, type, &bytes_per_pixel, 1);
+    assert(xgu_format != -1);
+    assert(bytes_per_pixel != 0);
+
+    const GLuint face_size = ((GLuint)width * (GLuint)height * bytes_per_pixel + 127) & ~127;
+
+    xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
+    if (xgu_texture == NULL || xgu_texture->tex_width != width || xgu_texture->format != xgu_format) {
+        xgu_texture = GLI_MALLOC(sizeof(xgu_texture_t));
+        if (xgu_texture == NULL) {
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+        gli_memset(xgu_texture, 0, sizeof(xgu_texture_t));
+
+        xgu_texture->swizzled = 1;
+        xgu_texture->cube_map = 1;
+        xgu_texture->face_size = face_size;
+        xgu_texture->data_width = width;
+        xgu_texture->data_height = height;
+        xgu_texture->tex_width = width;
+        xgu_texture->tex_height = height;
+        xgu_texture->bytes_per_pixel = bytes_per_pixel;
+        xgu_texture->pitch = width * bytes_per_pixel;
+        xgu_texture->u_scale = 1.0f;
+        xgu_texture->v_scale = 1.0f;
+        xgu_texture->format = xgu_format;
+        xgu_texture->mipmap_levels = 1;
+        xgu_texture->data_size = face_size * 6;
+        xgu_texture->data = gliTextureAlloc(xgu_texture->data_size);
+        if (xgu_texture->data == NULL) {
+            GLI_FREE(xgu_texture);
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+        xgu_texture->data_physical_address = (GLubyte *)MmGetPhysicalAddress(xgu_texture->data);
+        gli_memset(xgu_texture->data, 0, xgu_texture->data_size);
+
+        if (texture_object->texture_2d != NULL) {
+            xgu_texture_t *old_tex = (xgu_texture_t *)texture_object->texture_2d;
+            gliTextureRelease(old_tex);
+            GLI_FREE(old_tex);
+        }
+        texture_object->texture_2d = xgu_texture;
+    } else if (!gliTextureMakeResident(texture_object)) {
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
+    texture_object->internalformat = internalformat;
+
+    if (pixels != NULL) {
+        const GLint alignment = context->pixel_store.unpack_alignment;
+        size_t src_pitch = (((size_t)width * (size_t)bytes_per_pixel) + (alignment - 1)) & ~(size_t)(alignment - 1);
+
+        const GLubyte *src_pixels = (GLubyte *)pixels;
+        if (type == GL_UNSIGNED_BYTE && (format == GL_RGB || format == GL_RGBA)) {
+            src_pixels = convert_rgba8_upload(src_pixels, width, height, format, xgu_texture);
+            if (src_pixels == NULL) {
+                gliSetError(GL_OUT_OF_MEMORY);
+                return;
+            }
+            src_pitch = (size_t)width * bytes_per_pixel;
+        }
+
+        swizzle_rect(src_pixels, width, height, xgu_texture->data + face * face_size, src_pitch, bytes_per_pixel);
+        count_texture_upload(width * height * bytes_per_pixel);
+
+        if (src_pixels != (GLubyte *)pixels) {
+            GLI_FREE((void *)src_pixels);
+        }
+    }
+
+    texture_object->texture_object_dirty = GL_TRUE;
+}
+#endif
+
 GL_API void GL_APIENTRY glTexImage2D(GLenum target,
                                      GLint level,
                                      GLint internalformat,
@@ -771,7 +1163,13 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
 {
     gli_context_t *context = gliGetContext();
 
-    if (target != GL_TEXTURE_2D) {
+#ifdef GL_OES_texture_cube_map
+    const GLboolean cube_face =
+        (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X_OES && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z_OES);
+#else
+    const GLboolean cube_face = GL_FALSE;
+#endif
+    if (target != GL_TEXTURE_2D && !cube_face) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -813,6 +1211,21 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
         return;
     }
 
+#ifdef GL_OES_texture_cube_map
+    if (cube_face) {
+        tex_image_cube_face(context,
+                            target - GL_TEXTURE_CUBE_MAP_POSITIVE_X_OES,
+                            level,
+                            internalformat,
+                            width,
+                            height,
+                            format,
+                            type,
+                            pixels);
+        return;
+    }
+#endif
+
     // Get the currently bound texture object
     GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
     texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
@@ -825,8 +1238,13 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
         }
 
         xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
-        if (!xgu_texture->swizzled) {
-            gliSetError(GL_INVALID_OPERATION); // Mipmaps require POT swizzled textures
+        if (!xgu_texture->swizzled || xgu_texture->compressed) {
+            gliSetError(GL_INVALID_OPERATION); // Mipmaps require POT swizzled textures of the same format
+            return;
+        }
+
+        if (!gliTextureMakeResident(texture_object)) {
+            gliSetError(GL_OUT_OF_MEMORY);
             return;
         }
 
@@ -847,6 +1265,12 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
             return;
         }
 
+        if (!keep_alpha_precision(
+                xgu_texture, pixels, width, height, format, type, context->pixel_store.unpack_alignment)) {
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+
         // Calculate offset to the mipmap level
         GLuint required_size;
         uint8_t required_levels;
@@ -863,8 +1287,7 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
 
         // Check if we need to reallocate the texture to fit mipmaps
         if (xgu_texture->data_size < required_size) {
-            GLubyte *new_data =
-                MmAllocateContiguousMemoryEx(required_size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE | PAGE_WRITECOMBINE);
+            GLubyte *new_data = gliTextureAlloc(required_size);
             if (!new_data) {
                 gliSetError(GL_OUT_OF_MEMORY);
                 return;
@@ -873,7 +1296,7 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
             GLuint base_size = xgu_texture->data_width * xgu_texture->data_height * xgu_texture->bytes_per_pixel;
             gli_memcpy(new_data, xgu_texture->data, base_size);
 
-            MmFreeContiguousMemory(xgu_texture->data);
+            gliTextureFree(xgu_texture->data, xgu_texture->data_size);
             xgu_texture->data = new_data;
             xgu_texture->data_size = required_size;
             xgu_texture->data_physical_address = (GLubyte *)MmGetPhysicalAddress(xgu_texture->data);
@@ -896,18 +1319,22 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
 
         if (pixels != NULL) {
             const GLint alignment = context->pixel_store.unpack_alignment;
-            const size_t src_pitch =
+            size_t src_pitch =
                 (((size_t)width * (size_t)xgu_texture->bytes_per_pixel) + (alignment - 1)) & ~(size_t)(alignment - 1);
 
             const GLubyte *src_pixels = (GLubyte *)pixels;
             if (type == GL_UNSIGNED_BYTE && (format == GL_RGB || format == GL_RGBA)) {
-                GLubyte *converted_pixels = GLI_MALLOC(src_pitch * height);
-                convert_to_bgra(src_pixels, converted_pixels, width * height, (format == GL_RGBA) ? 4 : 3);
-                src_pixels = converted_pixels;
+                src_pixels = convert_rgba8_upload(src_pixels, width, height, format, xgu_texture);
+                if (src_pixels == NULL) {
+                    gliSetError(GL_OUT_OF_MEMORY);
+                    return;
+                }
+                src_pitch = (size_t)width * xgu_texture->bytes_per_pixel;
             }
 
             swizzle_rect(
                 src_pixels, width, height, xgu_texture->data + level_offset, src_pitch, xgu_texture->bytes_per_pixel);
+            count_texture_upload(width * height * xgu_texture->bytes_per_pixel);
 
             if (src_pixels != (GLubyte *)pixels) {
                 GLI_FREE((void *)src_pixels);
@@ -938,6 +1365,20 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
     assert(xgu_format != -1);
     assert(bytes_per_pixel != 0);
 
+    // GL_FASTEST trades precision for half the memory and sampling bandwidth. RGBA is only packed when the alpha
+    // channel survives the trip to 1 bit unchanged
+    if (type == GL_UNSIGNED_BYTE && context->hints_state.texture_compression_hint == GL_FASTEST) {
+        const GLint alignment = context->pixel_store.unpack_alignment;
+        const size_t rgba_pitch = (((size_t)width * 4) + (alignment - 1)) & ~(size_t)(alignment - 1);
+        if (format == GL_RGB) {
+            xgu_format = (xgu_texture->swizzled) ? XGU_TEXTURE_FORMAT_R5G6B5_SWIZZLED : XGU_TEXTURE_FORMAT_R5G6B5;
+            bytes_per_pixel = 2;
+        } else if (format == GL_RGBA && pixels != NULL && alpha_is_binary(pixels, width, height, rgba_pitch)) {
+            xgu_format = (xgu_texture->swizzled) ? XGU_TEXTURE_FORMAT_A1R5G5B5_SWIZZLED : XGU_TEXTURE_FORMAT_A1R5G5B5;
+            bytes_per_pixel = 2;
+        }
+    }
+
     // Swizzled textures must be a power of 2 and texture coordinates normalized to [0, 1]
     if (xgu_texture->swizzled) {
         xgu_texture->data_width = npot2pot(width);
@@ -982,8 +1423,7 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
 
     xgu_texture->format = xgu_format;
     xgu_texture->data_size = alloc_size;
-    xgu_texture->data =
-        MmAllocateContiguousMemoryEx(alloc_size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE | PAGE_WRITECOMBINE);
+    xgu_texture->data = gliTextureAlloc(alloc_size);
     if (xgu_texture->data == NULL) {
         GLI_FREE(xgu_texture);
         gliSetError(GL_OUT_OF_MEMORY);
@@ -994,16 +1434,20 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
 
     if (pixels != NULL) {
         const GLint alignment = context->pixel_store.unpack_alignment;
-        const size_t src_pitch =
-            (((size_t)width * (size_t)bytes_per_pixel) + (alignment - 1)) & ~(size_t)(alignment - 1);
+        size_t src_pitch = (((size_t)width * (size_t)bytes_per_pixel) + (alignment - 1)) & ~(size_t)(alignment - 1);
 
         const GLubyte *src_pixels = (GLubyte *)pixels;
         GLubyte *dst_pixels = xgu_texture->data;
 
         if (type == GL_UNSIGNED_BYTE && (format == GL_RGB || format == GL_RGBA)) {
-            GLubyte *converted_pixels = GLI_MALLOC(src_pitch * height);
-            convert_to_bgra(src_pixels, converted_pixels, width * height, (format == GL_RGBA) ? 4 : 3);
-            src_pixels = converted_pixels;
+            src_pixels = convert_rgba8_upload(src_pixels, width, height, format, xgu_texture);
+            if (src_pixels == NULL) {
+                gliTextureFree(xgu_texture->data, xgu_texture->data_size);
+                GLI_FREE(xgu_texture);
+                gliSetError(GL_OUT_OF_MEMORY);
+                return;
+            }
+            src_pitch = (size_t)width * bytes_per_pixel;
         }
 
         if (xgu_texture->swizzled) {
@@ -1018,6 +1462,7 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
                 gli_memcpy(dst_pixels + y * xgu_texture->pitch, src_pixels + y * src_pitch, width * bytes_per_pixel);
             }
         }
+        count_texture_upload(width * height * bytes_per_pixel);
 
         if (src_pixels != (GLubyte *)pixels) {
             GLI_FREE((void *)src_pixels);
@@ -1028,9 +1473,7 @@ GL_API void GL_APIENTRY glTexImage2D(GLenum target,
 
     if (texture_object->texture_2d != NULL) {
         xgu_texture_t *old_tex = (xgu_texture_t *)texture_object->texture_2d;
-        if (old_tex->data) {
-            MmFreeContiguousMemory(old_tex->data);
-        }
+        gliTextureRelease(old_tex);
         GLI_FREE(old_tex);
     }
 
@@ -1066,6 +1509,41 @@ GL_API void GL_APIENTRY glTexSubImage2D(GLenum target,
     (void)pixels;
 }
 
+// ETC1 is transcoded to DXT1 on the way in, block for block. Everything else NV2A can sample as-is
+static void upload_compressed_blocks(GLubyte *dst, const void *src, GLuint size, GLenum internalformat)
+{
+    if (internalformat == GL_ETC1_RGB8_OES) {
+        gliTranscodeETC1ToDXT1((const GLubyte *)src, dst, size / 8);
+    } else {
+        gli_memcpy(dst, src, size);
+    }
+}
+
+// Byte offset of a mipmap level within a compressed texture. Levels are stored back to back
+static GLuint compressed_level_offset(const xgu_texture_t *xgu_texture, GLint level, GLuint *level_w, GLuint *level_h)
+{
+    GLuint offset = 0;
+    GLuint w = xgu_texture->data_width;
+    GLuint h = xgu_texture->data_height;
+    for (GLint i = 0; i < level; i++) {
+        offset += gliCompressedLevelSize(w, h, xgu_texture->block_size);
+        if (w > 1) {
+            w /= 2;
+        }
+        if (h > 1) {
+            h /= 2;
+        }
+    }
+
+    if (level_w) {
+        *level_w = w;
+    }
+    if (level_h) {
+        *level_h = h;
+    }
+    return offset;
+}
+
 GL_API void GL_APIENTRY glCompressedTexImage2D(GLenum target,
                                                GLint level,
                                                GLenum internalformat,
@@ -1075,15 +1553,146 @@ GL_API void GL_APIENTRY glCompressedTexImage2D(GLenum target,
                                                GLsizei imageSize,
                                                const void *data)
 {
-    assert(0 && "glCompressedTexImage2D not implemented yet");
-    (void)target;
-    (void)level;
-    (void)internalformat;
-    (void)width;
-    (void)height;
-    (void)border;
-    (void)imageSize;
-    (void)data;
+    gli_context_t *context = gliGetContext();
+
+    if (target != GL_TEXTURE_2D) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    // Paletted textures are expanded to their palette's format straight into the texture's storage
+    if (internalformat >= GL_PALETTE4_RGB8_OES && internalformat <= GL_PALETTE8_RGB5_A1_OES) {
+        if (width < 0 || height < 0 || border != 0) {
+            gliSetError(GL_INVALID_VALUE);
+            return;
+        }
+        gliCompressedPalettedTexImage2D(level, internalformat, width, height, imageSize, data);
+        return;
+    }
+
+    GLuint block_size = 0;
+    XguTexFormatColor xgu_format = gliEnumToNvCompressedTexFormat(internalformat, &block_size);
+    if (xgu_format == (XguTexFormatColor)-1) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (level < 0 || width < 0 || height < 0 || border != 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    if (width > GLI_MAX_TEXTURE_SIZE || height > GLI_MAX_TEXTURE_SIZE) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    // Compressed textures are addressed by their log2 size like swizzled textures, so they must be power-of-two
+    if (width == 0 || height == 0 || width != npot2pot(width) || height != npot2pot(height)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    if (imageSize < 0 || (GLuint)imageSize != gliCompressedLevelSize(width, height, block_size)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
+    texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
+    texture_object_t *texture_object = texture_unit->bound_texture_object;
+
+    if (level > 0) {
+        xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
+        if (texture_object->texture_name == 0 || xgu_texture == NULL) {
+            gliSetError(GL_INVALID_OPERATION); // Can't define mipmap without base level on this hardware
+            return;
+        }
+
+        // All levels share the base level's storage, so they must also share its format
+        if (!xgu_texture->compressed || texture_object->internalformat != internalformat) {
+            gliSetError(GL_INVALID_OPERATION);
+            return;
+        }
+
+        if (!gliTextureMakeResident(texture_object)) {
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+
+        GLuint expected_w, expected_h;
+        GLuint level_offset = compressed_level_offset(xgu_texture, level, &expected_w, &expected_h);
+
+        uint8_t max_levels;
+        gliCalcCompressedMipmapChain(xgu_texture->data_width, xgu_texture->data_height, block_size, NULL, &max_levels);
+        if (level >= max_levels || (GLuint)width != expected_w || (GLuint)height != expected_h) {
+            gliSetError(GL_INVALID_VALUE);
+            return;
+        }
+
+        if (data != NULL) {
+            upload_compressed_blocks(xgu_texture->data + level_offset, data, imageSize, internalformat);
+            count_texture_upload(imageSize);
+        }
+
+        xgu_texture->mipmap_levels = GLI_MAX(xgu_texture->mipmap_levels, level + 1);
+        texture_object->texture_object_dirty = GL_TRUE;
+        return;
+    }
+
+    // level == 0
+    xgu_texture_t *xgu_texture = GLI_MALLOC(sizeof(xgu_texture_t));
+    if (xgu_texture == NULL) {
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
+    gli_memset(xgu_texture, 0, sizeof(xgu_texture_t));
+
+    // DXT data is stored as linear rows of 4x4 blocks, but the hardware addresses it with the log2 size fields
+    // just like a swizzled texture. So it behaves as swizzled everywhere else (wrap modes, mipmaps)
+    xgu_texture->swizzled = 1;
+    xgu_texture->compressed = 1;
+    xgu_texture->block_size = block_size;
+    xgu_texture->data_width = width;
+    xgu_texture->data_height = height;
+    xgu_texture->tex_width = width;
+    xgu_texture->tex_height = height;
+    xgu_texture->u_scale = 1.0f;
+    xgu_texture->v_scale = 1.0f;
+    xgu_texture->pitch = GLI_MAX(1, (width + 3) / 4) * block_size;
+    xgu_texture->format = xgu_format;
+    xgu_texture->mipmap_levels = 1;
+
+    // Compressed assets normally ship with their full mip chain, so reserve space for it up front to avoid
+    // reallocating and copying on every level upload
+    GLuint alloc_size;
+    gliCalcCompressedMipmapChain(width, height, block_size, &alloc_size, NULL);
+
+    xgu_texture->data_size = alloc_size;
+    xgu_texture->data = gliTextureAlloc(alloc_size);
+    if (xgu_texture->data == NULL) {
+        GLI_FREE(xgu_texture);
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
+    xgu_texture->data_physical_address = (GLubyte *)MmGetPhysicalAddress(xgu_texture->data);
+
+    if (data != NULL) {
+        upload_compressed_blocks(xgu_texture->data, data, imageSize, internalformat);
+        count_texture_upload(imageSize);
+    } else {
+        gli_memset(xgu_texture->data, 0, imageSize);
+    }
+
+    if (texture_object->texture_2d != NULL) {
+        xgu_texture_t *old_tex = (xgu_texture_t *)texture_object->texture_2d;
+        gliTextureRelease(old_tex);
+        GLI_FREE(old_tex);
+    }
+
+    texture_object->texture_2d = xgu_texture;
+    texture_object->internalformat = internalformat;
+    texture_object->texture_object_dirty = GL_TRUE;
 }
 
 GL_API void GL_APIENTRY glCompressedTexSubImage2D(GLenum target,
@@ -1096,16 +1705,86 @@ GL_API void GL_APIENTRY glCompressedTexSubImage2D(GLenum target,
                                                   GLsizei imageSize,
                                                   const void *data)
 {
-    assert(0 && "glCompressedTexSubImage2D not implemented yet");
-    (void)target;
-    (void)level;
-    (void)xoff;
-    (void)yoff;
-    (void)w;
-    (void)h;
-    (void)format;
-    (void)imageSize;
-    (void)data;
+    gli_context_t *context = gliGetContext();
+
+    if (target != GL_TEXTURE_2D) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    // Paletted textures can't be partially updated
+    if (format >= GL_PALETTE4_RGB8_OES && format <= GL_PALETTE8_RGB5_A1_OES) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    GLuint block_size = 0;
+    if (gliEnumToNvCompressedTexFormat(format, &block_size) == (XguTexFormatColor)-1) {
+        gliSetError(GL_INVALID_ENUM);
+        return;
+    }
+
+    if (level < 0 || xoff < 0 || yoff < 0 || w < 0 || h < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLuint texture_index = context->texture_environment.server_active_texture - GL_TEXTURE0;
+    texture_unit_t *texture_unit = &context->texture_environment.texture_units[texture_index];
+    texture_object_t *texture_object = texture_unit->bound_texture_object;
+    xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
+
+    if (xgu_texture == NULL || !xgu_texture->compressed || texture_object->internalformat != format) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    if (level >= xgu_texture->mipmap_levels) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    GLuint level_w, level_h;
+    GLuint level_offset = compressed_level_offset(xgu_texture, level, &level_w, &level_h);
+
+    if ((GLuint)(xoff + w) > level_w || (GLuint)(yoff + h) > level_h) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    // Updates must be block aligned. A partial block is only allowed where it reaches the edge of the level
+    if ((xoff & 3) || (yoff & 3) || ((w & 3) && (GLuint)(xoff + w) != level_w) ||
+        ((h & 3) && (GLuint)(yoff + h) != level_h)) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    if (imageSize < 0 || (GLuint)imageSize != gliCompressedLevelSize(w, h, block_size)) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    if (data == NULL || w == 0 || h == 0) {
+        return;
+    }
+
+    if (!gliTextureMakeResident(texture_object)) {
+        gliSetError(GL_OUT_OF_MEMORY);
+        return;
+    }
+
+    const GLuint level_pitch = GLI_MAX(1, (level_w + 3) / 4) * block_size;
+    const GLuint src_pitch = GLI_MAX(1, (w + 3) / 4) * block_size;
+    const GLuint block_rows = GLI_MAX(1, (h + 3) / 4);
+    GLubyte *dst = xgu_texture->data + level_offset + (yoff / 4) * level_pitch + (xoff / 4) * block_size;
+    const GLubyte *src = (const GLubyte *)data;
+
+    for (GLuint y = 0; y < block_rows; y++) {
+        upload_compressed_blocks(dst + y * level_pitch, src + y * src_pitch, src_pitch, format);
+    }
+    count_texture_upload(imageSize);
+
+    texture_object->texture_object_dirty = GL_TRUE;
 }
 
 GL_API void GL_APIENTRY glCopyTexImage2D(
@@ -1142,16 +1821,30 @@ void gliTextureFlush(void)
 
     for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
         texture_unit_t *texture_unit = &context->texture_environment.texture_units[i];
-        texture_object_t *texture_object = texture_unit->bound_texture_object;
+        texture_object_t *texture_object = gliSampledTextureObject(texture_unit);
+        const GLboolean enabled = (texture_object != NULL);
+        if (!enabled) {
+            texture_object = texture_unit->bound_texture_object;
+        }
         xgu_texture_t *xgu_texture = (xgu_texture_t *)texture_object->texture_2d;
 
+        // Mark the texture as used this frame, and bring it back into contiguous memory if it was evicted.
+        // That dirties the texture object so the new address is picked up below
+        GLboolean resident = GL_TRUE;
+        if (enabled && xgu_texture) {
+            resident = gliTextureMakeResident(texture_object);
+            if (!resident) {
+                gliSetError(GL_OUT_OF_MEMORY);
+            }
+        }
+
         if (!texture_object->texture_object_dirty && !texture_unit->texture_unit_dirty) {
             continue;
         }
 
         // If the texture unit is disabled or there is no texture bound, skip
-        if (!texture_unit->texture_2d_enabled || !xgu_texture ||
-            texture_object == &texture_unit->unbound_texture_object) {
+        if (!enabled || !xgu_texture || !resident || texture_object == &texture_unit->unbound_texture_object ||
+            texture_object == &texture_unit->unbound_cube_map_object) {
             uint32_t *pb = pb_begin();
             pb = xgu_set_texture_control0(pb, i, false, 0, 0);
             pb = xgu_set_texture_matrix_enable(pb, i, false);
@@ -1179,7 +1872,7 @@ void gliTextureFlush(void)
         pb = xgu_set_texture_format(pb,
                                     i,
                                     2,
-                                    false,
+                                    xgu_texture->cube_map,
                                     XGU_SOURCE_COLOR,
                                     2,
                                     xgu_texture->format,
@@ -1197,6 +1890,19 @@ void gliTextureFlush(void)
         pb = xgu_set_texture_filter(
             pb, i, 0, XGU_TEXTURE_CONVOLUTION_GAUSSIAN, min_filter, mag_filter, false, false, false, false);
         pb = xgu_set_texture_address(pb, i, u, false, v, false, p, false, false);
+
+        // Hardware texture coordinate generation. This also overwrites any eye linear texgen left on the unit by
+        // clip planes, so have the combiners find them a stage again. glDrawTexOES quads take no texgen
+        if (texture_unit->texture_unit_dirty) {
+            const GLboolean texgen_on =
+                texture_unit->texgen_enabled && !context->transformation_state.draw_texture_active;
+            const XguTexgen texgen = (texgen_on) ? gliEnumToNvTexgen(texture_unit->texgen_mode) : XGU_TEXGEN_DISABLE;
+            pb = xgu_set_texgen_s(pb, i, texgen);
+            pb = xgu_set_texgen_t(pb, i, texgen);
+            pb = xgu_set_texgen_r(pb, i, texgen);
+            pb = xgu_set_texgen_q(pb, i, XGU_TEXGEN_DISABLE);
+            context->transformation_state.clip_plane_dirty = GL_TRUE;
+        }
         pb_end(pb);
     }
 
@@ -1205,9 +1911,12 @@ void gliTextureFlush(void)
         if (texture_unit->bound_texture_object) {
             texture_unit->bound_texture_object->texture_object_dirty = GL_FALSE;
         }
+        if (texture_unit->bound_cube_map_object) {
+            texture_unit->bound_cube_map_object->texture_object_dirty = GL_FALSE;
+        }
     }
 
-    combiner_set_texture_env();
+    GLI_PROFILE_CALL(GLI_SCOPE_COMBINER, combiner_set_texture_env());
 
     // After combiners have evaluated texture_unit_dirty, clear the flag
     for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
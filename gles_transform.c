@@ -23,6 +23,15 @@ static mat4 *current_stack_base(GLint **depth, GLint *max_depth)
             ts->texture_matrix_dirty[unit] = GL_TRUE;
             return ts->texture_matrix_stack[unit];
         }
+#ifdef GL_OES_matrix_palette
+        case GL_MATRIX_PALETTE_OES: {
+            // Palette matrices have no stack, so treat the current one as a stack of depth one
+            static GLint palette_depth = 1;
+            *depth = &palette_depth;
+            *max_depth = 1;
+            return &ts->palette_matrix[ts->current_palette_matrix];
+        }
+#endif
         default:
             assert(0 && "Invalid matrix mode");
             return NULL;
@@ -47,7 +56,11 @@ static inline void post_multiply(mat4 rhs)
 GL_API void GL_APIENTRY glMatrixMode(GLenum mode)
 {
     gli_context_t *c = gliGetContext();
-    if (mode != GL_MODELVIEW && mode != GL_PROJECTION && mode != GL_TEXTURE) {
+    if (mode != GL_MODELVIEW && mode != GL_PROJECTION && mode != GL_TEXTURE
+#ifdef GL_OES_matrix_palette
+        && mode != GL_MATRIX_PALETTE_OES
+#endif
+    ) {
         gliSetError(GL_INVALID_ENUM);
         return;
     }
@@ -315,6 +328,16 @@ GL_API void GL_APIENTRY glGetClipPlanex(GLenum plane, GLfixed *equation)
     }
 }
 
+// Texture matrix of a unit with the uv scale corrections for the texture it samples. Shared by gliTransformFlush and
+// the vertex program constants, so both paths give a draw the same texture coordinates
+void gliHardwareTextureMatrix(gli_context_t *context, GLuint unit, const xgu_texture_t *xgu_texture, mat4 out)
+{
+    transformation_state_t *ts = &context->transformation_state;
+    glm_mat4_copy(ts->texture_matrix_stack[unit][ts->texture_matrix_stack_depth[unit] - 1], out);
+    out[0][0] *= xgu_texture->u_scale;
+    out[1][1] *= xgu_texture->v_scale;
+}
+
 void gliTransformFlush(void)
 {
     gli_context_t *c = gliGetContext();
@@ -326,7 +349,13 @@ void gliTransformFlush(void)
         uint32_t *pb = pb_begin();
         pb = pb_push_transposed_matrix(pb, NV097_SET_MODEL_VIEW_MATRIX, (const float *)(*modelview));
 
-        if (c->lighting_state.lighting_enabled) {
+        // Lighting and reflection/normal map texgen both work on eye space normals
+        GLboolean texgen_enabled = GL_FALSE;
+        for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+            texgen_enabled |= c->texture_environment.texture_units[i].texgen_enabled;
+        }
+
+        if (c->lighting_state.lighting_enabled || texgen_enabled) {
             mat4 modelview_inv;
             glm_mat4_inv(*modelview, modelview_inv);
             pb = pb_push_4x4_matrix(pb, NV097_SET_INVERSE_MODEL_VIEW_MATRIX, (const float *)modelview_inv);
@@ -383,10 +412,29 @@ void gliTransformFlush(void)
         uint32_t *pb = pb_begin();
         // pb = pb_push_transposed_matrix(pb, NV097_SET_PROJECTION_MATRIX, (const float *)*projection);
         pb = pb_push_transposed_matrix(pb, NV097_SET_COMPOSITE_MATRIX, (const float *)*mvp);
+
+        // Skinned draws blend in eye space with the modelview matrices, then use this to get to screen space
+        if (ts->matrix_palette_enabled) {
+            mat4 viewport_projection;
+            glm_mat4_mul(*viewport, *projection, viewport_projection);
+            pb = pb_push_transposed_matrix(pb, NV097_SET_PROJECTION_MATRIX, (const float *)viewport_projection);
+        }
         pb_end(pb);
 
         c->transformation_state.modelview_matrix_dirty = GL_FALSE;
         c->transformation_state.projection_matrix_dirty = GL_FALSE;
+        // gliTextureFlush kept texgen off for glDrawTexOES quads, and may have cleared the dirty flag
+        // enter_screen_space set while doing so. Texgen has to be pushed again now the quads are done
+        if (c->transformation_state.draw_texture_active) {
+            for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+                texture_unit_t *texture_unit = &c->texture_environment.texture_units[i];
+                if (texture_unit->texgen_enabled) {
+                    texture_unit->texture_unit_dirty = GL_TRUE;
+                }
+            }
+        }
+        c->transformation_state.draw_texture_active = GL_FALSE;
+        c->vertex_program_state.transform_dirty = GL_TRUE;
     }
 
     if (c->transformation_state.depth_range_dirty) {
@@ -398,8 +446,11 @@ void gliTransformFlush(void)
     // Texture matrices
     for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
         texture_unit_t *texture_unit = &c->texture_environment.texture_units[i];
-        texture_object_t *texture_object = texture_unit->bound_texture_object;
+        texture_object_t *texture_object = gliSampledTextureObject(texture_unit);
 
+        if (!texture_object) {
+            texture_object = texture_unit->bound_texture_object;
+        }
         if (!texture_object) {
             continue;
         }
@@ -413,11 +464,7 @@ void gliTransformFlush(void)
         if (c->transformation_state.texture_matrix_dirty[i]) {
             c->transformation_state.texture_matrix_dirty[i] = GL_FALSE;
             mat4 texture_matrix;
-            glGetFloatv(GL_TEXTURE_MATRIX, (GLfloat *)texture_matrix);
-
-            // Apply uv scale corrections
-            texture_matrix[0][0] *= xgu_texture->u_scale;
-            texture_matrix[1][1] *= xgu_texture->v_scale;
+            gliHardwareTextureMatrix(c, i, xgu_texture, texture_matrix);
 
             // Upload to hardware
             uint32_t *pb = pb_begin();
@@ -425,6 +472,7 @@ void gliTransformFlush(void)
             pb = pb_push_transposed_matrix(
                 pb, NV097_SET_TEXTURE_MATRIX + i * (4 * 4) * 4, (const float *)texture_matrix);
             pb_end(pb);
+            c->vertex_program_state.transform_dirty = GL_TRUE;
         }
     }
 }
@@ -0,0 +1,345 @@
+#include "gles_private.h"
+
+// OES_vertex_array_object.
+// A VAO holds a copy of vertex_array_data_t. Binding one swaps that copy in and out of the context, keeping the
+// state that is not part of a VAO (the ARRAY_BUFFER binding, the client active texture and the buffer generation).
+// Each VAO also keeps the push buffer words that point the hardware at its buffer backed attributes, so rebinding an
+// unchanged VAO is a single copy into the push buffer instead of a flush of every attribute.
+
+vertex_array_object_t *gliFindVertexArrayObject(GLuint name)
+{
+    gli_context_t *context = gliGetContext();
+    if (name == 0) {
+        return &context->default_vertex_array;
+    }
+    return (vertex_array_object_t *)gliNameLookup(&context->vertex_array_names, name);
+}
+
+// Table 6.4 and 6.5 initial values, as set up by glContextInit for the default VAO
+static void init_vertex_array_state(vertex_array_data_t *vad)
+{
+    gli_memset(vad, 0, sizeof(vertex_array_data_t));
+    vad->vertex_array_size = 4;
+    vad->vertex_array_type = GL_FLOAT;
+    vad->normal_array_type = GL_FLOAT;
+    vad->color_array_size = 4;
+    vad->color_array_type = GL_FLOAT;
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        vad->texcoord_array_size[i] = 4;
+        vad->texcoord_array_type[i] = GL_FLOAT;
+    }
+    vad->point_size_array_type = GL_FLOAT;
+    vad->matrix_index_array_type = GL_UNSIGNED_BYTE;
+    vad->weight_array_type = GL_FIXED;
+}
+
+static uint32_t *encode_attrib(uint32_t *p,
+                               XguVertexArray slot,
+                               GLint size,
+                               GLenum type,
+                               GLsizei stride,
+                               const buffer_object_t *buffer,
+                               const void *ptr)
+{
+    if (stride == 0) {
+        stride = size * gliEnumtoByteSize(type);
+    }
+    const void *data = gliGetBufferPointer(buffer, ptr);
+    p = xgu_set_vertex_data_array_format(p, slot, gliEnumToNvType(type), size, stride);
+    p = xgu_set_vertex_data_array_offset(p, slot, (void *)((uint32_t)MmGetPhysicalAddress((PVOID)data)));
+    return p;
+}
+
+static uint32_t *encode_disabled(uint32_t *p, XguVertexArray slot)
+{
+    p = xgu_set_vertex_data_array_format(p, slot, XGU_FLOAT, 0, 0);
+    p = xgu_set_vertex_data_array_offset(p, slot, (void *)((uint32_t)MmGetPhysicalAddress(NULL)));
+    return p;
+}
+
+// Encode the attributes gliArrayFlush would send that don't depend on per draw staging. That is every disabled
+// attribute and every enabled one sourced from a buffer object. Client side arrays are left to gliArrayFlush.
+static void encode_vertex_array(vertex_array_object_t *vao, GLuint buffer_generation)
+{
+    const vertex_array_data_t *vad = &vao->state;
+    uint32_t *p = vao->pb_words;
+    GLuint mask = 0;
+
+    // The vertex attribute is always sent, enabled or not
+    if (vad->vertex_array_buffer) {
+        p = encode_attrib(p,
+                          XGU_VERTEX_ARRAY,
+                          vad->vertex_array_size,
+                          vad->vertex_array_type,
+                          vad->vertex_array_stride,
+                          vad->vertex_array_buffer,
+                          vad->vertex_array_ptr);
+        mask |= 1 << XGU_VERTEX_ARRAY;
+    }
+
+    if (!vad->normal_array_enabled) {
+        p = encode_disabled(p, XGU_NORMAL_ARRAY);
+        mask |= 1 << XGU_NORMAL_ARRAY;
+    } else if (vad->normal_array_buffer) {
+        p = encode_attrib(p,
+                          XGU_NORMAL_ARRAY,
+                          3,
+                          vad->normal_array_type,
+                          vad->normal_array_stride,
+                          vad->normal_array_buffer,
+                          vad->normal_array_ptr);
+        mask |= 1 << XGU_NORMAL_ARRAY;
+    }
+
+    if (!vad->color_array_enabled) {
+        p = encode_disabled(p, XGU_COLOR_ARRAY);
+        mask |= 1 << XGU_COLOR_ARRAY;
+    } else if (vad->color_array_buffer) {
+        p = encode_attrib(p,
+                          XGU_COLOR_ARRAY,
+                          vad->color_array_size,
+                          vad->color_array_type,
+                          vad->color_array_stride,
+                          vad->color_array_buffer,
+                          vad->color_array_ptr);
+        mask |= 1 << XGU_COLOR_ARRAY;
+    }
+
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        const XguVertexArray slot = XGU_TEXCOORD0_ARRAY + i;
+        if (!vad->texcoord_array_enabled[i]) {
+            p = encode_disabled(p, slot);
+            mask |= 1 << slot;
+        } else if (vad->texcoord_array_buffer[i]) {
+            p = encode_attrib(p,
+                              slot,
+                              vad->texcoord_array_size[i],
+                              vad->texcoord_array_type[i],
+                              vad->texcoord_array_stride[i],
+                              vad->texcoord_array_buffer[i],
+                              vad->texcoord_array_ptr[i]);
+            mask |= 1 << slot;
+        }
+    }
+
+    if (!vad->point_size_array_enabled) {
+        p = encode_disabled(p, XGU_POINT_SIZE_ARRAY);
+        mask |= 1 << XGU_POINT_SIZE_ARRAY;
+    } else if (vad->point_size_array_buffer) {
+        p = encode_attrib(p,
+                          XGU_POINT_SIZE_ARRAY,
+                          1,
+                          vad->point_size_array_type,
+                          vad->point_size_array_stride,
+                          vad->point_size_array_buffer,
+                          vad->point_size_array_ptr);
+        mask |= 1 << XGU_POINT_SIZE_ARRAY;
+    }
+
+    vao->pb_word_count = (GLuint)(p - vao->pb_words);
+    vao->encoded_mask = mask;
+    vao->encoded_serial = vad->attrib_serial;
+    vao->encoded_generation = buffer_generation;
+    vao->encoded = GL_TRUE;
+}
+
+GL_API void GL_APIENTRY glGenVertexArraysOES(GLsizei n, GLuint *arrays)
+{
+    gli_context_t *context = gliGetContext();
+    if (arrays == NULL || n < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    for (GLsizei i = 0; i < n; i++) {
+        // VAOs are created here rather than on first bind, as binding a name that was not generated is an error
+        vertex_array_object_t *vao = GLI_MALLOC(sizeof(vertex_array_object_t));
+        if (vao == NULL) {
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+        gli_memset(vao, 0, sizeof(vertex_array_object_t));
+
+        GLuint name = gliNameGen(&context->vertex_array_names);
+        if (!gliNameInsert(&context->vertex_array_names, name, vao)) {
+            GLI_FREE(vao);
+            gliSetError(GL_OUT_OF_MEMORY);
+            return;
+        }
+
+        vao->name = name;
+        init_vertex_array_state(&vao->state);
+
+        vao->next = context->vertex_array_objects;
+        if (vao->next) {
+            vao->next->prev = vao;
+        }
+        context->vertex_array_objects = vao;
+        arrays[i] = name;
+    }
+}
+
+GL_API void GL_APIENTRY glBindVertexArrayOES(GLuint array)
+{
+    gli_context_t *context = gliGetContext();
+    vertex_array_data_t *vad = &context->vertex_array_data;
+
+    vertex_array_object_t *vao = gliFindVertexArrayObject(array);
+    if (GLI_INVALID(vao == NULL)) {
+        gliSetError(GL_INVALID_OPERATION);
+        return;
+    }
+
+    if (vao == context->bound_vertex_array) {
+        return;
+    }
+
+    // Store the outgoing VAO's state, then swap in the new one keeping everything that is not per VAO
+    context->bound_vertex_array->state = *vad;
+
+    const GLenum client_active_texture = vad->client_active_texture;
+    const GLuint array_buffer_binding = vad->array_buffer_binding;
+    buffer_object_t *array_buffer = vad->array_buffer;
+    const GLuint buffer_generation = vad->buffer_generation;
+    const GLuint flushed_buffer_generation = vad->flushed_buffer_generation;
+
+    *vad = vao->state;
+    vad->client_active_texture = client_active_texture;
+    vad->array_buffer_binding = array_buffer_binding;
+    vad->array_buffer = array_buffer;
+    vad->buffer_generation = buffer_generation;
+    vad->flushed_buffer_generation = flushed_buffer_generation;
+
+    context->bound_vertex_array = vao;
+    context->vertex_array_binding = array;
+
+    // Re-encode if the attributes or any buffer storage changed since this VAO was last bound
+    if (!vao->encoded || vao->encoded_serial != vad->attrib_serial || vao->encoded_generation != buffer_generation) {
+        encode_vertex_array(vao, buffer_generation);
+    }
+
+    uint32_t *pb = pb_begin();
+    gli_memcpy(pb, vao->pb_words, vao->pb_word_count * sizeof(uint32_t));
+    pb += vao->pb_word_count;
+    pb_end(pb);
+
+    // Everything covered by the block is now current on the hardware. Anything else is sent by gliArrayFlush
+    const GLuint mask = vao->encoded_mask;
+    vad->vertex_array_dirty = !(mask & (1 << XGU_VERTEX_ARRAY));
+    vad->normal_array_dirty = !(mask & (1 << XGU_NORMAL_ARRAY));
+    vad->color_array_dirty = !(mask & (1 << XGU_COLOR_ARRAY));
+    vad->point_size_array_dirty = !(mask & (1 << XGU_POINT_SIZE_ARRAY));
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        vad->texcoord_array_dirty[i] = !(mask & (1 << (XGU_TEXCOORD0_ARRAY + i)));
+    }
+
+    // The attribute setup is what it was when the block was encoded, so a generation change since then is covered
+    vad->flushed_buffer_generation = buffer_generation;
+}
+
+GL_API void GL_APIENTRY glDeleteVertexArraysOES(GLsizei n, const GLuint *arrays)
+{
+    gli_context_t *context = gliGetContext();
+    if (arrays == NULL || n < 0) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+
+    for (GLsizei i = 0; i < n; i++) {
+        GLuint name = arrays[i];
+        if (name == 0) {
+            continue;
+        }
+
+        vertex_array_object_t *vao = gliFindVertexArrayObject(name);
+        gliNameRemove(&context->vertex_array_names, name);
+        if (vao == NULL) {
+            continue;
+        }
+
+        // If the bound VAO is deleted, the binding reverts to 0
+        if (context->bound_vertex_array == vao) {
+            glBindVertexArrayOES(0);
+        }
+
+        if (vao->prev) {
+            vao->prev->next = vao->next;
+        } else {
+            context->vertex_array_objects = vao->next;
+        }
+        if (vao->next) {
+            vao->next->prev = vao->prev;
+        }
+        GLI_FREE(vao);
+    }
+}
+
+GL_API GLboolean GL_APIENTRY glIsVertexArrayOES(GLuint array)
+{
+    if (array == 0) {
+        return GL_FALSE;
+    }
+    return (gliFindVertexArrayObject(array) != NULL) ? GL_TRUE : GL_FALSE;
+}
+
+static void detach_buffer(vertex_array_object_t *vao, const buffer_object_t *buffer)
+{
+    vertex_array_data_t *vad = &vao->state;
+    if (vad->element_array_buffer == buffer) {
+        vad->element_array_buffer = NULL;
+        vad->element_array_buffer_binding = 0;
+    }
+    if (vad->vertex_array_buffer == buffer) {
+        vad->vertex_array_buffer = NULL;
+        vad->vertex_array_buffer_binding = 0;
+        vad->vertex_array_ptr = NULL;
+    }
+    if (vad->normal_array_buffer == buffer) {
+        vad->normal_array_buffer = NULL;
+        vad->normal_array_buffer_binding = 0;
+        vad->normal_array_ptr = NULL;
+    }
+    if (vad->color_array_buffer == buffer) {
+        vad->color_array_buffer = NULL;
+        vad->color_array_buffer_binding = 0;
+        vad->color_array_ptr = NULL;
+    }
+    if (vad->point_size_array_buffer == buffer) {
+        vad->point_size_array_buffer = NULL;
+        vad->point_size_array_buffer_binding = 0;
+        vad->point_size_array_ptr = NULL;
+    }
+    if (vad->matrix_index_array_buffer == buffer) {
+        vad->matrix_index_array_buffer = NULL;
+        vad->matrix_index_array_buffer_binding = 0;
+        vad->matrix_index_array_ptr = NULL;
+    }
+    if (vad->weight_array_buffer == buffer) {
+        vad->weight_array_buffer = NULL;
+        vad->weight_array_buffer_binding = 0;
+        vad->weight_array_ptr = NULL;
+    }
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        if (vad->texcoord_array_buffer[i] == buffer) {
+            vad->texcoord_array_buffer[i] = NULL;
+            vad->texcoord_array_buffer_binding[i] = 0;
+            vad->texcoord_array_ptr[i] = NULL;
+        }
+    }
+    vad->attrib_serial++;
+}
+
+// Drop references to a deleted buffer from VAOs that are not bound. The bound one is handled with the context state
+void gliVertexArraysDetachBuffer(const buffer_object_t *buffer)
+{
+    gli_context_t *context = gliGetContext();
+
+    if (context->bound_vertex_array != &context->default_vertex_array) {
+        detach_buffer(&context->default_vertex_array, buffer);
+    }
+    for (vertex_array_object_t *it = context->vertex_array_objects; it != NULL; it = it->next) {
+        if (it != context->bound_vertex_array) {
+            detach_buffer(it, buffer);
+        }
+    }
+}
@@ -0,0 +1,636 @@
+#include "gles_private.h"
+
+// Fixed function to vertex program compiler. See GLI_VERTEX_PROGRAM.
+// The transform, lighting, fog and texture coordinate state that affects vertex processing is packed into a key. Each
+// key is compiled once into an NV2A vertex program that only contains the math the state needs, for example unlit
+// textured geometry is a position transform and two moves. Programs are cached by key, and the constants they read
+// are uploaded when gliTransformFlush or gliLightingFlush report a change. State the compiler does not handle (spot
+// lights, two sided lighting, point parameters, clip planes and the matrix palette) or programs that would not fit
+// in program memory fall back to the fixed function pipeline, which is always kept up to date.
+
+#if GLI_VERTEX_PROGRAM
+
+// Instruction encoding, see xemu hw/xbox/nv2a/pgraph/vsh.c
+#define MAC_MOV 1
+#define MAC_MUL 2
+#define MAC_ADD 3
+#define MAC_MAD 4
+#define MAC_DP3 5
+#define MAC_DP4 7
+#define MAC_DST 8
+#define ILU_RCP 2
+#define ILU_RCC 3
+#define ILU_RSQ 4
+#define ILU_LIT 7
+
+#define MUX_R 1
+#define MUX_V 2
+#define MUX_C 3
+
+#define MASK_X    8
+#define MASK_Y    4
+#define MASK_Z    2
+#define MASK_W    1
+#define MASK_XYZ  (MASK_X | MASK_Y | MASK_Z)
+#define MASK_XYZW (MASK_XYZ | MASK_W)
+
+#define SWZ(x, y, z, w) (((x) << 6) | ((y) << 4) | ((z) << 2) | (w))
+#define SWZ_XYZW        SWZ(0, 1, 2, 3)
+#define SWZ_X           SWZ(0, 0, 0, 0)
+#define SWZ_Y           SWZ(1, 1, 1, 1)
+#define SWZ_Z           SWZ(2, 2, 2, 2)
+#define SWZ_W           SWZ(3, 3, 3, 3)
+
+// Output registers
+#define O_POS 0
+#define O_D0  3
+#define O_D1  4
+#define O_FOG 5
+#define O_T0  9
+
+// Input registers, the same as the vertex attribute slots
+#define V_POSITION 0
+#define V_NORMAL   2
+#define V_DIFFUSE  3
+#define V_TEXCOORD 9
+
+// Temporary registers
+#define R_EYE      0
+#define R_POSITION 1
+#define R_NORMAL   2
+#define R_SCRATCH  3
+#define R_COLOR    4
+#define R_SPECULAR 5
+#define R_LIT_IN   6
+#define R_LIT      7
+#define R_VP       8
+#define R_DISTANCE 9
+#define R_ATTEN    10
+#define R_HALF     11
+
+// Constant layout. Programs never read past c95, the part of constant memory the fixed function pipeline leaves alone
+#define C_COMPOSITE     0
+#define C_MODELVIEW     4
+#define C_NORMAL        8
+#define C_TEXTURE       11
+#define C_SCENE         (C_TEXTURE + 4 * GLI_MAX_TEXTURE_UNITS) // Emission and scene ambient, alpha is material alpha
+#define C_SCENE_AMBIENT (C_SCENE + 1)                           // Scaled by the vertex color with color material
+#define C_MISC          (C_SCENE + 2)                           // (0, 1, 0, shininess)
+#define C_LIGHTS        (C_SCENE + 3)
+#define C_LIGHT_SIZE    6 // Position or direction, half vector, ambient, diffuse, specular, attenuation
+#define C_COUNT         (C_LIGHTS + C_LIGHT_SIZE * GLI_MAX_LIGHTS)
+
+// Program key
+#define KEY_LIGHTING       (1 << 0)
+#define KEY_COLOR_MATERIAL (1 << 1)
+#define KEY_NORMALIZE      (1 << 2)
+#define KEY_FOG            (1 << 3)
+#define KEY_LIGHT_SHIFT    4 // 2 bits per light
+#define KEY_TEXTURE_SHIFT  (KEY_LIGHT_SHIFT + 2 * GLI_MAX_LIGHTS) // 2 bits per texture unit
+#define LIGHT_OFF          0
+#define LIGHT_DIRECTIONAL  1
+#define LIGHT_POINT        2
+#define TEXTURE_OFF        0
+#define TEXTURE_PASS       1
+#define TEXTURE_MATRIX     2
+
+typedef struct
+{
+    GLubyte mux;
+    GLubyte index;
+    GLubyte swizzle;
+    GLubyte negate;
+} source_t;
+
+typedef struct
+{
+    XguTransformProgramInstruction instructions[NV2A_MAX_TRANSFORM_PROGRAM_LENGTH];
+    GLuint count;
+    GLboolean overflow;
+} program_builder_t;
+
+static inline source_t reg(GLubyte index, GLubyte swizzle)
+{
+    return (source_t){MUX_R, index, swizzle, 0};
+}
+
+static inline source_t in(GLubyte index)
+{
+    return (source_t){MUX_V, index, SWZ_XYZW, 0};
+}
+
+static inline source_t constant(GLubyte index, GLubyte swizzle)
+{
+    return (source_t){MUX_C, index, swizzle, 0};
+}
+
+static inline source_t negate(source_t s)
+{
+    s.negate = 1;
+    return s;
+}
+
+static const source_t unused = {MUX_R, 0, SWZ_XYZW, 0};
+
+// Emit one instruction. mac and ilu are mutually exclusive. output selects an output register instead of a temporary
+static void emit(program_builder_t *b,
+                 GLuint mac,
+                 GLuint ilu,
+                 GLboolean output,
+                 GLuint dst,
+                 GLuint mask,
+                 source_t a,
+                 source_t bb,
+                 source_t c)
+{
+    if (b->count == NV2A_MAX_TRANSFORM_PROGRAM_LENGTH) {
+        b->overflow = GL_TRUE;
+        return;
+    }
+
+    // An instruction reads at most one input register and one constant, shared by all three sources
+    GLuint v = 0;
+    GLuint k = 0;
+    const source_t *sources[3] = {&a, &bb, &c};
+    for (GLuint i = 0; i < 3; i++) {
+        if (sources[i]->mux == MUX_V) {
+            v = sources[i]->index;
+        } else if (sources[i]->mux == MUX_C) {
+            k = sources[i]->index + 96;
+        }
+    }
+
+    const GLuint c_reg = (c.mux == MUX_R) ? c.index : 0;
+    XguTransformProgramInstruction *insn = &b->instructions[b->count++];
+    insn->a = 0;
+    insn->b = (ilu << 25) | (mac << 21) | (k << 13) | (v << 9) | (a.negate << 8) | a.swizzle;
+    insn->c = (((a.mux == MUX_R) ? a.index : 0) << 28) | (a.mux << 26) | (bb.negate << 25) | (bb.swizzle << 17) |
+              (((bb.mux == MUX_R) ? bb.index : 0) << 13) | (bb.mux << 11) | (c.negate << 10) | (c.swizzle << 2) |
+              (c_reg >> 2);
+    insn->d = ((c_reg & 3) << 30) | (c.mux << 28);
+    if (output) {
+        // Output register write, the temporary register masks stay clear
+        insn->d |= (mask << 12) | (1 << 11) | (dst << 3) | ((ilu != 0) << 2);
+    } else if (mac) {
+        insn->d |= (mask << 24) | (dst << 20);
+    } else {
+        insn->d |= (dst << 20) | (mask << 16);
+    }
+}
+
+static inline void mac(program_builder_t *b, GLuint op, GLuint dst, GLuint mask, source_t a, source_t bb, source_t c)
+{
+    emit(b, op, 0, GL_FALSE, dst, mask, a, bb, c);
+}
+
+static inline void
+mac_out(program_builder_t *b, GLuint op, GLuint dst, GLuint mask, source_t a, source_t bb, source_t c)
+{
+    emit(b, op, 0, GL_TRUE, dst, mask, a, bb, c);
+}
+
+static inline void ilu(program_builder_t *b, GLuint op, GLuint dst, GLuint mask, source_t c)
+{
+    emit(b, 0, op, GL_FALSE, dst, mask, unused, unused, c);
+}
+
+static inline GLuint key_light(GLuint key, GLuint light)
+{
+    return (key >> (KEY_LIGHT_SHIFT + 2 * light)) & 3;
+}
+
+static inline GLuint key_texture(GLuint key, GLuint unit)
+{
+    return (key >> (KEY_TEXTURE_SHIFT + 2 * unit)) & 3;
+}
+
+static GLboolean is_identity(const mat4 m)
+{
+    for (GLuint col = 0; col < 4; col++) {
+        for (GLuint row = 0; row < 4; row++) {
+            if (m[col][row] != ((col == row) ? 1.0f : 0.0f)) {
+                return GL_FALSE;
+            }
+        }
+    }
+    return GL_TRUE;
+}
+
+// Texture matrix for a unit with the bound texture's coordinate scale applied, the same as gliTransformFlush uses
+static GLboolean texture_matrix(gli_context_t *context, GLuint unit, mat4 out)
+{
+    texture_unit_t *texture_unit = &context->texture_environment.texture_units[unit];
+    texture_object_t *texture_object = gliSampledTextureObject(texture_unit);
+    const xgu_texture_t *xgu_texture = (texture_object) ? (const xgu_texture_t *)texture_object->texture_2d : NULL;
+    if (!xgu_texture) {
+        return GL_FALSE;
+    }
+
+    gliHardwareTextureMatrix(context, unit, xgu_texture, out);
+    return GL_TRUE;
+}
+
+// Pack the state that decides the program's instructions. Returns GL_FALSE if the state needs the fixed function path
+static GLboolean program_key(gli_context_t *context, GLuint *key)
+{
+    transformation_state_t *ts = &context->transformation_state;
+    lighting_state_t *lighting = &context->lighting_state;
+    rasterization_state_t *rs = &context->rasterization_state;
+
+    if (ts->matrix_palette_enabled || rs->point_sprite_oes_enabled ||
+        context->vertex_array_data.point_size_array_enabled) {
+        return GL_FALSE;
+    }
+    for (GLuint i = 0; i < GLI_MAX_CLIP_PLANES; i++) {
+        if (ts->clip_plane_enabled[i]) {
+            return GL_FALSE;
+        }
+    }
+
+    GLuint k = 0;
+    if (lighting->lighting_enabled) {
+        if (lighting->light_model_two_side) {
+            return GL_FALSE;
+        }
+        k |= KEY_LIGHTING;
+        k |= (lighting->color_material_enabled) ? KEY_COLOR_MATERIAL : 0;
+        k |= (ts->normalize_enabled || ts->rescale_normal_enabled) ? KEY_NORMALIZE : 0;
+        for (GLuint i = 0; i < GLI_MAX_LIGHTS; i++) {
+            const light_t *light = &lighting->lights[i];
+            if (!light->enabled) {
+                continue;
+            }
+            if (light->spot_cutoff != 180.0f) {
+                return GL_FALSE;
+            }
+            const GLuint type = (light->position[3] == 0.0f) ? LIGHT_DIRECTIONAL : LIGHT_POINT;
+            k |= type << (KEY_LIGHT_SHIFT + 2 * i);
+        }
+    }
+    k |= (context->coloring_state.fog_enabled) ? KEY_FOG : 0;
+
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        const texture_unit_t *texture_unit = &context->texture_environment.texture_units[i];
+        // Generated and three component cube map coordinates are left to the fixed function pipeline
+        if (texture_unit->texgen_enabled || texture_unit->texture_cube_map_enabled) {
+            return GL_FALSE;
+        }
+        mat4 m;
+        if (!texture_unit->texture_2d_enabled || !texture_matrix(context, i, m)) {
+            continue;
+        }
+        const GLuint type = is_identity(m) ? TEXTURE_PASS : TEXTURE_MATRIX;
+        k |= type << (KEY_TEXTURE_SHIFT + 2 * i);
+    }
+
+    *key = k;
+    return GL_TRUE;
+}
+
+static void compile_lighting(program_builder_t *b, GLuint key)
+{
+    const GLboolean color_material = (key & KEY_COLOR_MATERIAL) != 0;
+
+    // Eye space normal
+    for (GLuint i = 0; i < 3; i++) {
+        mac(b, MAC_DP3, R_NORMAL, MASK_X >> i, in(V_NORMAL), constant(C_NORMAL + i, SWZ_XYZW), unused);
+    }
+    if (key & KEY_NORMALIZE) {
+        mac(b, MAC_DP3, R_NORMAL, MASK_W, reg(R_NORMAL, SWZ_XYZW), reg(R_NORMAL, SWZ_XYZW), unused);
+        ilu(b, ILU_RSQ, R_SCRATCH, MASK_X, reg(R_NORMAL, SWZ_W));
+        mac(b, MAC_MUL, R_NORMAL, MASK_XYZ, reg(R_NORMAL, SWZ_XYZW), reg(R_SCRATCH, SWZ_X), unused);
+    }
+
+    // color = emission + scene ambient, specular = 0, LIT's exponent = shininess
+    mac(b, MAC_MOV, R_COLOR, MASK_XYZW, constant(C_SCENE, SWZ_XYZW), unused, unused);
+    if (color_material) {
+        mac(b, MAC_MAD, R_COLOR, MASK_XYZ, in(V_DIFFUSE), constant(C_SCENE_AMBIENT, SWZ_XYZW), reg(R_COLOR, SWZ_XYZW));
+    }
+    mac(b, MAC_MOV, R_SPECULAR, MASK_XYZW, constant(C_MISC, SWZ_X), unused, unused);
+    mac(b, MAC_MOV, R_LIT_IN, MASK_W, constant(C_MISC, SWZ_W), unused, unused);
+
+    for (GLuint i = 0; i < GLI_MAX_LIGHTS; i++) {
+        const GLuint type = key_light(key, i);
+        const GLuint base = C_LIGHTS + C_LIGHT_SIZE * i;
+        if (type == LIGHT_OFF) {
+            continue;
+        }
+
+        if (type == LIGHT_DIRECTIONAL) {
+            // The direction and half vector are constant, so LIT gives (1, diffuse, specular, 1) straight away
+            mac(b, MAC_DP3, R_LIT_IN, MASK_X, reg(R_NORMAL, SWZ_XYZW), constant(base + 0, SWZ_XYZW), unused);
+            mac(b, MAC_DP3, R_LIT_IN, MASK_Y, reg(R_NORMAL, SWZ_XYZW), constant(base + 1, SWZ_XYZW), unused);
+            ilu(b, ILU_LIT, R_LIT, MASK_XYZW, reg(R_LIT_IN, SWZ_XYZW));
+        } else {
+            // VP = normalize(light - eye), with d^2 and 1/d kept for the attenuation
+            mac(b, MAC_ADD, R_VP, MASK_XYZ, constant(base + 0, SWZ_XYZW), unused, negate(reg(R_EYE, SWZ_XYZW)));
+            mac(b, MAC_DP3, R_DISTANCE, MASK_X, reg(R_VP, SWZ_XYZW), reg(R_VP, SWZ_XYZW), unused);
+            ilu(b, ILU_RSQ, R_DISTANCE, MASK_Y, reg(R_DISTANCE, SWZ_X));
+            mac(b, MAC_MUL, R_VP, MASK_XYZ, reg(R_VP, SWZ_XYZW), reg(R_DISTANCE, SWZ_Y), unused);
+
+            // attenuation = 1 / dot((1, d, d^2), (k0, k1, k2))
+            mac(b, MAC_DST, R_ATTEN, MASK_XYZW, reg(R_DISTANCE, SWZ_X), reg(R_DISTANCE, SWZ_Y), unused);
+            mac(b, MAC_DP3, R_ATTEN, MASK_X, reg(R_ATTEN, SWZ_XYZW), constant(base + 5, SWZ_XYZW), unused);
+            ilu(b, ILU_RCP, R_ATTEN, MASK_X, reg(R_ATTEN, SWZ_X));
+
+            // Half vector for an infinite viewer, normalize(VP + (0, 0, 1))
+            mac(b, MAC_ADD, R_HALF, MASK_XYZ, reg(R_VP, SWZ_XYZW), unused, constant(C_MISC, SWZ(0, 0, 1, 0)));
+            mac(b, MAC_DP3, R_HALF, MASK_W, reg(R_HALF, SWZ_XYZW), reg(R_HALF, SWZ_XYZW), unused);
+            ilu(b, ILU_RSQ, R_HALF, MASK_W, reg(R_HALF, SWZ_W));
+            mac(b, MAC_MUL, R_HALF, MASK_XYZ, reg(R_HALF, SWZ_XYZW), reg(R_HALF, SWZ_W), unused);
+
+            mac(b, MAC_DP3, R_LIT_IN, MASK_X, reg(R_NORMAL, SWZ_XYZW), reg(R_VP, SWZ_XYZW), unused);
+            mac(b, MAC_DP3, R_LIT_IN, MASK_Y, reg(R_NORMAL, SWZ_XYZW), reg(R_HALF, SWZ_XYZW), unused);
+            ilu(b, ILU_LIT, R_LIT, MASK_XYZW, reg(R_LIT_IN, SWZ_XYZW));
+            mac(b, MAC_MUL, R_LIT, MASK_XYZW, reg(R_LIT, SWZ_XYZW), reg(R_ATTEN, SWZ_X), unused);
+        }
+
+        // Ambient, scaled by the attenuation in R_LIT.x
+        if (color_material) {
+            mac(b, MAC_MUL, R_SCRATCH, MASK_XYZ, in(V_DIFFUSE), constant(base + 2, SWZ_XYZW), unused);
+            mac(b, MAC_MAD, R_COLOR, MASK_XYZ, reg(R_SCRATCH, SWZ_XYZW), reg(R_LIT, SWZ_X), reg(R_COLOR, SWZ_XYZW));
+        } else if (type == LIGHT_DIRECTIONAL) {
+            mac(b, MAC_ADD, R_COLOR, MASK_XYZ, reg(R_COLOR, SWZ_XYZW), unused, constant(base + 2, SWZ_XYZW));
+        } else {
+            mac(b, MAC_MAD, R_COLOR, MASK_XYZ, constant(base + 2, SWZ_XYZW), reg(R_LIT, SWZ_X), reg(R_COLOR, SWZ_XYZW));
+        }
+
+        // Diffuse
+        if (color_material) {
+            mac(b, MAC_MUL, R_SCRATCH, MASK_XYZ, in(V_DIFFUSE), constant(base + 3, SWZ_XYZW), unused);
+            mac(b, MAC_MAD, R_COLOR, MASK_XYZ, reg(R_SCRATCH, SWZ_XYZW), reg(R_LIT, SWZ_Y), reg(R_COLOR, SWZ_XYZW));
+        } else {
+            mac(b, MAC_MAD, R_COLOR, MASK_XYZ, constant(base + 3, SWZ_XYZW), reg(R_LIT, SWZ_Y), reg(R_COLOR, SWZ_XYZW));
+        }
+
+        // Specular
+        mac(b,
+            MAC_MAD,
+            R_SPECULAR,
+            MASK_XYZ,
+            constant(base + 4, SWZ_XYZW),
+            reg(R_LIT, SWZ_Z),
+            reg(R_SPECULAR, SWZ_XYZW));
+    }
+
+    // Alpha is the material diffuse alpha
+    mac_out(b, MAC_MOV, O_D0, MASK_XYZ, reg(R_COLOR, SWZ_XYZW), unused, unused);
+    if (color_material) {
+        mac_out(b, MAC_MOV, O_D0, MASK_W, in(V_DIFFUSE), unused, unused);
+    } else {
+        mac_out(b, MAC_MOV, O_D0, MASK_W, constant(C_SCENE, SWZ_XYZW), unused, unused);
+    }
+    mac_out(b, MAC_MOV, O_D1, MASK_XYZW, reg(R_SPECULAR, SWZ_XYZW), unused, unused);
+}
+
+static void compile(program_builder_t *b, GLuint key)
+{
+    b->count = 0;
+    b->overflow = GL_FALSE;
+
+    // Screen space position. The composite matrix includes the viewport, so only the perspective divide is left
+    for (GLuint i = 0; i < 4; i++) {
+        mac(b, MAC_DP4, R_POSITION, MASK_X >> i, in(V_POSITION), constant(C_COMPOSITE + i, SWZ_XYZW), unused);
+    }
+    ilu(b, ILU_RCC, R_SCRATCH, MASK_X, reg(R_POSITION, SWZ_W));
+    mac_out(b, MAC_MUL, O_POS, MASK_XYZ, reg(R_POSITION, SWZ_XYZW), reg(R_SCRATCH, SWZ_X), unused);
+    mac_out(b, MAC_MOV, O_POS, MASK_W, reg(R_POSITION, SWZ_XYZW), unused, unused);
+
+    // Eye space position, needed by point lights and fog
+    GLboolean needs_eye = (key & KEY_FOG) != 0;
+    for (GLuint i = 0; i < GLI_MAX_LIGHTS; i++) {
+        needs_eye |= (key_light(key, i) == LIGHT_POINT);
+    }
+    if (needs_eye) {
+        for (GLuint i = 0; i < 3; i++) {
+            mac(b, MAC_DP4, R_EYE, MASK_X >> i, in(V_POSITION), constant(C_MODELVIEW + i, SWZ_XYZW), unused);
+        }
+    }
+
+    if (key & KEY_LIGHTING) {
+        compile_lighting(b, key);
+    } else {
+        mac_out(b, MAC_MOV, O_D0, MASK_XYZW, in(V_DIFFUSE), unused, unused);
+        mac_out(b, MAC_MOV, O_D1, MASK_XYZW, constant(C_MISC, SWZ_X), unused, unused);
+    }
+
+    // Fog coordinate is the eye distance, matching XGU_FOG_GEN_MODE_RADIAL
+    if (key & KEY_FOG) {
+        mac(b, MAC_DP3, R_DISTANCE, MASK_X, reg(R_EYE, SWZ_XYZW), reg(R_EYE, SWZ_XYZW), unused);
+        ilu(b, ILU_RSQ, R_DISTANCE, MASK_Y, reg(R_DISTANCE, SWZ_X));
+        mac_out(b, MAC_MUL, O_FOG, MASK_XYZW, reg(R_DISTANCE, SWZ_X), reg(R_DISTANCE, SWZ_Y), unused);
+    }
+
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        const GLuint type = key_texture(key, i);
+        if (type == TEXTURE_PASS) {
+            mac_out(b, MAC_MOV, O_T0 + i, MASK_XYZW, in(V_TEXCOORD + i), unused, unused);
+        } else if (type == TEXTURE_MATRIX) {
+            for (GLuint row = 0; row < 4; row++) {
+                mac_out(b,
+                        MAC_DP4,
+                        O_T0 + i,
+                        MASK_X >> row,
+                        in(V_TEXCOORD + i),
+                        constant(C_TEXTURE + i * 4 + row, SWZ_XYZW),
+                        unused);
+            }
+        }
+    }
+
+    if (!b->overflow) {
+        b->instructions[b->count - 1].d |= 1; // Final instruction
+    }
+}
+
+// Find the cached program for a key, compiling it on a miss
+static vertex_program_t *lookup_program(gli_context_t *context, GLuint key)
+{
+    vertex_program_t *cache = context->vertex_program_state.programs;
+    const GLuint hash = (key * 2654435761u) >> 16;
+
+    GLuint slot = hash % GLI_VERTEX_PROGRAM_CACHE_SIZE;
+    for (GLuint i = 0; i < GLI_VERTEX_PROGRAM_CACHE_SIZE; i++) {
+        vertex_program_t *program = &cache[(hash + i) % GLI_VERTEX_PROGRAM_CACHE_SIZE];
+        if (program->valid && program->key == key) {
+            return program;
+        }
+        if (!program->valid) {
+            slot = (hash + i) % GLI_VERTEX_PROGRAM_CACHE_SIZE;
+            break;
+        }
+    }
+
+    // Miss. Replace the home slot if the cache is full
+    static program_builder_t builder;
+    compile(&builder, key);
+
+    vertex_program_t *program = &cache[slot];
+    if (program->instructions) {
+        GLI_FREE(program->instructions);
+    }
+    program->key = key;
+    program->valid = GL_TRUE;
+    program->instructions = NULL;
+    program->count = 0; // Too long for program memory, the fixed function pipeline draws this state
+    if (!builder.overflow) {
+        const GLuint size = builder.count * sizeof(XguTransformProgramInstruction);
+        program->instructions = GLI_MALLOC(size);
+        if (program->instructions) {
+            gli_memcpy(program->instructions, builder.instructions, size);
+            program->count = builder.count;
+        }
+    }
+    if (context->vertex_program_state.loaded == program) {
+        context->vertex_program_state.loaded = NULL;
+    }
+    return program;
+}
+
+static inline void set_row(XguVec4 *v, const mat4 m, GLuint row)
+{
+    v->x = m[0][row];
+    v->y = m[1][row];
+    v->z = m[2][row];
+    v->w = m[3][row];
+}
+
+static void upload_transform(gli_context_t *context)
+{
+    transformation_state_t *ts = &context->transformation_state;
+    mat4 *modelview = &ts->modelview_matrix_stack[ts->modelview_matrix_stack_depth - 1];
+    mat4 *projection = &ts->projection_matrix_stack[ts->projection_matrix_stack_depth - 1];
+
+    XguVec4 c[C_SCENE];
+    gli_memset(c, 0, sizeof(c));
+
+    mat4 composite;
+    glm_mat4_mulN((const mat4 *[]){&ts->viewport_matrix, projection, modelview}, 3, composite);
+    mat4 modelview_inv;
+    glm_mat4_inv(*modelview, modelview_inv);
+    for (GLuint row = 0; row < 4; row++) {
+        set_row(&c[C_COMPOSITE + row], composite, row);
+        set_row(&c[C_MODELVIEW + row], *modelview, row);
+    }
+
+    // Normals use the inverse transpose, so its rows are the inverse's columns
+    for (GLuint row = 0; row < 3; row++) {
+        c[C_NORMAL + row] = (XguVec4){{modelview_inv[row][0], modelview_inv[row][1], modelview_inv[row][2], 0.0f}};
+    }
+
+    for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
+        mat4 m;
+        if (texture_matrix(context, i, m)) {
+            for (GLuint row = 0; row < 4; row++) {
+                set_row(&c[C_TEXTURE + i * 4 + row], m, row);
+            }
+        }
+    }
+    xgux_set_transform_constant_vec4(0, C_SCENE, c);
+}
+
+static void upload_lighting(gli_context_t *context)
+{
+    lighting_state_t *lighting = &context->lighting_state;
+    const material_t *material = &lighting->material_front;
+    const GLboolean color_material = lighting->color_material_enabled;
+
+    XguVec4 c[C_COUNT - C_SCENE];
+    gli_memset(c, 0, sizeof(c));
+
+    XguVec4 *scene = &c[0];
+    XguVec4 *scene_ambient = &c[C_SCENE_AMBIENT - C_SCENE];
+    for (GLuint j = 0; j < 3; j++) {
+        scene->f[j] = material->emission[j];
+        if (color_material) {
+            scene_ambient->f[j] = lighting->light_model_ambient[j];
+        } else {
+            scene->f[j] += lighting->light_model_ambient[j] * material->ambient[j];
+        }
+    }
+    scene->w = material->diffuse[3];
+    c[C_MISC - C_SCENE] = (XguVec4){{0.0f, 1.0f, 0.0f, material->shininess}};
+
+    for (GLuint i = 0; i < GLI_MAX_LIGHTS; i++) {
+        const light_t *light = &lighting->lights[i];
+        XguVec4 *l = &c[C_LIGHTS - C_SCENE + C_LIGHT_SIZE * i];
+
+        if (light->position[3] == 0.0f) {
+            vec3 L = {light->position[0], light->position[1], light->position[2]};
+            glm_vec3_normalize(L);
+            vec3 H = {L[0], L[1], L[2] + 1.0f};
+            glm_vec3_normalize(H);
+            l[0] = (XguVec4){{L[0], L[1], L[2], 0.0f}};
+            l[1] = (XguVec4){{H[0], H[1], H[2], 0.0f}};
+        } else {
+            const GLfloat w = light->position[3];
+            l[0] = (XguVec4){{light->position[0] / w, light->position[1] / w, light->position[2] / w, 1.0f}};
+        }
+
+        // With color material the vertex color replaces the material ambient and diffuse in the program
+        for (GLuint j = 0; j < 3; j++) {
+            l[2].f[j] = light->ambient[j] * (color_material ? 1.0f : material->ambient[j]);
+            l[3].f[j] = light->diffuse[j] * (color_material ? 1.0f : material->diffuse[j]);
+            l[4].f[j] = light->specular[j] * material->specular[j];
+        }
+        l[5] = (XguVec4){
+            {light->constant_attenuation, light->linear_attenuation, light->quadratic_attenuation, 0.0f}
+        };
+    }
+    xgux_set_transform_constant_vec4(C_SCENE, C_COUNT - C_SCENE, c);
+}
+
+void gliVertexProgramFlush(void)
+{
+    gli_context_t *context = gliGetContext();
+    vertex_program_state_t *vps = &context->vertex_program_state;
+
+    GLuint key;
+    vertex_program_t *program = NULL;
+    if (program_key(context, &key)) {
+        program = lookup_program(context, key);
+    }
+    if (!program || program->count == 0) {
+        gliVertexProgramSuspend();
+        return;
+    }
+
+    if (!vps->active) {
+        uint32_t *pb = pb_begin();
+        pb = xgu_set_transform_execution_mode(pb, XGU_PROGRAM, XGU_RANGE_MODE_PRIVATE);
+        pb = xgu_set_transform_program_cxt_write_enable(pb, false);
+        pb = xgu_set_transform_program_start(pb, 0);
+        pb_end(pb);
+        vps->active = GL_TRUE;
+    }
+
+    if (vps->loaded != program) {
+        xgux_set_transform_program(0, program->count, program->instructions);
+        vps->loaded = program;
+    }
+
+    if (vps->transform_dirty) {
+        upload_transform(context);
+        vps->transform_dirty = GL_FALSE;
+    }
+    if (vps->lighting_dirty) {
+        upload_lighting(context);
+        vps->lighting_dirty = GL_FALSE;
+    }
+}
+
+// Hand vertex processing back to the fixed function pipeline
+void gliVertexProgramSuspend(void)
+{
+    gli_context_t *context = gliGetContext();
+    vertex_program_state_t *vps = &context->vertex_program_state;
+    if (!vps->active) {
+        return;
+    }
+
+    uint32_t *pb = pb_begin();
+    pb = xgu_set_transform_execution_mode(pb, XGU_FIXED, XGU_RANGE_MODE_PRIVATE);
+    pb_end(pb);
+    vps->active = GL_FALSE;
+}
+#endif
@@ -20,6 +20,9 @@ extern "C" {
 #ifdef NXDK_GLES11_WITH_GL4ES
 #include "gl_prefix.h"
 #endif
+#if defined(GLI_CAPTURE) && GLI_CAPTURE
+#include "gl_capture_prefix.h"
+#endif
 
 /* Generated on date 20251022 */
 
@@ -568,9 +571,79 @@ GL_API void GL_APIENTRY glPointSizePointerOES (GLenum type, GLsizei stride, cons
 #define GL_IMPLEMENTATION_COLOR_READ_FORMAT_OES 0x8B9B
 #endif /* GL_OES_read_format */
 
+// glHint target. GL_FASTEST stores GL_UNSIGNED_BYTE GL_RGB textures as R5G6B5, and GL_RGBA textures with only
+// fully opaque or fully transparent texels as A1R5G5B5
+#ifndef GL_TEXTURE_COMPRESSION_HINT
+#define GL_TEXTURE_COMPRESSION_HINT       0x84EF
+#endif
+
+// glBeginQueryEXT target that returns the number of samples that passed the depth test instead of a boolean, as in
+// desktop GL
+#ifndef GL_SAMPLES_PASSED
+#define GL_SAMPLES_PASSED                 0x8914
+#endif
+
+// glGetIntegerv pnames. The FRAME counters cover the last frame and are reset by glFlipNV2A. The MEMORY values are the
+// contiguous memory in use now, in bytes
+#ifndef GL_NV2A_frame_counters
+#define GL_NV2A_frame_counters 1
+#define GL_FRAME_DRAW_CALLS_NV2A          0x10000
+#define GL_FRAME_VERTICES_NV2A            0x10001
+#define GL_FRAME_INDICES_NV2A             0x10002
+#define GL_FRAME_STAGED_BYTES_NV2A        0x10003
+#define GL_FRAME_STAGING_WRAPS_NV2A       0x10004
+#define GL_FRAME_TEXTURE_UPLOADS_NV2A     0x10005
+#define GL_FRAME_TEXTURE_UPLOAD_BYTES_NV2A 0x10006
+#define GL_FRAME_COMBINER_UPDATES_NV2A    0x10007
+#define GL_FRAME_STATE_FLUSHES_NV2A       0x10008
+#define GL_FRAME_EMPTY_STATE_FLUSHES_NV2A 0x10009
+#define GL_FRAME_PUSHBUFFER_WORDS_NV2A    0x1000A
+#define GL_TEXTURE_MEMORY_NV2A            0x10010
+#define GL_BUFFER_MEMORY_NV2A             0x10011
+#define GL_RENDERBUFFER_MEMORY_NV2A       0x10012
+#define GL_STAGING_MEMORY_NV2A            0x10013
+#define GL_PENDING_FREE_MEMORY_NV2A       0x10014
+#endif
+
 void glContextInit(GLint window_width, GLint window_height);
 void glFlipNV2A();
 void glSwapInterval(int interval);
+void glFramesInFlightNV2A(int frames);
+
+// Statistics of one presented frame. Times are in nanoseconds
+typedef struct
+{
+    GLuint frame;                    // Frame number, counted from glContextInit
+    khronos_uint64_t cpu_time_ns;    // From the previous glFlipNV2A returning to this one being called
+    khronos_uint64_t flip_wait_ns;   // Spent blocked in glFlipNV2A
+    khronos_uint64_t finish_wait_ns; // Spent blocked in glFinish during the frame
+    khronos_uint64_t gpu_busy_ns;    // From the GPU starting the frame to it finishing the frame
+    khronos_uint64_t gpu_idle_ns;    // The GPU waited for the CPU between the previous frame and this one
+    GLuint missed_vblanks;           // Vblanks past the swap interval since the previous flip
+    GLuint pushbuffer_words;         // Words written to the push buffer
+} GLframeStatsNV2A;
+
+// Fill stats with up to count frames the GPU has finished, newest first. Returns the number filled
+GLint glGetFrameStatsNV2A(GLint count, GLframeStatsNV2A *stats);
+
+// CPU time one stage of the draw path took over the last frame. Only measured when built with GLI_PROFILE
+typedef struct
+{
+    const char *name;
+    khronos_uint64_t time_ns;
+    GLuint calls; // Times the stage ran
+} GLprofileScopeNV2A;
+
+// Fill scopes with up to count stages of the last frame. Returns the number filled, 0 without GLI_PROFILE
+GLint glGetProfileNV2A(GLint count, GLprofileScopeNV2A *scopes);
+// Start or stop recording every timed stage for glExportTraceNV2A
+void glTraceNV2A(GLboolean enable);
+// Write the recorded stages as Chrome trace event JSON. Returns the full length, like snprintf
+GLsizei glExportTraceNV2A(char *buffer, GLsizei size);
+
+// Write every following GL call to the file at path for samples/gl_replay, or stop with NULL. Returns GL_FALSE if the
+// file can't be opened, or the library wasn't built with NXDK_GLES11_WITH_CAPTURE
+GLboolean glCaptureNV2A(const char *path);
 
 #ifdef __cplusplus
 }
@@ -38,11 +38,11 @@ extern "C" {
 #define GL_OES_blend_func_separate 0
 //#define GL_OES_blend_subtract 0
 #define GL_OES_byte_coordinates 0
-#define GL_OES_compressed_ETC1_RGB8_sub_texture 0
-#define GL_OES_compressed_ETC1_RGB8_texture 0
+//#define GL_OES_compressed_ETC1_RGB8_sub_texture 0
+//#define GL_OES_compressed_ETC1_RGB8_texture 0
 // #define GL_OES_depth24 0
 #define GL_OES_depth32 0
-#define GL_OES_draw_texture 0
+//#define GL_OES_draw_texture 0
 //#define GL_OES_element_index_uint 0
 #define GL_OES_extended_matrix_palette 0
 #define GL_OES_fbo_render_mipmap 0
@@ -50,7 +50,7 @@ extern "C" {
 // #define GL_OES_framebuffer_object 0
 #define GL_OES_mapbuffer 0
 #define GL_OES_matrix_get 0
-#define GL_OES_matrix_palette 0
+//#define GL_OES_matrix_palette 0
 // #define GL_OES_packed_depth_stencil 0
 #define GL_OES_query_matrix 0
 // #define GL_OES_required_internalformat 0
@@ -61,11 +61,11 @@ extern "C" {
 #define GL_OES_stencil8 0
 //#define GL_OES_stencil_wrap 0
 #define GL_OES_surfaceless_context 0
-#define GL_OES_texture_cube_map 0
+//#define GL_OES_texture_cube_map 0
 #define GL_OES_texture_env_crossbar 0
 //#define GL_OES_texture_mirrored_repeat 0
 //#define GL_OES_texture_npot 0
-#define GL_OES_vertex_array_object 0
+// #define GL_OES_vertex_array_object 0
 #define GL_AMD_compressed_3DC_texture 0
 #define GL_AMD_compressed_ATC_texture 0
 #define GL_APPLE_copy_texture_levels 0
@@ -79,12 +79,12 @@ extern "C" {
 #define GL_EXT_debug_marker 0
 #define GL_EXT_discard_framebuffer 0
 #define GL_EXT_map_buffer_range 0
-#define GL_EXT_multi_draw_arrays 0
+// #define GL_EXT_multi_draw_arrays 0
 #define GL_EXT_multisampled_render_to_texture 0
 #define GL_EXT_read_format_bgra 0
 #define GL_EXT_robustness 
 #define GL_EXT_sRGB 0
-#define GL_EXT_texture_compression_dxt1 0
+//#define GL_EXT_texture_compression_dxt1 0
 #define GL_EXT_texture_filter_anisotropic 0
 #define GL_EXT_texture_format_BGRA8888 0
 #define GL_EXT_texture_lod_bias 0
@@ -94,7 +94,7 @@ extern "C" {
 #define GL_IMG_texture_compression_pvrtc 0
 #define GL_IMG_texture_env_enhanced_fixed_function 0
 #define GL_IMG_user_clip_plane 0
-#define GL_NV_fence 0
+//#define GL_NV_fence 0
 #define GL_QCOM_driver_control 0
 #define GL_QCOM_extended_get 0
 #define GL_QCOM_extended_get2 0
@@ -690,6 +690,45 @@ GL_API void GL_APIENTRY glDiscardFramebufferEXT (GLenum target, GLsizei numAttac
 #endif
 #endif /* GL_EXT_discard_framebuffer */
 
+#ifndef GL_EXT_disjoint_timer_query
+#define GL_EXT_disjoint_timer_query 1
+typedef khronos_int64_t GLint64;
+typedef khronos_uint64_t GLuint64;
+#define GL_QUERY_COUNTER_BITS_EXT         0x8864
+#define GL_CURRENT_QUERY_EXT              0x8865
+#define GL_QUERY_RESULT_EXT               0x8866
+#define GL_QUERY_RESULT_AVAILABLE_EXT     0x8867
+#define GL_TIME_ELAPSED_EXT               0x88BF
+#define GL_TIMESTAMP_EXT                  0x8E28
+#define GL_GPU_DISJOINT_EXT               0x8FBB
+typedef void (GL_APIENTRYP PFNGLGENQUERIESEXTPROC) (GLsizei n, GLuint *ids);
+typedef void (GL_APIENTRYP PFNGLDELETEQUERIESEXTPROC) (GLsizei n, const GLuint *ids);
+typedef GLboolean (GL_APIENTRYP PFNGLISQUERYEXTPROC) (GLuint id);
+typedef void (GL_APIENTRYP PFNGLBEGINQUERYEXTPROC) (GLenum target, GLuint id);
+typedef void (GL_APIENTRYP PFNGLENDQUERYEXTPROC) (GLenum target);
+typedef void (GL_APIENTRYP PFNGLQUERYCOUNTEREXTPROC) (GLuint id, GLenum target);
+typedef void (GL_APIENTRYP PFNGLGETQUERYIVEXTPROC) (GLenum target, GLenum pname, GLint *params);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTIVEXTPROC) (GLuint id, GLenum pname, GLint *params);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTUIVEXTPROC) (GLuint id, GLenum pname, GLuint *params);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTI64VEXTPROC) (GLuint id, GLenum pname, GLint64 *params);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTUI64VEXTPROC) (GLuint id, GLenum pname, GLuint64 *params);
+typedef void (GL_APIENTRYP PFNGLGETINTEGER64VEXTPROC) (GLenum pname, GLint64 *data);
+#ifdef GL_GLEXT_PROTOTYPES
+GL_API void GL_APIENTRY glGenQueriesEXT (GLsizei n, GLuint *ids);
+GL_API void GL_APIENTRY glDeleteQueriesEXT (GLsizei n, const GLuint *ids);
+GL_API GLboolean GL_APIENTRY glIsQueryEXT (GLuint id);
+GL_API void GL_APIENTRY glBeginQueryEXT (GLenum target, GLuint id);
+GL_API void GL_APIENTRY glEndQueryEXT (GLenum target);
+GL_API void GL_APIENTRY glQueryCounterEXT (GLuint id, GLenum target);
+GL_API void GL_APIENTRY glGetQueryivEXT (GLenum target, GLenum pname, GLint *params);
+GL_API void GL_APIENTRY glGetQueryObjectivEXT (GLuint id, GLenum pname, GLint *params);
+GL_API void GL_APIENTRY glGetQueryObjectuivEXT (GLuint id, GLenum pname, GLuint *params);
+GL_API void GL_APIENTRY glGetQueryObjecti64vEXT (GLuint id, GLenum pname, GLint64 *params);
+GL_API void GL_APIENTRY glGetQueryObjectui64vEXT (GLuint id, GLenum pname, GLuint64 *params);
+GL_API void GL_APIENTRY glGetInteger64vEXT (GLenum pname, GLint64 *data);
+#endif
+#endif /* GL_EXT_disjoint_timer_query */
+
 #ifndef GL_EXT_map_buffer_range
 #define GL_EXT_map_buffer_range 1
 #define GL_MAP_READ_BIT_EXT               0x0001
@@ -730,6 +769,31 @@ GL_API void GL_APIENTRY glFramebufferTexture2DMultisampleEXT (GLenum target, GLe
 #endif
 #endif /* GL_EXT_multisampled_render_to_texture */
 
+#ifndef GL_EXT_occlusion_query_boolean
+#define GL_EXT_occlusion_query_boolean 1
+#define GL_ANY_SAMPLES_PASSED_EXT         0x8C2F
+#define GL_ANY_SAMPLES_PASSED_CONSERVATIVE_EXT 0x8D6A
+#define GL_CURRENT_QUERY_EXT              0x8865
+#define GL_QUERY_RESULT_EXT               0x8866
+#define GL_QUERY_RESULT_AVAILABLE_EXT     0x8867
+typedef void (GL_APIENTRYP PFNGLGENQUERIESEXTPROC) (GLsizei n, GLuint *ids);
+typedef void (GL_APIENTRYP PFNGLDELETEQUERIESEXTPROC) (GLsizei n, const GLuint *ids);
+typedef GLboolean (GL_APIENTRYP PFNGLISQUERYEXTPROC) (GLuint id);
+typedef void (GL_APIENTRYP PFNGLBEGINQUERYEXTPROC) (GLenum target, GLuint id);
+typedef void (GL_APIENTRYP PFNGLENDQUERYEXTPROC) (GLenum target);
+typedef void (GL_APIENTRYP PFNGLGETQUERYIVEXTPROC) (GLenum target, GLenum pname, GLint *params);
+typedef void (GL_APIENTRYP PFNGLGETQUERYOBJECTUIVEXTPROC) (GLuint id, GLenum pname, GLuint *params);
+#ifdef GL_GLEXT_PROTOTYPES
+GL_API void GL_APIENTRY glGenQueriesEXT (GLsizei n, GLuint *ids);
+GL_API void GL_APIENTRY glDeleteQueriesEXT (GLsizei n, const GLuint *ids);
+GL_API GLboolean GL_APIENTRY glIsQueryEXT (GLuint id);
+GL_API void GL_APIENTRY glBeginQueryEXT (GLenum target, GLuint id);
+GL_API void GL_APIENTRY glEndQueryEXT (GLenum target);
+GL_API void GL_APIENTRY glGetQueryivEXT (GLenum target, GLenum pname, GLint *params);
+GL_API void GL_APIENTRY glGetQueryObjectuivEXT (GLuint id, GLenum pname, GLuint *params);
+#endif
+#endif /* GL_EXT_occlusion_query_boolean */
+
 #ifndef GL_EXT_read_format_bgra
 #define GL_EXT_read_format_bgra 1
 #define GL_UNSIGNED_SHORT_4_4_4_4_REV_EXT 0x8365
@@ -771,6 +835,12 @@ GL_API void GL_APIENTRY glGetnUniformivEXT (GLuint program, GLint location, GLsi
 #define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT  0x83F1
 #endif /* GL_EXT_texture_compression_dxt1 */
 
+#ifndef GL_EXT_texture_compression_s3tc
+#define GL_EXT_texture_compression_s3tc 1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT  0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT  0x83F3
+#endif /* GL_EXT_texture_compression_s3tc */
+
 #ifndef GL_EXT_texture_filter_anisotropic
 #define GL_EXT_texture_filter_anisotropic 1
 #define GL_TEXTURE_MAX_ANISOTROPY_EXT     0x84FE
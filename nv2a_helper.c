@@ -6,22 +6,59 @@ void glSwapInterval(int interval)
     gl_swap_interval = interval;
 }
 
-void glFlipNV2A()
+void glFramesInFlightNV2A(int frames)
 {
     gli_context_t *context = gliGetContext();
+    if (frames < 0 || frames > GLI_MAX_FRAMES_IN_FLIGHT) {
+        gliSetError(GL_INVALID_VALUE);
+        return;
+    }
+    context->max_frames_in_flight = frames;
+}
 
+// Queued present. Instead of waiting for the GPU to go idle, the swap interval is paced off the vblank counter and the
+// CPU only blocks once more than max_frames_in_flight frames are still being rendered
+static void wait_for_present_slot(gli_context_t *context)
+{
     if (gl_swap_interval > 0) {
+        while ((GLuint)(pb_get_vbl_counter() - context->present_vbl) < (GLuint)gl_swap_interval) {
+            gliTimerPoll();
+            NtYieldExecution();
+        }
+    }
+    context->present_vbl = pb_get_vbl_counter();
+}
+
+void glFlipNV2A()
+{
+    gli_context_t *context = gliGetContext();
+    const uint64_t flip_tsc = gliReadTsc();
+    GLI_PROFILE_BEGIN(GLI_SCOPE_FLIP);
+
+    gliDrawClose();
+
+    // The frame's fence goes in before any waiting, so the time the GPU finishes it is seen while waiting
+    context->frame_fences[context->frame_count % (GLI_MAX_FRAMES_IN_FLIGHT + 1)] = gliFrameStatsSubmit(flip_tsc);
+
+    if (context->max_frames_in_flight > 0) {
+        wait_for_present_slot(context);
+    } else if (gl_swap_interval > 0) {
         for (int i = 0; i < gl_swap_interval; i++) {
             pb_wait_for_vbl();
         }
         while (pb_busy()) {
+            gliTimerPoll();
             NtYieldExecution();
         }
     }
 
+    // pb_finished queues the flip behind the frame. It only refuses while every spare framebuffer is still waiting to
+    // be shown
     while (pb_finished()) {
+        gliTimerPoll();
         NtYieldExecution();
     }
+    gliTimerPoll();
 
     // Reset bits that pb_finished changes
     uint32_t *pb = pb_begin();
@@ -33,6 +70,41 @@ void glFlipNV2A()
     pb_end(pb);
 
     pb_reset();
+
+    context->frame_count++;
+
+    // Bound the latency. The frame max_frames_in_flight before the one just queued has to be finished
+    const GLuint max_frames = context->max_frames_in_flight;
+    if (max_frames > 0 && context->frame_count > max_frames) {
+        gliFenceWait(context->frame_fences[(context->frame_count - 1 - max_frames) % (GLI_MAX_FRAMES_IN_FLIGHT + 1)]);
+    }
+
+    // Release everything deleted in frames the GPU has finished. Blocks still in use by queued frames stay behind
+    // their fence until a later flip
+    gliDeferredDrain(GL_FALSE);
+
+    gliFrameStatsFlipDone(gl_swap_interval);
+
+    GLI_PROFILE_END(GLI_SCOPE_FLIP);
+    gliProfileFlip();
+    gliLintFlip();
+}
+
+uint32_t *gliPbBegin(void)
+{
+    gli_context_t *context = gliGetContext();
+    if (context->draw_open) {
+        gliDrawClose();
+    }
+    context->pb_window = (pb_begin)();
+    return context->pb_window;
+}
+
+void gliPbEnd(uint32_t *end)
+{
+    gli_context_t *context = gliGetContext();
+    context->frame_counters[GLI_COUNTER_PUSHBUFFER_WORDS] += (GLuint)(end - context->pb_window);
+    (pb_end)(end);
 }
 
 XguVertexArrayType gliEnumToNvType(GLenum type)
@@ -213,6 +285,20 @@ XguFogMode gliEnumToNvFogMode(GLenum mode)
     }
 }
 
+XguTexgen gliEnumToNvTexgen(GLenum mode)
+{
+    switch (mode) {
+#ifdef GL_OES_texture_cube_map
+        case GL_REFLECTION_MAP_OES:
+            return XGU_TEXGEN_REFLECTION_MAP;
+        case GL_NORMAL_MAP_OES:
+            return XGU_TEXGEN_NORMAL_MAP;
+#endif
+        default:
+            return XGU_TEXGEN_DISABLE;
+    }
+}
+
 uint32_t gliFormatToNvSurfaceFormat(GLenum format)
 {
     switch (format) {
@@ -297,6 +383,27 @@ XguTexFormatColor gliEnumToNvTexFormat(GLenum format, GLenum type, GLuint *bytes
     return (XguTexFormatColor)-1;
 }
 
+XguTexFormatColor gliEnumToNvCompressedTexFormat(GLenum internalformat, GLuint *block_size)
+{
+    switch (internalformat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_ETC1_RGB8_OES: // Transcoded to DXT1 during upload
+            *block_size = 8;
+            return XGU_TEXTURE_FORMAT_DXT1;
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+            *block_size = 16;
+            return XGU_TEXTURE_FORMAT_DXT3;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            *block_size = 16;
+            return XGU_TEXTURE_FORMAT_DXT5;
+        default:
+            break;
+    }
+
+    return (XguTexFormatColor)-1;
+}
+
 DWORD gliColor4fToNvColor(uint32_t fmt_color, const GLfloat color[4])
 {
     switch (fmt_color) {
@@ -545,6 +652,8 @@ void combiner_set_texture_env(void)
     gli_context_t *context = gliGetContext();
     uint32_t *pb;
 
+    gliCount(GLI_COUNTER_COMBINER_UPDATES, 1);
+
     DWORD shader_program[4] = {
         NV097_SET_SHADER_STAGE_PROGRAM_STAGEn_PROGRAM_NONE,
         NV097_SET_SHADER_STAGE_PROGRAM_STAGEn_PROGRAM_NONE,
@@ -558,13 +667,17 @@ void combiner_set_texture_env(void)
     for (GLuint i = 0; i < GLI_MAX_TEXTURE_UNITS; i++) {
         texture_unit_t *texture_unit = &context->texture_environment.texture_units[i];
 
-        if (!texture_unit->texture_2d_enabled ||
-            texture_unit->bound_texture_object == &texture_unit->unbound_texture_object) {
+        const texture_object_t *texture_object = gliSampledTextureObject(texture_unit);
+        if (texture_object == NULL || texture_object == &texture_unit->unbound_texture_object ||
+            texture_object == &texture_unit->unbound_cube_map_object) {
             continue;
         }
 
         const uint32_t s = i;
-        shader_program[s] = NV097_SET_SHADER_STAGE_PROGRAM_STAGEn_2D_PROJECTIVE;
+        const xgu_texture_t *sampled_texture = texture_object->texture_2d;
+        shader_program[s] = (sampled_texture && sampled_texture->cube_map)
+                                ? NV097_SET_SHADER_STAGE_PROGRAM_STAGEn_CUBE_MAP
+                                : NV097_SET_SHADER_STAGE_PROGRAM_STAGEn_2D_PROJECTIVE;
 
         if (!texture_unit->texture_unit_dirty) {
             continue;
@@ -1,6 +1,18 @@
 #pragma once
 #include <GLES/gl.h>
 #include <xgu.h>
+
+// Draw merging leaves the last draw's begin/end block open, so anything else written to the push buffer has to close
+// it first, and the frame statistics count the words pushed. Routing pb_begin and pb_end through the library catches
+// every writer, including the xgux helpers included below.
+#ifndef GLI_DRAW_MERGING
+#define GLI_DRAW_MERGING 0
+#endif
+uint32_t *gliPbBegin(void);
+void gliPbEnd(uint32_t *end);
+#define pb_begin()  gliPbBegin()
+#define pb_end(end) gliPbEnd(end)
+
 #include <xgux.h>
 
 #include "gles_math.h"
@@ -9,13 +21,27 @@
 #define GLI_MAX_TEXTURE_UNITS                                                                                          \
     XGU_TEXTURE_COUNT // This is shared with clip planes (4 per stage) and only one point sprite can be enabled
 #define GLI_MAX_CLIP_PLANES   4 // One texture unit can handle 4 planes.
+#define GLI_MAX_VERTEX_UNITS  XGU_WEIGHT_COUNT // Matrices the hardware can blend per vertex
 #define GLI_MAX_TEXTURE_SIZE  4096
 #define GLI_VENDOR_STRING     "nxdk GLES Renderer"
 #define GLI_RENDERER_STRING   "nv2a-based GPU"
 #define GLI_EXTENSIONS_STRING                                                                                          \
     "GL_OES_element_index_uint GL_OES_point_size_array GL_OES_framebuffer_object GL_OES_packed_depth_stencil "         \
     "GL_OES_point_sprite GL_OES_blend_subtract GL_OES_blend_equation_separate GL_OES_texture_mirrored_repeat "         \
-    "GL_OES_stencil_wrap"
+    "GL_OES_stencil_wrap GL_EXT_texture_compression_dxt1 GL_EXT_texture_compression_s3tc "                             \
+    "GL_OES_compressed_paletted_texture GL_OES_compressed_ETC1_RGB8_texture GL_OES_compressed_ETC1_RGB8_sub_texture "  \
+    "GL_OES_vertex_array_object GL_EXT_multi_draw_arrays GL_OES_draw_texture GL_OES_matrix_palette "                   \
+    "GL_OES_texture_cube_map GL_EXT_occlusion_query_boolean GL_EXT_disjoint_timer_query GL_NV_fence "                  \
+    "GL_NV2A_frame_counters"
+
+// NV2A samples S3TC blocks natively, so these are stored as-is without any transcoding.
+// ETC1 is transcoded to DXT1 and paletted textures are expanded during upload.
+#define GLI_COMPRESSED_TEXTURE_FORMATS                                                                                 \
+    GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,               \
+        GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_ETC1_RGB8_OES, GL_PALETTE4_RGB8_OES, GL_PALETTE4_RGBA8_OES,               \
+        GL_PALETTE4_R5_G6_B5_OES, GL_PALETTE4_RGBA4_OES, GL_PALETTE4_RGB5_A1_OES, GL_PALETTE8_RGB8_OES,                \
+        GL_PALETTE8_RGBA8_OES, GL_PALETTE8_R5_G6_B5_OES, GL_PALETTE8_RGBA4_OES, GL_PALETTE8_RGB5_A1_OES
+#define GLI_NUM_COMPRESSED_TEXTURE_FORMATS 15
 
 // For line and point sizes xbox takes a 6.3 fix point, total of 9 bits. Max = 0x1FF / 2^3 = 63.875f
 #define GLI_MAX_ALIASED_POINT_SIZE ((float)0x1FF / (float)(1 << 3))
@@ -42,6 +68,10 @@ typedef struct xgu_texture
     GLint bytes_per_pixel;
     GLint pitch;
     GLint swizzled;
+    GLint compressed; // Stored as 4x4 blocks, block_size bytes each. Addressed like a swizzled texture
+    GLint block_size;
+    GLint cube_map;   // Six square swizzled faces from +X to -Z, face_size bytes apart
+    GLuint face_size; // Each face is padded to a 128 byte boundary
     GLfloat u_scale;
     GLfloat v_scale;
     XguTexFormatColor format;
@@ -51,6 +81,7 @@ typedef struct xgu_texture
     GLubyte *data;
     GLubyte *data_physical_address;
     GLuint data_size;
+    GLubyte *backing; // Copy of data in normal RAM while evicted. data is NULL while this is set
     uint8_t mipmap_levels;
     struct xgu_texture *mipmap_head;
 } xgu_texture_t;
@@ -69,10 +100,12 @@ XguFrontFace gliEnumToNvFrontFace(GLenum mode);
 XguStencilOp gliEnumToNvStencilOp(GLenum op);
 XguShadeModel gliEnumToNvShadeModel(GLenum code);
 XguFogMode gliEnumToNvFogMode(GLenum mode);
+XguTexgen gliEnumToNvTexgen(GLenum mode);
 uint32_t gliFormatToNvSurfaceFormat(GLenum format);
 XguTextureAddress gliEnumToNvAddressMode(GLenum wrap);
 XguTexFilter gliEnumToNvTexFilter(GLenum filter);
 XguTexFormatColor gliEnumToNvTexFormat(GLenum format, GLenum type, GLuint *bytes_per_pixel, GLboolean swizzled);
+XguTexFormatColor gliEnumToNvCompressedTexFormat(GLenum internalformat, GLuint *block_size);
 DWORD gliColor4fToNvColor(uint32_t fmt_color, const GLfloat color[4]);
 DWORD gliDepthStencilToNvZeta(uint32_t fmt_zeta, GLfloat depth, uint32_t stencil);
 
@@ -0,0 +1,205 @@
+#define GL_GLEXT_PROTOTYPES
+#include <GLES/gl.h>
+#include <GLES/glext.h>
+#include <hal/video.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Call overhead microbenchmark for the hot entry points: array pointers, binds, current values, texture environment
+// and small draws. Each call is made CALLS_PER_FRAME times a frame over BENCH_FRAMES frames, with the empty loop taken
+// off, and the CPU cycles and nanoseconds per call are printed and appended to CALL_BENCH_CSV. Run it once against a
+// library built with NXDK_GLES11_NO_ERROR and once without to compare a GLI_NO_ERROR build with the validated one.
+
+#ifndef CALL_BENCH_CSV
+#define CALL_BENCH_CSV "D:\\call_bench.csv" // Appended to, so both builds can write to the same file
+#endif
+#ifdef CALL_BENCH_NO_ERROR
+#define BUILD_NAME "no_error"
+#else
+#define BUILD_NAME "validated"
+#endif
+#define TSC_FREQUENCY   733333333ULL
+#define CALLS_PER_FRAME 1000
+#define BENCH_FRAMES    32
+
+static const GLfloat vertices[] = {0.0f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f};
+static const GLushort indices[] = {0, 1, 2};
+static const GLfloat env_color[] = {0.25f, 0.5f, 0.75f, 1.0f};
+static GLuint textures[2];
+static GLuint buffers[2];
+
+static void call_nothing(GLuint i)
+{
+    (void)i;
+    __asm__ __volatile__("" ::: "memory");
+}
+
+static void call_vertex_pointer(GLuint i)
+{
+    (void)i;
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+}
+
+static void call_color_pointer(GLuint i)
+{
+    (void)i;
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, 0);
+}
+
+static void call_tex_coord_pointer(GLuint i)
+{
+    (void)i;
+    glTexCoordPointer(2, GL_FLOAT, 0, 0);
+}
+
+static void call_bind_texture(GLuint i)
+{
+    glBindTexture(GL_TEXTURE_2D, textures[i & 1]);
+}
+
+static void call_bind_buffer(GLuint i)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, (i & 1) ? buffers[0] : 0);
+}
+
+static void call_color4f(GLuint i)
+{
+    (void)i;
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+static void call_color4ub(GLuint i)
+{
+    (void)i;
+    glColor4ub(255, 255, 255, 255);
+}
+
+static void call_multi_tex_coord4f(GLuint i)
+{
+    (void)i;
+    glMultiTexCoord4f(GL_TEXTURE1, 0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+static void call_tex_envi(GLuint i)
+{
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, (i & 1) ? GL_MODULATE : GL_REPLACE);
+}
+
+static void call_tex_envfv(GLuint i)
+{
+    (void)i;
+    glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, env_color);
+}
+
+static void call_draw_arrays(GLuint i)
+{
+    (void)i;
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void call_draw_elements(GLuint i)
+{
+    (void)i;
+    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, 0);
+}
+
+static const struct
+{
+    const char *name;
+    void (*fn)(GLuint i);
+} calls[] = {
+    {"glVertexPointer", call_vertex_pointer},
+    {"glColorPointer", call_color_pointer},
+    {"glTexCoordPointer", call_tex_coord_pointer},
+    {"glBindTexture", call_bind_texture},
+    {"glBindBuffer", call_bind_buffer},
+    {"glColor4f", call_color4f},
+    {"glColor4ub", call_color4ub},
+    {"glMultiTexCoord4f", call_multi_tex_coord4f},
+    {"glTexEnvi", call_tex_envi},
+    {"glTexEnvfv", call_tex_envfv},
+    {"glDrawArrays", call_draw_arrays},
+    {"glDrawElements", call_draw_elements},
+};
+
+// CPU cycles spent in CALLS_PER_FRAME calls, least of BENCH_FRAMES frames. The flip in between keeps the push buffer
+// from filling up with draws and isn't timed
+static uint64_t time_call(void (*fn)(GLuint i))
+{
+    uint64_t best = UINT64_MAX;
+    for (GLuint frame = 0; frame < BENCH_FRAMES; frame++) {
+        const uint64_t start = __builtin_ia32_rdtsc();
+        for (GLuint i = 0; i < CALLS_PER_FRAME; i++) {
+            fn(i);
+        }
+        const uint64_t tsc = __builtin_ia32_rdtsc() - start;
+        best = (tsc < best) ? tsc : best;
+
+        // Put back the state the binds and texture environment calls toggle, so every frame starts the same
+        glBindTexture(GL_TEXTURE_2D, textures[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+        glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glFlipNV2A();
+    }
+    return best;
+}
+
+static void setup(void)
+{
+    static const GLubyte texels[2][4 * 4 * 4] = {{0}, {255}};
+
+    glGenTextures(2, textures);
+    for (GLuint i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 4, 4, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels[i]);
+    }
+    glEnable(GL_TEXTURE_2D);
+
+    // Vertices and indices come from buffer objects, so the draws measure the call rather than client array staging.
+    // The array pointer calls are given offsets into the same buffer
+    glGenBuffers(2, buffers);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glVertexPointer(3, GL_FLOAT, 0, 0);
+    glEnableClientState(GL_VERTEX_ARRAY);
+}
+
+int main(void)
+{
+    XVideoSetMode(640, 480, 32, REFRESH_DEFAULT);
+    glContextInit(640, 480);
+    setup();
+
+    FILE *csv = fopen(CALL_BENCH_CSV, "a");
+    if (csv != NULL) {
+        fseek(csv, 0, SEEK_END);
+        if (ftell(csv) == 0) {
+            fprintf(csv, "build,call,cycles,ns\n");
+        }
+    }
+    const uint64_t empty = time_call(call_nothing);
+
+    printf("call_bench: %s build, %u calls per frame\n", BUILD_NAME, CALLS_PER_FRAME);
+    printf("%-20s %8s %8s\n", "call", "cycles", "ns");
+    for (GLuint c = 0; c < sizeof(calls) / sizeof(calls[0]); c++) {
+        const uint64_t tsc = time_call(calls[c].fn);
+        const uint64_t call_tsc = (tsc > empty) ? tsc - empty : 0;
+        const unsigned cycles = (unsigned)(call_tsc / CALLS_PER_FRAME);
+        const unsigned ns = (unsigned)(call_tsc * 1000000000ULL / TSC_FREQUENCY / CALLS_PER_FRAME);
+        printf("%-20s %8u %8u\n", calls[c].name, cycles, ns);
+        if (csv != NULL) {
+            fprintf(csv, "%s,%s,%u,%u\n", BUILD_NAME, calls[c].name, cycles, ns);
+        }
+    }
+
+    if (glGetError() != GL_NO_ERROR) {
+        printf("call_bench: a call raised an error, the timings don't measure the valid path\n");
+    }
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#define GL_GLEXT_PROTOTYPES
+#include <GLES/gl.h>
+#include <GLES/glext.h>
+#include <hal/video.h>
+#include <pbkit/pbkit.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Regression check for texgen around glDrawTexOES. The quads turn texgen off on every unit, and it has to come back
+// for the next ordinary draw even when several quads are drawn in a row. A normal mapped triangle is drawn once on
+// its own as a reference, then again after two glDrawTexOES calls, and the pixels it covers in the back buffer are
+// compared. The quads are drawn in a corner away from the triangle so they don't touch the compared region.
+
+#define WIDTH  640
+#define HEIGHT 480
+
+// Screen rectangle the triangle below lands in
+#define REGION_X0 160
+#define REGION_X1 480
+#define REGION_Y0 120
+#define REGION_Y1 360
+
+static const GLfloat vertices[] = {0.0f, 0.5f, 0.0f, -0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f};
+static const GLfloat normals[] = {0.0f, 0.8f, 0.6f, -0.8f, -0.6f, 0.0f, 0.6f, -0.6f, 0.53f};
+static const GLint crop[] = {0, 0, 8, 8};
+
+static void setup(void)
+{
+    // A gradient rather than a flat colour, so wrong texture coordinates show up as different pixels
+    GLubyte texels[8 * 8 * 4];
+    for (GLuint i = 0; i < 8 * 8; i++) {
+        texels[i * 4 + 0] = (GLubyte)((i % 8) * 32);
+        texels[i * 4 + 1] = (GLubyte)((i / 8) * 32);
+        texels[i * 4 + 2] = (GLubyte)(255 - (i % 8) * 32);
+        texels[i * 4 + 3] = 255;
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_CROP_RECT_OES, crop);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 8, 8, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    glEnable(GL_TEXTURE_2D);
+
+    glTexGeniOES(GL_TEXTURE_GEN_STR_OES, GL_TEXTURE_GEN_MODE_OES, GL_NORMAL_MAP_OES);
+    glEnable(GL_TEXTURE_GEN_STR_OES);
+
+    glVertexPointer(3, GL_FLOAT, 0, vertices);
+    glNormalPointer(GL_FLOAT, 0, normals);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// Hash of the back buffer pixels the triangle covers, once the GPU has finished drawing them
+static uint32_t region_checksum(void)
+{
+    glFinish();
+    const uint32_t *pixels = (const uint32_t *)pb_back_buffer();
+    const GLuint stride = (GLuint)pb_back_buffer_pitch() / 4;
+    uint32_t sum = 0;
+    for (GLuint y = REGION_Y0; y < REGION_Y1; y++) {
+        for (GLuint x = REGION_X0; x < REGION_X1; x++) {
+            sum = sum * 31 + pixels[y * stride + x];
+        }
+    }
+    return sum;
+}
+
+int main(void)
+{
+    XVideoSetMode(WIDTH, HEIGHT, 32, REFRESH_DEFAULT);
+    glContextInit(WIDTH, HEIGHT);
+    setup();
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    const uint32_t reference = region_checksum();
+    glFlipNV2A();
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDrawTexiOES(WIDTH - 64, 0, 0, 32, 32);
+    glDrawTexiOES(WIDTH - 32, 0, 0, 32, 32);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    const uint32_t after_draw_texture = region_checksum();
+    glFlipNV2A();
+
+    const GLenum error = glGetError();
+    const int passed = after_draw_texture == reference && error == GL_NO_ERROR;
+    printf("draw_texture_texgen: %s (reference %08x, after glDrawTexOES %08x, error 0x%04x)\n",
+           passed ? "PASS" : "FAIL",
+           (unsigned)reference,
+           (unsigned)after_draw_texture,
+           (unsigned)error);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+#define GL_GLEXT_PROTOTYPES
+#include <GLES/gl.h>
+#include <GLES/glext.h>
+#include <hal/video.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl_capture_ids.h"
+#include "gles_capture.h"
+
+// Replays a capture made with glCaptureNV2A and reports the CPU time spent in GL calls and the push buffer words
+// written, per frame and over the whole capture. Replay the same capture against two builds of the library to compare
+// them. Needs the library built with NXDK_GLES11_WITH_REPLAY.
+
+#ifndef REPLAY_FILE
+#define REPLAY_FILE "D:\\capture.glc"
+#endif
+#ifndef REPLAY_CSV
+#define REPLAY_CSV "D:\\replay.csv" // Per frame results
+#endif
+#define TSC_FREQUENCY 733333333ULL
+#define MAX_SLOTS     16
+#define ARRAY_SLOTS   (GLI_CAPTURE_ARRAY_TEXCOORD0 + 4)
+
+typedef struct
+{
+    void *data;
+    size_t capacity;
+} replay_buffer_t;
+
+struct gli_replay
+{
+    FILE *stream;
+    GLboolean failed;
+    uint64_t call_start_tsc;
+    uint64_t call_tsc; // Time spent in the last call
+    uint64_t api_tsc;  // Time spent in calls this frame, not counting glFlipNV2A
+    replay_buffer_t payloads[MAX_SLOTS];
+    replay_buffer_t multi_indices;
+    replay_buffer_t multi_indices_data;
+    replay_buffer_t arrays[ARRAY_SLOTS];
+};
+
+static void *reserve(gli_replay_t *replay, replay_buffer_t *buffer, size_t size)
+{
+    if (size > buffer->capacity) {
+        void *data = realloc(buffer->data, size);
+        if (data == NULL) {
+            replay->failed = GL_TRUE;
+            return buffer->data;
+        }
+        buffer->data = data;
+        buffer->capacity = size;
+    }
+    return buffer->data;
+}
+
+void gliReplayRead(gli_replay_t *replay, void *data, uint32_t size)
+{
+    if (replay->failed || fread(data, 1, size, replay->stream) != size) {
+        replay->failed = GL_TRUE;
+        memset(data, 0, size);
+    }
+}
+
+static int32_t read_payload_size(gli_replay_t *replay)
+{
+    int32_t size;
+    gliReplayRead(replay, &size, sizeof(size));
+    return size;
+}
+
+const void *gliReplayPayload(gli_replay_t *replay, GLuint slot, const void *pointer)
+{
+    const int32_t size = read_payload_size(replay);
+    if (size == GLI_CAPTURE_NO_PAYLOAD) {
+        return pointer; // A buffer offset or NULL, valid as it is
+    }
+    void *data = reserve(replay, &replay->payloads[slot], size);
+    gliReplayRead(replay, data, size);
+    return replay->failed ? NULL : data;
+}
+
+const void *const *gliReplayMultiIndices(gli_replay_t *replay, GLuint slot)
+{
+    (void)slot;
+    int32_t n;
+    gliReplayRead(replay, &n, sizeof(n));
+    if (n <= 0 || replay->failed) {
+        return NULL;
+    }
+
+    // Read every draw's indices into one buffer, then point at them once it has stopped moving
+    const void **indices = reserve(replay, &replay->multi_indices, n * sizeof(void *));
+    size_t *offsets = malloc(n * sizeof(size_t));
+    size_t total = 0;
+    for (int32_t i = 0; i < n && !replay->failed; i++) {
+        gliReplayRead(replay, &indices[i], sizeof(indices[i]));
+        const int32_t size = read_payload_size(replay);
+        offsets[i] = (size == GLI_CAPTURE_NO_PAYLOAD) ? SIZE_MAX : total;
+        if (size > 0) {
+            uint8_t *data = reserve(replay, &replay->multi_indices_data, total + size);
+            gliReplayRead(replay, data + total, size);
+            total += size;
+        }
+    }
+    for (int32_t i = 0; i < n; i++) {
+        if (offsets[i] != SIZE_MAX) {
+            indices[i] = (const uint8_t *)replay->multi_indices_data.data + offsets[i];
+        }
+    }
+    free(offsets);
+    return replay->failed ? NULL : indices;
+}
+
+void *gliReplayScratch(gli_replay_t *replay, GLuint slot, size_t size)
+{
+    return reserve(replay, &replay->payloads[slot], size);
+}
+
+void gliReplayTimerStart(gli_replay_t *replay)
+{
+    replay->call_start_tsc = __builtin_ia32_rdtsc();
+}
+
+void gliReplayTimerStop(gli_replay_t *replay)
+{
+    replay->call_tsc = __builtin_ia32_rdtsc() - replay->call_start_tsc;
+    replay->api_tsc += replay->call_tsc;
+}
+
+// Point a client array at its recorded contents for the draw that follows
+static void replay_client_array(gli_replay_t *replay)
+{
+    gli_capture_array_t array;
+    gliReplayRead(replay, &array, sizeof(array));
+    if (replay->failed || array.slot >= ARRAY_SLOTS) {
+        replay->failed = GL_TRUE;
+        return;
+    }
+    void *data = reserve(replay, &replay->arrays[array.slot], array.bytes);
+    gliReplayRead(replay, data, array.bytes);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    switch (array.slot) {
+        case GLI_CAPTURE_ARRAY_VERTEX:
+            glVertexPointer(array.size, array.type, array.stride, data);
+            break;
+        case GLI_CAPTURE_ARRAY_NORMAL:
+            glNormalPointer(array.type, array.stride, data);
+            break;
+        case GLI_CAPTURE_ARRAY_COLOR:
+            glColorPointer(array.size, array.type, array.stride, data);
+            break;
+        case GLI_CAPTURE_ARRAY_POINT_SIZE:
+            glPointSizePointerOES(array.type, array.stride, data);
+            break;
+        case GLI_CAPTURE_ARRAY_MATRIX_INDEX:
+            glMatrixIndexPointerOES(array.size, array.type, array.stride, data);
+            break;
+        case GLI_CAPTURE_ARRAY_WEIGHT:
+            glWeightPointerOES(array.size, array.type, array.stride, data);
+            break;
+        default:
+            glClientActiveTexture(GL_TEXTURE0 + array.slot - GLI_CAPTURE_ARRAY_TEXCOORD0);
+            glTexCoordPointer(array.size, array.type, array.stride, data);
+            glClientActiveTexture(array.client_active_texture);
+            break;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, array.array_buffer_binding);
+}
+
+static unsigned microseconds(uint64_t tsc)
+{
+    return (unsigned)(tsc * 1000000ULL / TSC_FREQUENCY);
+}
+
+int main(void)
+{
+    static gli_replay_t replay;
+
+    replay.stream = fopen(REPLAY_FILE, "rb");
+    if (replay.stream == NULL) {
+        printf("gl_replay: could not open %s\n", REPLAY_FILE);
+        return 1;
+    }
+
+    gli_capture_header_t header;
+    gliReplayRead(&replay, &header, sizeof(header));
+    if (header.magic != GLI_CAPTURE_MAGIC || header.signature != GLI_CAPTURE_SIGNATURE) {
+        printf("gl_replay: %s is not a capture of this version of the library\n", REPLAY_FILE);
+        return 1;
+    }
+
+    XVideoSetMode(header.width, header.height, 32, REFRESH_DEFAULT);
+    glContextInit(header.width, header.height);
+
+    FILE *csv = fopen(REPLAY_CSV, "w");
+    if (csv != NULL) {
+        fprintf(csv, "frame,api_us,flip_us,pushbuffer_words\n");
+    }
+
+    GLuint frames = 0;
+    uint64_t total_api_tsc = 0;
+    uint64_t min_api_tsc = UINT64_MAX;
+    uint64_t max_api_tsc = 0;
+    uint64_t total_flip_tsc = 0;
+    uint64_t total_words = 0;
+
+    uint32_t id;
+    while (!replay.failed && fread(&id, sizeof(id), 1, replay.stream) == 1) {
+        if (id == GLI_CAPTURE_ID_CLIENT_ARRAY) {
+            replay_client_array(&replay);
+            continue;
+        }
+        if (!gliReplayCall(&replay, id)) {
+            printf("gl_replay: unknown call id %u\n", (unsigned)id);
+            break;
+        }
+        if (id != GLI_CAPTURE_ID_glFlipNV2A) {
+            continue;
+        }
+
+        // The flip waits for the GPU and vblank, so it is reported apart from the API time
+        const uint64_t flip_tsc = replay.call_tsc;
+        const uint64_t api_tsc = replay.api_tsc - flip_tsc;
+        GLint words = 0;
+        glGetIntegerv(GL_FRAME_PUSHBUFFER_WORDS_NV2A, &words);
+
+        total_api_tsc += api_tsc;
+        min_api_tsc = (api_tsc < min_api_tsc) ? api_tsc : min_api_tsc;
+        max_api_tsc = (api_tsc > max_api_tsc) ? api_tsc : max_api_tsc;
+        total_flip_tsc += flip_tsc;
+        total_words += (GLuint)words;
+        if (csv != NULL) {
+            fprintf(csv, "%u,%u,%u,%d\n", frames, microseconds(api_tsc), microseconds(flip_tsc), words);
+        }
+        frames++;
+        replay.api_tsc = 0;
+    }
+
+    if (replay.failed) {
+        printf("gl_replay: capture is truncated or out of memory after %u frames\n", frames);
+    }
+    if (frames > 0) {
+        printf("gl_replay: %u frames\n", frames);
+        printf("  API time us per frame: avg %u min %u max %u\n",
+               microseconds(total_api_tsc / frames),
+               microseconds(min_api_tsc),
+               microseconds(max_api_tsc));
+        printf("  Flip time us per frame: avg %u\n", microseconds(total_flip_tsc / frames));
+        printf("  Push buffer words per frame: avg %u, total %llu\n",
+               (unsigned)(total_words / frames),
+               (unsigned long long)total_words);
+    }
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    fclose(replay.stream);
+    return 0;
+}
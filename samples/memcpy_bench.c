@@ -0,0 +1,326 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xboxkrnl/xboxkrnl.h>
+#include <xmmintrin.h>
+
+// Microbenchmark for the library's gli_memcpy and gli_memset against libc and rep movs. Sweeps copy size, source and
+// destination misalignment, and the prefetch distance of the streaming loop, into cached and write-combined
+// destinations, after checking gli_memcpy copies correctly at every alignment. Prints a summary and writes every point
+// to MEMCPY_BENCH_CSV. Repeated copies of sizes that fit in L2 run from a warm cache, as staging and texture uploads
+// of recently written client data do.
+
+#ifndef MEMCPY_BENCH_CSV
+#define MEMCPY_BENCH_CSV "D:\\memcpy_bench.csv"
+#endif
+#define TSC_FREQUENCY 733333333ULL
+#define MIN_SIZE      16
+#define MAX_SIZE      (4 * 1024 * 1024)
+#define SIZE_BUDGET   (8 * 1024 * 1024) // Bytes copied per point of the size sweeps
+#define ALIGN_BUDGET  (1024 * 1024)     // Bytes copied per point of the alignment sweep
+
+void *gli_memcpy(void *dst, const void *src, size_t n);
+void *gli_memset(void *dst, int c, size_t n);
+
+typedef void *(*copy_fn_t)(void *dst, const void *src, size_t n);
+typedef void *(*set_fn_t)(void *dst, int c, size_t n);
+
+static void *rep_movs_copy(void *dst, const void *src, size_t n)
+{
+    void *d = dst;
+    size_t dwords = n >> 2;
+    size_t bytes = n & 3;
+    __asm__ __volatile__("rep movsl" : "+D"(d), "+S"(src), "+c"(dwords) : : "memory");
+    __asm__ __volatile__("rep movsb" : "+D"(d), "+S"(src), "+c"(bytes) : : "memory");
+    return dst;
+}
+
+// The 16 byte aligned streaming loop of gli_memcpy with the prefetch distance as a variable. 0 doesn't prefetch.
+// Prefetches both 32 byte lines of each 64 byte step, like gli_memcpy
+static size_t prefetch_distance;
+static void *prefetch_copy(void *dst, const void *src, size_t n)
+{
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    for (size_t n64 = n >> 6; n64 > 0; n64--) {
+        if (prefetch_distance != 0) {
+            _mm_prefetch((const char *)(s + prefetch_distance), _MM_HINT_NTA);
+            _mm_prefetch((const char *)(s + prefetch_distance + 32), _MM_HINT_NTA);
+        }
+        __m128 x0 = _mm_load_ps((const float *)s);
+        __m128 x1 = _mm_load_ps((const float *)(s + 16));
+        __m128 x2 = _mm_load_ps((const float *)(s + 32));
+        __m128 x3 = _mm_load_ps((const float *)(s + 48));
+        _mm_stream_ps((float *)d, x0);
+        _mm_stream_ps((float *)(d + 16), x1);
+        _mm_stream_ps((float *)(d + 32), x2);
+        _mm_stream_ps((float *)(d + 48), x3);
+        d += 64;
+        s += 64;
+    }
+    _mm_sfence();
+    memcpy(d, s, n & 63);
+    return dst;
+}
+
+static const struct
+{
+    const char *name;
+    copy_fn_t fn;
+} copies[] = {
+    {"gli_memcpy", gli_memcpy},
+    {"memcpy", memcpy},
+    {"rep movs", rep_movs_copy},
+};
+
+static const struct
+{
+    const char *name;
+    set_fn_t fn;
+} sets[] = {
+    {"gli_memset", gli_memset},
+    {"memset", memset},
+};
+
+typedef struct
+{
+    const char *name;
+    uint8_t *base;
+} destination_t;
+
+static FILE *csv;
+
+static size_t repetitions(size_t n, size_t budget)
+{
+    return (n < budget) ? budget / n : 1;
+}
+
+static unsigned megabytes_per_second(size_t n, uint64_t cycles)
+{
+    return (cycles > 0) ? (unsigned)((uint64_t)n * TSC_FREQUENCY / cycles / 1000000ULL) : 0;
+}
+
+static uint64_t time_copy(copy_fn_t fn, uint8_t *dst, const uint8_t *src, size_t n, size_t budget)
+{
+    const size_t reps = repetitions(n, budget);
+    fn(dst, src, n);
+    const uint64_t start = __builtin_ia32_rdtsc();
+    for (size_t i = 0; i < reps; i++) {
+        fn(dst, src, n);
+    }
+    return (__builtin_ia32_rdtsc() - start) / reps;
+}
+
+static uint64_t time_set(set_fn_t fn, uint8_t *dst, size_t n, size_t budget)
+{
+    const size_t reps = repetitions(n, budget);
+    fn(dst, 0x5A, n);
+    const uint64_t start = __builtin_ia32_rdtsc();
+    for (size_t i = 0; i < reps; i++) {
+        fn(dst, 0x5A, n);
+    }
+    return (__builtin_ia32_rdtsc() - start) / reps;
+}
+
+static void record(const char *test,
+                   const char *impl,
+                   const destination_t *dest,
+                   size_t n,
+                   unsigned src_offset,
+                   unsigned dst_offset,
+                   unsigned prefetch,
+                   unsigned mb_s)
+{
+    if (csv != NULL) {
+        fprintf(csv,
+                "%s,%s,%s,%u,%u,%u,%u,%u\n",
+                test,
+                impl,
+                dest->name,
+                (unsigned)n,
+                src_offset,
+                dst_offset,
+                prefetch,
+                mb_s);
+    }
+}
+
+// Aligned copies of every power of two size. Prints the fastest implementation for each, to place dispatch thresholds
+static void size_sweep(const destination_t *dest, const uint8_t *src)
+{
+    printf("copy into %s memory, MB/s\n%8s", dest->name, "size");
+    for (size_t i = 0; i < sizeof(copies) / sizeof(copies[0]); i++) {
+        printf(" %11s", copies[i].name);
+    }
+    printf("  fastest\n");
+
+    for (size_t n = MIN_SIZE; n <= MAX_SIZE; n *= 2) {
+        unsigned best = 0;
+        const char *best_name = "";
+        printf("%8u", (unsigned)n);
+        for (size_t i = 0; i < sizeof(copies) / sizeof(copies[0]); i++) {
+            const unsigned mb_s = megabytes_per_second(n, time_copy(copies[i].fn, dest->base, src, n, SIZE_BUDGET));
+            record("size", copies[i].name, dest, n, 0, 0, 0, mb_s);
+            printf(" %11u", mb_s);
+            if (mb_s > best) {
+                best = mb_s;
+                best_name = copies[i].name;
+            }
+        }
+        printf("  %s\n", best_name);
+    }
+}
+
+// Every source and destination offset within 16 bytes, for a small, medium and large copy. Prints the worst pair
+static void alignment_sweep(const destination_t *dest, const uint8_t *src)
+{
+    static const size_t sizes[] = {256, 4096, 65536};
+
+    for (size_t i = 0; i < sizeof(copies) / sizeof(copies[0]); i++) {
+        for (size_t j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+            unsigned worst = UINT32_MAX;
+            unsigned worst_src = 0;
+            unsigned worst_dst = 0;
+            unsigned aligned = 0;
+            for (unsigned s = 0; s < 16; s++) {
+                for (unsigned d = 0; d < 16; d++) {
+                    const uint64_t cycles = time_copy(copies[i].fn, dest->base + d, src + s, sizes[j], ALIGN_BUDGET);
+                    const unsigned mb_s = megabytes_per_second(sizes[j], cycles);
+                    record("alignment", copies[i].name, dest, sizes[j], s, d, 0, mb_s);
+                    if (s == 0 && d == 0) {
+                        aligned = mb_s;
+                    }
+                    if (mb_s < worst) {
+                        worst = mb_s;
+                        worst_src = s;
+                        worst_dst = d;
+                    }
+                }
+            }
+            printf("%-10s %s %6u B: aligned %5u MB/s, worst %5u MB/s at src +%u dst +%u\n",
+                   copies[i].name,
+                   dest->name,
+                   (unsigned)sizes[j],
+                   aligned,
+                   worst,
+                   worst_src,
+                   worst_dst);
+        }
+    }
+}
+
+static void prefetch_sweep(const destination_t *dest, const uint8_t *src)
+{
+    static const unsigned distances[] = {0, 32, 64, 128, 256, 512, 1024};
+
+    printf("streaming copy into %s memory by prefetch distance, MB/s\n%8s", dest->name, "size");
+    for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+        printf(" %6u", distances[i]);
+    }
+    printf("\n");
+
+    for (size_t n = 4096; n <= MAX_SIZE; n *= 4) {
+        printf("%8u", (unsigned)n);
+        for (size_t i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+            prefetch_distance = distances[i];
+            const unsigned mb_s = megabytes_per_second(n, time_copy(prefetch_copy, dest->base, src, n, SIZE_BUDGET));
+            record("prefetch", "streaming", dest, n, 0, 0, distances[i], mb_s);
+            printf(" %6u", mb_s);
+        }
+        printf("\n");
+    }
+}
+
+static void set_sweep(const destination_t *dest)
+{
+    printf("set %s memory, MB/s\n%8s", dest->name, "size");
+    for (size_t i = 0; i < sizeof(sets) / sizeof(sets[0]); i++) {
+        printf(" %11s", sets[i].name);
+    }
+    printf("\n");
+
+    for (size_t n = MIN_SIZE; n <= MAX_SIZE; n *= 2) {
+        printf("%8u", (unsigned)n);
+        for (size_t i = 0; i < sizeof(sets) / sizeof(sets[0]); i++) {
+            const unsigned mb_s = megabytes_per_second(n, time_set(sets[i].fn, dest->base, n, SIZE_BUDGET));
+            record("set", sets[i].name, dest, n, 0, 0, 0, mb_s);
+            printf(" %11u", mb_s);
+        }
+        printf("\n");
+    }
+}
+
+// Check gli_memcpy against memcpy for every source and destination offset within 16 bytes, at every size up to a few
+// steps of the streaming loop and some larger ones, including that nothing around the destination is touched
+static unsigned verify(uint8_t *dst, uint8_t *expected, const uint8_t *src)
+{
+    static const size_t large_sizes[] = {511, 512, 513, 4095, 4096, 4097, 65535};
+    unsigned failures = 0;
+
+    for (size_t k = 0; k < 300 + sizeof(large_sizes) / sizeof(large_sizes[0]); k++) {
+        const size_t n = (k < 300) ? k : large_sizes[k - 300];
+        for (unsigned s = 0; s < 16; s++) {
+            for (unsigned d = 0; d < 16; d++) {
+                memset(dst, 0xEE, n + 64);
+                memset(expected, 0xEE, n + 64);
+                memcpy(expected + d, src + s, n);
+                if (gli_memcpy(dst + d, src + s, n) != dst + d || memcmp(dst, expected, n + 64) != 0) {
+                    if (failures++ < 8) {
+                        printf("gli_memcpy wrong for %u bytes at src +%u dst +%u\n", (unsigned)n, s, d);
+                    }
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+int main(void)
+{
+    // Room for the largest copy plus the misalignment offsets
+    const size_t buffer_size = MAX_SIZE + 64;
+    uint8_t *src = MmAllocateContiguousMemoryEx(buffer_size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE);
+    uint8_t *cached = MmAllocateContiguousMemoryEx(buffer_size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE);
+    uint8_t *write_combined =
+        MmAllocateContiguousMemoryEx(buffer_size, 0, 0xFFFFFFFF, 0x1000, PAGE_READWRITE | PAGE_WRITECOMBINE);
+    if (src == NULL || cached == NULL || write_combined == NULL) {
+        printf("memcpy_bench: out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < buffer_size; i++) {
+        src[i] = (uint8_t)i;
+    }
+
+    uint8_t *expected = malloc(buffer_size);
+    if (expected == NULL || verify(cached, expected, src) != 0) {
+        printf("memcpy_bench: gli_memcpy failed verification\n");
+        return 1;
+    }
+    free(expected);
+
+    const destination_t destinations[] = {
+        {"cached", cached},
+        {"write-combined", write_combined},
+    };
+
+    csv = fopen(MEMCPY_BENCH_CSV, "w");
+    if (csv != NULL) {
+        fprintf(csv, "test,impl,destination,size,src_offset,dst_offset,prefetch,mb_s\n");
+    }
+
+    for (size_t i = 0; i < sizeof(destinations) / sizeof(destinations[0]); i++) {
+        size_sweep(&destinations[i], src);
+        alignment_sweep(&destinations[i], src);
+        prefetch_sweep(&destinations[i], src);
+        set_sweep(&destinations[i]);
+    }
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    MmFreeContiguousMemory(write_combined);
+    MmFreeContiguousMemory(cached);
+    MmFreeContiguousMemory(src);
+    return 0;
+}
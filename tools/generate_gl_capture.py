@@ -0,0 +1,226 @@
+import os
+import re
+import sys
+import zlib
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from generate_gl4es_shim import get_implemented_funcs
+
+# Generates the GL call capture layer and the replay dispatch for it, see gles_capture.h.
+#   gl_capture_prefix.h   Renames the entry points to gli_capture_real_*, included by GLES/gl.h under GLI_CAPTURE
+#   gl_capture_ids.h      Entry point ids used in the capture stream
+#   gl_capture.c          The wrappers the application calls. Each records the call, then runs the implementation
+#   gl_replay_dispatch.c  gliReplayCall, which reads a recorded call back and makes it
+#
+# usage: generate_gl_capture.py <src_dir> <gles_include_dir> <out_dir> [symbol_prefix]
+# symbol_prefix is the prefix gl_prefix.h gives the entry points in a gl4es build (nxdk_)
+
+# Vendor entry points that aren't declared with GL_API but matter to a replay
+EXTRA_FUNCS = [
+    ('void', 'glFlipNV2A', 'void'),
+    ('void', 'glSwapInterval', 'int interval'),
+    ('void', 'glFramesInFlightNV2A', 'int frames'),
+]
+
+# Bytes behind pointer arguments whose size isn't given by the generic rules in pointer_rule
+PAYLOAD_SIZES = {
+    ('glBufferData', 'data'): 'size',
+    ('glBufferSubData', 'data'): 'size',
+    ('glClipPlanef', 'eqn'): '4 * sizeof(*eqn)',
+    ('glClipPlanex', 'equation'): '4 * sizeof(*equation)',
+    ('glCompressedTexImage2D', 'data'): 'imageSize',
+    ('glCompressedTexSubImage2D', 'data'): 'imageSize',
+    ('glDrawElements', 'indices'): 'gliCaptureIndicesSize(count, type)',
+    ('glDrawTexfvOES', 'coords'): '5 * sizeof(*coords)',
+    ('glDrawTexivOES', 'coords'): '5 * sizeof(*coords)',
+    ('glDrawTexsvOES', 'coords'): '5 * sizeof(*coords)',
+    ('glDrawTexxvOES', 'coords'): '5 * sizeof(*coords)',
+    ('glLoadMatrixf', 'm'): '16 * sizeof(*m)',
+    ('glLoadMatrixx', 'm'): '16 * sizeof(*m)',
+    ('glMultMatrixf', 'm'): '16 * sizeof(*m)',
+    ('glMultMatrixx', 'm'): '16 * sizeof(*m)',
+    ('glMultiDrawArraysEXT', 'first'): 'primcount * sizeof(*first)',
+    ('glMultiDrawArraysEXT', 'count'): 'primcount * sizeof(*count)',
+    ('glMultiDrawElementsEXT', 'count'): 'primcount * sizeof(*count)',
+    ('glMultiDrawElementsEXT', 'indices'): None,  # Written by gliCaptureMultiIndices
+    ('glTexImage2D', 'pixels'): 'gliCaptureImageSize(width, height, format, type)',
+    ('glTexSubImage2D', 'pixels'): 'gliCaptureImageSize(width, height, format, type)',
+}
+
+# Scratch memory the replay passes for pointers the call writes to. Others get n or 16 elements
+OUT_SIZES = {
+    ('glReadPixels', 'pixels'): '(size_t)width * height * 4',
+}
+
+# Draws read client arrays, which are recorded ahead of the call
+DRAW_HOOKS = {
+    'glDrawArrays': 'gliCaptureDrawArrays(first, count)',
+    'glDrawElements': 'gliCaptureDrawElements(count, type, indices)',
+    'glMultiDrawArraysEXT': 'gliCaptureMultiDrawArrays(first, count, primcount)',
+    'glMultiDrawElementsEXT': 'gliCaptureMultiDrawElements(count, type, indices, primcount)',
+}
+
+
+def get_prototypes(gl_dir):
+    protos = {}
+    for header in ('gl.h', 'glext.h'):
+        with open(os.path.join(gl_dir, header), 'r') as f:
+            data = f.read()
+        for m in re.finditer(r'GL_API\s+([\w\s\*]+?)\s*GL_APIENTRY\s+(gl\w+)\s*\(([^)]*)\)\s*;', data):
+            protos.setdefault(m.group(2), (' '.join(m.group(1).split()), m.group(3)))
+    return protos
+
+
+def parse_params(params):
+    params = ' '.join(params.split())
+    if params in ('', 'void'):
+        return []
+    parsed = []
+    for param in params.split(','):
+        m = re.match(r'^(.*?)\s*(\w+)$', param.strip())
+        parsed.append((re.sub(r'\s*\*', ' *', m.group(1)).strip(), m.group(2)))
+    return parsed
+
+
+# Returns (kind, size expression) for a pointer argument: 'raw', 'payload', 'multi_indices' or 'out'
+def pointer_rule(func, ptype, pname, names):
+    if func.endswith('Pointer') or func.endswith('PointerOES'):
+        return ('raw', None)  # An offset, or a client array recorded at the next draw
+    if (func, pname) in PAYLOAD_SIZES:
+        size = PAYLOAD_SIZES[(func, pname)]
+        return ('multi_indices', None) if size is None else ('payload', size)
+    if ptype.startswith('const'):
+        if 'pname' in names:
+            return ('payload', f'gliCaptureParamCount(pname) * sizeof(*{pname})')
+        if 'n' in names:
+            return ('payload', f'n * sizeof(*{pname})')
+        raise SystemExit(f'generate_gl_capture.py: no payload size for {func} {pname}, add it to PAYLOAD_SIZES')
+    if (func, pname) in OUT_SIZES:
+        return ('out', OUT_SIZES[(func, pname)])
+    if 'n' in names:
+        return ('out', f'n * sizeof(*{pname})')
+    return ('out', f'16 * sizeof(*{pname})')
+
+
+def param_decl(ptype, pname):
+    return f'{ptype}{pname}' if ptype.endswith('*') else f'{ptype} {pname}'
+
+
+def declaration(ret, name, params, apientry):
+    args = ', '.join(param_decl(t, n) for t, n in params) or 'void'
+    if apientry:
+        return f'GL_API {ret} GL_APIENTRY {name}({args})'
+    return f'{ret} {name}({args})'
+
+
+def main():
+    src_dir = sys.argv[1]
+    gl_dir = sys.argv[2]
+    out_dir = sys.argv[3]
+    symbol_prefix = sys.argv[4] if len(sys.argv) > 4 else ''
+
+    protos = get_prototypes(gl_dir)
+    funcs = []
+    for func in sorted(get_implemented_funcs(src_dir)):
+        ret, params = protos[func]
+        funcs.append((ret, func, parse_params(params), True))
+    for ret, func, params in EXTRA_FUNCS:
+        funcs.append((ret, func, parse_params(params), False))
+
+    signature = zlib.crc32(' '.join(f[1] for f in funcs).encode()) & 0xFFFFFFFF
+
+    with open(os.path.join(out_dir, 'gl_capture_prefix.h'), 'w') as f:
+        f.write("#ifndef NXDK_GL_CAPTURE_PREFIX_H\n")
+        f.write("#define NXDK_GL_CAPTURE_PREFIX_H\n\n")
+        for ret, func, params, apientry in funcs:
+            prefix = symbol_prefix if apientry else ''
+            f.write(f"#define {prefix}{func} gli_capture_real_{func}\n")
+        f.write("\n#endif\n")
+
+    with open(os.path.join(out_dir, 'gl_capture_ids.h'), 'w') as f:
+        f.write("#pragma once\n\n")
+        f.write(f"#define GLI_CAPTURE_SIGNATURE 0x{signature:08X}\n\n")
+        f.write("enum\n{\n")
+        for ret, func, params, apientry in funcs:
+            f.write(f"    GLI_CAPTURE_ID_{func},\n")
+        f.write("    GLI_CAPTURE_ID_COUNT\n")
+        f.write("};\n")
+
+    with open(os.path.join(out_dir, 'gl_capture.c'), 'w') as f:
+        f.write("#define GL_GLEXT_PROTOTYPES\n")
+        f.write("#include <GLES/gl.h>\n")
+        f.write("#include <GLES/glext.h>\n")
+        f.write('#include "gl_capture_ids.h"\n')
+        f.write('#include "gles_capture.h"\n\n')
+        for ret, func, params, apientry in funcs:
+            f.write(declaration(ret, f'gli_capture_real_{func}', params, apientry) + ";\n")
+        f.write("\n")
+        for ret, func, params, apientry in funcs:
+            names = [n for t, n in params]
+            f.write(declaration(ret, func, params, apientry) + "\n{\n")
+            if func in DRAW_HOOKS:
+                f.write(f"    {DRAW_HOOKS[func]};\n")
+            f.write(f"    if (gliCaptureBegin(GLI_CAPTURE_ID_{func})) {{\n")
+            multi_indices = None
+            for ptype, pname in params:
+                f.write(f"        gliCaptureWrite(&{pname}, sizeof({pname}));\n")
+                if '*' not in ptype:
+                    continue
+                kind, size = pointer_rule(func, ptype, pname, names)
+                if kind == 'payload':
+                    f.write(f"        gliCapturePayload({pname}, {size});\n")
+                elif kind == 'multi_indices':
+                    multi_indices = pname
+            if multi_indices:
+                f.write(f"        gliCaptureMultiIndices(count, type, {multi_indices}, primcount);\n")
+            f.write("    }\n")
+            call = f"gli_capture_real_{func}({', '.join(names)})"
+            if ret == 'void':
+                f.write(f"    {call};\n")
+                if func == 'glFlipNV2A':
+                    f.write("    gliCaptureFlush();\n")
+            else:
+                f.write(f"    return {call};\n")
+            f.write("}\n\n")
+
+    with open(os.path.join(out_dir, 'gl_replay_dispatch.c'), 'w') as f:
+        f.write("#define GL_GLEXT_PROTOTYPES\n")
+        f.write("#include <GLES/gl.h>\n")
+        f.write("#include <GLES/glext.h>\n")
+        f.write("#include <stddef.h>\n")
+        f.write('#include "gl_capture_ids.h"\n')
+        f.write('#include "gles_capture.h"\n\n')
+        f.write("GLboolean gliReplayCall(gli_replay_t *replay, uint32_t call_id)\n{\n")
+        f.write("    switch (call_id) {\n")
+        for ret, func, params, apientry in funcs:
+            names = [n for t, n in params]
+            f.write(f"        case GLI_CAPTURE_ID_{func}: {{\n")
+            for ptype, pname in params:
+                f.write(f"            {param_decl(ptype, pname)};\n")
+            multi_indices = None
+            for slot, (ptype, pname) in enumerate(params):
+                f.write(f"            gliReplayRead(replay, &{pname}, sizeof({pname}));\n")
+                if '*' not in ptype:
+                    continue
+                kind, size = pointer_rule(func, ptype, pname, names)
+                if kind == 'payload':
+                    f.write(f"            {pname} = gliReplayPayload(replay, {slot}, {pname});\n")
+                elif kind == 'multi_indices':
+                    multi_indices = (slot, pname)
+                elif kind == 'out':
+                    f.write(f"            {pname} = gliReplayScratch(replay, {slot}, {size});\n")
+            if multi_indices:
+                f.write(f"            {multi_indices[1]} = gliReplayMultiIndices(replay, {multi_indices[0]});\n")
+            f.write("            gliReplayTimerStart(replay);\n")
+            f.write(f"            {func}({', '.join(names)});\n")
+            f.write("            gliReplayTimerStop(replay);\n")
+            f.write("            return GL_TRUE;\n")
+            f.write("        }\n")
+        f.write("        default:\n")
+        f.write("            return GL_FALSE;\n")
+        f.write("    }\n")
+        f.write("}\n")
+
+
+if __name__ == '__main__':
+    main()